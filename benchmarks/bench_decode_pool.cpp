@@ -0,0 +1,138 @@
+// Planar decode throughput through WorkerPool, by worker count.
+//
+// The workload is a 1920x1080 desktop cut into 256x256 tiles (the update
+// size Windows servers typically use), encoded once with FreeRDP's planar
+// encoder. Each pass decodes every tile into one shared surface, as
+// GfxPipeline does, and waits for the pool to drain.
+//
+//   bench_decode_pool [passes] [max_workers]
+
+#include "util/worker_pool.hpp"
+
+#include <freerdp/codec/color.h>
+#include <freerdp/codec/planar.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace gvrdp;
+
+namespace {
+
+constexpr uint32_t kWidth = 1920;
+constexpr uint32_t kHeight = 1080;
+constexpr uint32_t kTile = 256;
+
+struct Tile {
+    uint32_t x, y, width, height;
+    std::vector<uint8_t> data;
+};
+
+using PlanarContext = std::unique_ptr<BITMAP_PLANAR_CONTEXT,
+                                      decltype(&freerdp_bitmap_planar_context_free)>;
+
+// Window-like content: flat panels, gradients and some noisy "text" rows,
+// so RLE gets the same mix of runs and literals as a real desktop.
+std::vector<uint8_t> make_desktop() {
+    std::vector<uint8_t> pixels(static_cast<size_t>(kWidth) * kHeight * 4);
+    uint32_t seed = 12345;
+    for (uint32_t y = 0; y < kHeight; y++) {
+        for (uint32_t x = 0; x < kWidth; x++) {
+            uint8_t* p = &pixels[(static_cast<size_t>(y) * kWidth + x) * 4];
+            uint32_t panel = (x / 320 + y / 270) % 3;
+            seed = seed * 1103515245u + 12345u;
+            bool text = panel == 1 && (y % 16) < 10 && (seed >> 16) % 3 == 0;
+            p[0] = static_cast<uint8_t>(text ? 0 : panel == 2 ? x : 0xF0);
+            p[1] = static_cast<uint8_t>(text ? 0 : panel == 2 ? y : 0xF0);
+            p[2] = static_cast<uint8_t>(text ? 0 : 0xF0);
+            p[3] = 0xFF;
+        }
+    }
+    return pixels;
+}
+
+std::vector<Tile> encode_tiles(const std::vector<uint8_t>& desktop) {
+    PlanarContext encoder(freerdp_bitmap_planar_context_new(PLANAR_FORMAT_HEADER_RLE, kTile, kTile),
+                          freerdp_bitmap_planar_context_free);
+    std::vector<Tile> tiles;
+    for (uint32_t y = 0; y < kHeight; y += kTile) {
+        for (uint32_t x = 0; x < kWidth; x += kTile) {
+            Tile tile{x, y, std::min(kTile, kWidth - x), std::min(kTile, kHeight - y), {}};
+            freerdp_bitmap_planar_context_reset(encoder.get(), tile.width, tile.height);
+            UINT32 size = 0;
+            const BYTE* src = &desktop[(static_cast<size_t>(y) * kWidth + x) * 4];
+            BYTE* out = freerdp_bitmap_planar_compress(encoder.get(), src, PIXEL_FORMAT_BGRA32,
+                                                       tile.width, tile.height, kWidth * 4,
+                                                       nullptr, &size);
+            if (!out) {
+                std::fprintf(stderr, "planar encode failed\n");
+                std::exit(1);
+            }
+            tile.data.assign(out, out + size);
+            free(out);
+            tiles.push_back(std::move(tile));
+        }
+    }
+    return tiles;
+}
+
+void decode(const Tile& tile, uint8_t* surface) {
+    thread_local PlanarContext planar(nullptr, freerdp_bitmap_planar_context_free);
+    if (!planar) planar.reset(freerdp_bitmap_planar_context_new(0, kTile, kTile));
+    freerdp_bitmap_planar_context_reset(planar.get(), tile.width, tile.height);
+    planar_decompress(planar.get(), tile.data.data(), static_cast<UINT32>(tile.data.size()),
+                      tile.width, tile.height, surface, PIXEL_FORMAT_BGRA32, kWidth * 4, tile.x,
+                      tile.y, tile.width, tile.height, FALSE);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int passes = argc > 1 ? std::atoi(argv[1]) : 200;
+    size_t max_workers = argc > 2 ? static_cast<size_t>(std::atoi(argv[2]))
+                                  : std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<Tile> tiles = encode_tiles(make_desktop());
+    size_t encoded = 0;
+    for (const auto& tile : tiles) encoded += tile.data.size();
+    std::printf("%zu tiles, %.1f KiB planar per frame, %d passes\n", tiles.size(),
+                static_cast<double>(encoded) / 1024.0, passes);
+
+    std::vector<uint8_t> surface(static_cast<size_t>(kWidth) * kHeight * 4);
+    double baseline = 0.0;
+    std::printf("%8s %12s %10s %8s\n", "workers", "frames/s", "MPix/s", "speedup");
+
+    for (size_t workers = 0; workers <= max_workers; workers = workers == 0 ? 2 : workers * 2) {
+        // workers == 0: inline on the calling thread, as with decode_threads = 1
+        std::unique_ptr<WorkerPool> pool;
+        if (workers > 0) pool = std::make_unique<WorkerPool>(workers);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < passes; pass++) {
+            for (const auto& tile : tiles) {
+                if (pool) {
+                    pool->submit([&tile, &surface] { decode(tile, surface.data()); });
+                } else {
+                    decode(tile, surface.data());
+                }
+            }
+            if (pool) pool->wait_idle();
+        }
+        double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        double fps = passes / seconds;
+        double mpix = fps * kWidth * kHeight / 1e6;
+        if (workers == 0) baseline = fps;
+        std::printf("%8zu %12.1f %10.1f %7.2fx\n", workers == 0 ? 1 : workers, fps, mpix,
+                    fps / baseline);
+        if (workers == 0 && max_workers < 2) break;
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+// Input enqueue latency: SpscRing vs. the mutex-guarded queue it replaced.
+//
+// The main thread only enqueues; a consumer thread drains, like the RDP
+// thread does. Each enqueue is timed on its own, paced at roughly the rate
+// of a fast mouse, and the latency percentiles are printed. With the mutex
+// the producer waits whenever the consumer holds the lock; with the ring it
+// never waits unless the ring is full.
+//
+//   bench_input_ring [events]
+
+#include "util/spsc_ring.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace gvrdp;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+volatile uint64_t g_sink;  // Keeps the consumer's work from being optimized out
+
+struct Event {
+    uint16_t flags;
+    uint16_t x;
+    uint16_t y;
+};
+
+// Simulated PDU encoding on the consumer side
+void consume(const Event& event, uint64_t& sink) {
+    for (int i = 0; i < 200; i++) {
+        sink = sink * 31 + event.x + event.y + event.flags;
+    }
+}
+
+class MutexQueue {
+public:
+    bool push(const Event& event) {
+        std::lock_guard lock(mutex_);
+        queue_.push_back(event);
+        return true;
+    }
+    // Holds the lock while consuming, as send_mutex_ was held while encoding
+    bool drain(uint64_t& sink) {
+        std::lock_guard lock(mutex_);
+        if (queue_.empty()) return false;
+        while (!queue_.empty()) {
+            consume(queue_.front(), sink);
+            queue_.pop_front();
+        }
+        return true;
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<Event> queue_;
+};
+
+class RingQueue {
+public:
+    bool push(const Event& event) { return ring_.push(event); }
+    bool drain(uint64_t& sink) {
+        bool any = false;
+        while (auto event = ring_.pop()) {
+            consume(*event, sink);
+            any = true;
+        }
+        return any;
+    }
+
+private:
+    SpscRing<Event, 1024> ring_;
+};
+
+template <typename Queue>
+std::vector<double> run(size_t events) {
+    Queue queue;
+    std::atomic<bool> done{false};
+    uint64_t sink = 0;
+    std::thread consumer([&] {
+        while (!done.load(std::memory_order_acquire)) {
+            if (!queue.drain(sink)) std::this_thread::yield();
+        }
+        queue.drain(sink);
+    });
+
+    std::vector<double> latencies;
+    latencies.reserve(events);
+    for (size_t i = 0; i < events; i++) {
+        Event event{0x0800, static_cast<uint16_t>(i % 1920), static_cast<uint16_t>(i % 1080)};
+        auto start = Clock::now();
+        while (!queue.push(event)) {
+            std::this_thread::yield();
+        }
+        auto end = Clock::now();
+        latencies.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+
+        // ~4 us between events
+        while (Clock::now() - end < std::chrono::microseconds(4)) {
+        }
+    }
+    done.store(true, std::memory_order_release);
+    consumer.join();
+    g_sink = sink;
+    std::sort(latencies.begin(), latencies.end());
+    return latencies;
+}
+
+void report(const char* name, const std::vector<double>& sorted) {
+    auto at = [&](double q) {
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(q * sorted.size()))];
+    };
+    std::printf("%-12s %8.0f %8.0f %8.0f %8.0f %10.0f\n", name, at(0.5), at(0.9), at(0.99),
+                at(0.999), sorted.back());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    size_t events = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 200000;
+    if (events == 0) return 1;
+
+    std::printf("%zu events, enqueue latency in ns\n", events);
+    std::printf("%-12s %8s %8s %8s %8s %10s\n", "queue", "p50", "p90", "p99", "p99.9", "max");
+    report("mutex+deque", run<MutexQueue>(events));
+    report("spsc ring", run<RingQueue>(events));
+    return 0;
+}
@@ -0,0 +1,214 @@
+// Desktop texture cost at 4K and 8K: one texture of the desktop's size (the
+// path SdlRenderer used before TiledTexture) vs. 512x512 tiles.
+//
+// For each desktop size and path it times, as the median of several passes:
+//   resize  growing the desktop by 64 px (a drag-resize step) and back
+//   full    uploading the whole desktop (after connect or resize)
+//   damage  uploading 64 scattered 128x64 rects (typing, a ticking clock)
+//   fit     drawing the desktop scaled into the 1920x1080 output
+//   crop    drawing it 1:1, where most of it is off the output
+// Every step ends with a 1-pixel SDL_RenderReadPixels, so GPU work is
+// included rather than just queued. A single texture past the renderer's
+// maximum texture size cannot be created; that row reads "unsupported".
+//
+//   bench_tiled_texture [passes]
+
+#include "render/tiled_texture.hpp"
+
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+using namespace gvrdp;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kOutputWidth = 1920;
+constexpr int kOutputHeight = 1080;
+constexpr uint32_t kGrow = 64;
+
+struct Size {
+    const char* name;
+    uint32_t width;
+    uint32_t height;
+};
+
+// Waits for the GPU by reading a pixel back
+void sync(SDL_Renderer* renderer) {
+    SDL_Rect pixel = {0, 0, 1, 1};
+    uint32_t value = 0;
+    SDL_RenderReadPixels(renderer, &pixel, SDL_PIXELFORMAT_ARGB8888, &value, 4);
+}
+
+// Median milliseconds of `passes` runs of `step`
+double time_ms(SDL_Renderer* renderer, int passes, const std::function<void()>& step) {
+    std::vector<double> times;
+    for (int i = 0; i < passes; i++) {
+        sync(renderer);
+        auto start = Clock::now();
+        step();
+        sync(renderer);
+        times.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+std::vector<Rect> damage_rects(uint32_t width, uint32_t height) {
+    std::vector<Rect> rects;
+    uint32_t seed = 12345;
+    for (int i = 0; i < 64; i++) {
+        seed = seed * 1103515245 + 12345;
+        uint32_t x = (seed >> 8) % (width - 128);
+        seed = seed * 1103515245 + 12345;
+        uint32_t y = (seed >> 8) % (height - 64);
+        rects.push_back({x, y, 128, 64});
+    }
+    return rects;
+}
+
+// The interface both paths are timed through
+struct DesktopTexture {
+    virtual ~DesktopTexture() = default;
+    virtual bool resize(uint32_t width, uint32_t height) = 0;
+    virtual void upload(const uint8_t* buffer, uint32_t stride, const Rect& rect) = 0;
+    virtual void render(const SDL_Rect& area) = 0;
+};
+
+class SingleTexture : public DesktopTexture {
+public:
+    SingleTexture(SDL_Renderer* renderer, uint32_t format)
+        : renderer_(renderer), format_(format) {}
+    ~SingleTexture() override {
+        if (texture_) SDL_DestroyTexture(texture_);
+    }
+
+    // Recreated on every resize, as SdlRenderer::resize_texture() did
+    bool resize(uint32_t width, uint32_t height) override {
+        if (texture_) SDL_DestroyTexture(texture_);
+        texture_ = SDL_CreateTexture(renderer_, format_, SDL_TEXTUREACCESS_STREAMING,
+                                     static_cast<int>(width), static_cast<int>(height));
+        if (texture_) SDL_SetTextureBlendMode(texture_, SDL_BLENDMODE_NONE);
+        return texture_ != nullptr;
+    }
+    void upload(const uint8_t* buffer, uint32_t stride, const Rect& rect) override {
+        SDL_Rect dst = {static_cast<int>(rect.x), static_cast<int>(rect.y),
+                        static_cast<int>(rect.width), static_cast<int>(rect.height)};
+        SDL_UpdateTexture(texture_, &dst,
+                          buffer + static_cast<size_t>(rect.y) * stride + rect.x * 4,
+                          static_cast<int>(stride));
+    }
+    void render(const SDL_Rect& area) override {
+        SDL_SetTextureScaleMode(texture_, SDL_ScaleModeLinear);
+        SDL_RenderCopy(renderer_, texture_, nullptr, &area);
+    }
+
+private:
+    SDL_Renderer* renderer_;
+    uint32_t format_;
+    SDL_Texture* texture_ = nullptr;
+};
+
+class Tiles : public DesktopTexture {
+public:
+    Tiles(SDL_Renderer* renderer, uint32_t format) : tiles_(renderer, format) {}
+
+    bool resize(uint32_t width, uint32_t height) override {
+        return tiles_.resize(width, height);
+    }
+    void upload(const uint8_t* buffer, uint32_t stride, const Rect& rect) override {
+        tiles_.upload(buffer, stride, rect);
+    }
+    void render(const SDL_Rect& area) override { tiles_.render(area, SDL_ScaleModeLinear); }
+
+private:
+    TiledTexture tiles_;
+};
+
+void run(SDL_Renderer* renderer, const char* path, DesktopTexture& texture, const Size& size,
+         int passes) {
+    uint32_t stride = (size.width + kGrow) * 4;
+    std::vector<uint8_t> pixels(static_cast<size_t>(stride) * (size.height + kGrow));
+    for (size_t i = 0; i < pixels.size(); i++) {
+        pixels[i] = static_cast<uint8_t>(i * 7);
+    }
+    const uint8_t* buffer = pixels.data();
+
+    if (!texture.resize(size.width, size.height)) {
+        std::printf("%-4s %-7s %s\n", size.name, path, "unsupported");
+        return;
+    }
+    double resize = time_ms(renderer, passes, [&] {
+        texture.resize(size.width + kGrow, size.height + kGrow);
+        texture.resize(size.width, size.height);
+    });
+    double full = time_ms(renderer, passes, [&] {
+        texture.upload(buffer, stride, Rect{0, 0, size.width, size.height});
+    });
+    auto rects = damage_rects(size.width, size.height);
+    double damage = time_ms(renderer, passes, [&] {
+        for (const Rect& rect : rects) texture.upload(buffer, stride, rect);
+    });
+    double fit = time_ms(renderer, passes, [&] {
+        texture.render(SDL_Rect{0, 0, kOutputWidth, kOutputHeight});
+    });
+    double crop = time_ms(renderer, passes, [&] {
+        texture.render(SDL_Rect{0, 0, static_cast<int>(size.width), static_cast<int>(size.height)});
+    });
+    std::printf("%-4s %-7s %9.2f %9.2f %9.2f %9.2f %9.2f\n", size.name, path, resize, full,
+                damage, fit, crop);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int passes = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 15;
+
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        std::fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
+        return 1;
+    }
+    SDL_Window* window = SDL_CreateWindow("bench_tiled_texture", SDL_WINDOWPOS_UNDEFINED,
+                                          SDL_WINDOWPOS_UNDEFINED, kOutputWidth, kOutputHeight,
+                                          SDL_WINDOW_HIDDEN);
+    SDL_Renderer* renderer =
+        window ? SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED) : nullptr;
+    if (!renderer) {
+        std::fprintf(stderr, "No renderer: %s\n", SDL_GetError());
+        if (window) SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
+
+    SDL_RendererInfo info{};
+    SDL_GetRendererInfo(renderer, &info);
+    std::printf("%s renderer, max texture %dx%d, %d passes, times in ms (median)\n", info.name,
+                info.max_texture_width, info.max_texture_height, passes);
+    std::printf("%-4s %-7s %9s %9s %9s %9s %9s\n", "size", "path", "resize", "full", "damage",
+                "fit", "crop");
+
+    const Size sizes[] = {{"4K", 3840, 2160}, {"8K", 7680, 4320}};
+    for (const Size& size : sizes) {
+        {
+            SingleTexture single(renderer, SDL_PIXELFORMAT_ARGB8888);
+            run(renderer, "single", single, size, passes);
+        }
+        {
+            Tiles tiles(renderer, SDL_PIXELFORMAT_ARGB8888);
+            run(renderer, "tiled", tiles, size, passes);
+        }
+    }
+
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return 0;
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "util/metrics.hpp"
+
 #include <string>
 
 namespace gvrdp {
@@ -12,4 +14,11 @@ public:
     virtual bool is_connected() const = 0;
 };
 
+// Payload bytes moved on a channel ("in" from the server, "out" to it).
+// Look it up once per call site; the counter itself is lock-free.
+inline Counter& channel_bytes(const char* channel, const char* direction) {
+    return Metrics::global().counter("gvrdp_channel_bytes_total", "Virtual channel payload bytes",
+                                     {{"channel", channel}, {"direction", direction}});
+}
+
 }  // namespace gvrdp
@@ -156,6 +156,8 @@ UINT CliprdrChannel::on_server_format_data_request(CliprdrClientContext* context
 
         response.requestedFormatData = utf16.data();
         response.common.dataLen = static_cast<UINT32>(utf16.size());
+        static Counter& bytes_out = channel_bytes("cliprdr", "out");
+        bytes_out.add(utf16.size());
 
         if (context->ClientFormatDataResponse) {
             return context->ClientFormatDataResponse(context, &response);
@@ -178,6 +180,8 @@ UINT CliprdrChannel::on_server_format_data_response(
     if (response->common.msgFlags != CB_RESPONSE_OK || !response->requestedFormatData) {
         return CHANNEL_RC_OK;
     }
+    static Counter& bytes_in = channel_bytes("cliprdr", "in");
+    bytes_in.add(response->common.dataLen);
 
     // Convert UTF-16LE to UTF-8 (simple ASCII conversion)
     self->received_text_.clear();
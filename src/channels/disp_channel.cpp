@@ -9,7 +9,7 @@
 
 namespace gvrdp {
 
-DispChannel::DispChannel() : last_send_(std::chrono::steady_clock::now() - kMinInterval) {}
+DispChannel::DispChannel() = default;
 
 std::string DispChannel::channel_name() const {
     return DISP_DVC_CHANNEL_NAME;
@@ -35,13 +35,6 @@ bool DispChannel::send_layout(uint32_t width, uint32_t height) {
         return false;
     }
 
-    // Enforce minimum interval
-    auto now = std::chrono::steady_clock::now();
-    if (now - last_send_ < kMinInterval) {
-        return false;
-    }
-    last_send_ = now;
-
     // Clamp dimensions
     width = std::clamp(width, static_cast<uint32_t>(DISPLAY_CONTROL_MIN_MONITOR_WIDTH),
                        static_cast<uint32_t>(DISPLAY_CONTROL_MAX_MONITOR_WIDTH));
@@ -70,6 +63,9 @@ bool DispChannel::send_layout(uint32_t width, uint32_t height) {
         return false;
     }
 
+    // DISPLAYCONTROL_HEADER, MonitorLayoutSize, NumMonitors, one monitor
+    static Counter& bytes_out = channel_bytes("disp", "out");
+    bytes_out.add(8 + 4 + 4 + 40);
     LOG_INFO("Sent display layout: {}x{}", width, height);
     return true;
 }
@@ -4,7 +4,6 @@
 
 #include <freerdp/client/disp.h>
 
-#include <chrono>
 #include <cstdint>
 
 namespace gvrdp {
@@ -22,14 +21,13 @@ public:
     void on_connected(DispClientContext* disp_ctx);
     void on_disconnected();
 
-    // Send a single-monitor layout with the given resolution.
-    // Has a built-in 200ms minimum interval guard.
+    // Send a single-monitor layout with the given resolution, clamped to the
+    // protocol's limits and rounded down to even sizes. Pacing is up to the
+    // caller (see ResizeController); every call is sent.
     bool send_layout(uint32_t width, uint32_t height);
 
 private:
     DispClientContext* disp_ctx_ = nullptr;
-    std::chrono::steady_clock::time_point last_send_;
-    static constexpr auto kMinInterval = std::chrono::milliseconds(200);
 };
 
 }  // namespace gvrdp
@@ -15,9 +15,41 @@ struct AppConfig {
     int window_w = 1280;
     int window_h = 720;
 
+    // GFX tile decode workers (0 = cores - 1, 1 = decode on the channel thread)
+    int decode_threads = 0;
+
+    // Per-host bitmap cache kept across sessions, in MiB (0 = off)
+    int persistent_cache_mb = 256;
+
+    // Presentation rate cap while the window is unfocused (0 = uncapped)
+    int unfocused_fps = 0;
+
+    // Pointer motion is collapsed to the latest position before it is sent,
+    // at most mouse_motion_hz times a second (0 = once per event loop pass)
+    bool mouse_coalescing = true;
+    int mouse_motion_hz = 250;
+
+    // "vsync": input is handled between vsync-paced presents.
+    // "low_latency": clicks and keys are sent as soon as SDL reads them.
+    // "immediate": as low_latency, and presents without vsync (may tear).
+    std::string present_mode = "vsync";
+
+    // Events kept by the always-on flight recorder, 32 bytes each (0 = off)
+    int flight_recorder_events = 65536;
+
+    // Seconds between metrics.json / metrics.prom snapshots in the config
+    // directory (0 = off)
+    int metrics_interval_s = 0;
+
+    // Time every FreeRDP update handler and log calls, pixels and time per
+    // drawing order at disconnect
+    bool profile_updates = false;
+
     NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(
         AppConfig,
-        log_level, last_profile, window_x, window_y, window_w, window_h
+        log_level, last_profile, window_x, window_y, window_w, window_h, decode_threads,
+        persistent_cache_mb, unfocused_fps, mouse_coalescing, mouse_motion_hz, present_mode,
+        flight_recorder_events, metrics_interval_s, profile_updates
     )
 
     static AppConfig load(const std::filesystem::path& config_dir);
@@ -1,8 +1,35 @@
 #include "config/connection_profile.hpp"
 
 // ConnectionProfile JSON serialization is handled by NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT
-// This .cpp exists for potential future non-inline methods.
 
 namespace gvrdp {
 
+CodecSelection resolve_codecs(const ConnectionProfile& profile, bool gpu_h264_available) {
+    CodecSelection codecs;
+    if (profile.codec_auto) {
+        // H.264 only when the GPU does the colour conversion; on the CPU it
+        // costs more than RemoteFX/progressive. AVC444 never: it cannot take
+        // the GPU path.
+        codecs.remotefx = true;
+        codecs.progressive = true;
+        codecs.avc420 = profile.enable_gfx_pipeline && gpu_h264_available;
+        codecs.avc444 = false;
+        codecs.planar = true;
+        codecs.nscodec = true;
+    } else {
+        codecs.remotefx = profile.codec_remotefx;
+        codecs.progressive = profile.codec_progressive;
+        codecs.avc420 = profile.codec_avc420;
+        codecs.avc444 = profile.codec_avc444;
+        codecs.planar = profile.codec_planar;
+        codecs.nscodec = profile.codec_nscodec;
+    }
+
+    // Mixing our decoder with FreeRDP's AVC444 one on the same surfaces
+    // would split the H.264 reference state, so AVC444 keeps it all on FreeRDP
+    codecs.gpu_h264 =
+        profile.enable_gfx_pipeline && gpu_h264_available && codecs.avc420 && !codecs.avc444;
+    return codecs;
+}
+
 }  // namespace gvrdp
@@ -23,6 +23,11 @@ struct ConnectionProfile {
     uint32_t color_depth = 32;
     bool fullscreen = false;
     bool dynamic_resolution = true;
+    // Keep the remote resolution and scale it to the window locally
+    // (letterboxed) instead of resizing the remote desktop
+    bool smart_sizing = false;
+    // Smart sizing filter: "nearest", "linear" or "best"
+    std::string scaling_filter = "linear";
 
     // Channels
     bool enable_clipboard = true;
@@ -35,6 +40,23 @@ struct ConnectionProfile {
     bool enable_font_smoothing = true;
     bool enable_desktop_composition = false;
     bool enable_themes = true;
+    // RDPGFX with GPU-side surface composition
+    bool enable_gfx_pipeline = true;
+    // Presentation rate cap; with RDPGFX the server follows it (0 = display rate)
+    uint32_t max_fps = 0;
+    // GFX frames that may be acknowledged before they are on screen
+    // (0 = acknowledge only after presenting)
+    uint32_t gfx_ack_window = 0;
+
+    // Codecs. With codec_auto GVRDP offers what it decodes cheapest (see
+    // resolve_codecs()); otherwise exactly the ticked codecs are offered.
+    bool codec_auto = true;
+    bool codec_remotefx = true;
+    bool codec_progressive = true;
+    bool codec_avc420 = true;
+    bool codec_avc444 = false;
+    bool codec_planar = true;
+    bool codec_nscodec = true;
 
     // Security
     bool ignore_certificate = false;
@@ -45,11 +67,29 @@ struct ConnectionProfile {
     NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(
         ConnectionProfile,
         name, hostname, port, username, domain,
-        width, height, color_depth, fullscreen, dynamic_resolution,
+        width, height, color_depth, fullscreen, dynamic_resolution, smart_sizing, scaling_filter,
         enable_clipboard, enable_audio, enable_drive_redirect, drive_redirect_path,
         enable_wallpaper, enable_font_smoothing, enable_desktop_composition, enable_themes,
+        enable_gfx_pipeline, max_fps, gfx_ack_window, codec_auto, codec_remotefx, codec_progressive, codec_avc420,
+        codec_avc444, codec_planar, codec_nscodec,
         ignore_certificate, gateway_hostname, gateway_port, gateway_username
     )
 };
 
+// The codec set actually offered to the server for a profile
+struct CodecSelection {
+    bool remotefx = false;
+    bool progressive = false;
+    bool avc420 = false;
+    bool avc444 = false;
+    bool planar = false;
+    bool nscodec = false;
+
+    // AVC420 is decoded to YUV by GVRDP and converted on the GPU
+    bool gpu_h264 = false;
+};
+
+// gpu_h264_available: an H.264 decoder for the GPU YUV path exists
+CodecSelection resolve_codecs(const ConnectionProfile& profile, bool gpu_h264_available);
+
 }  // namespace gvrdp
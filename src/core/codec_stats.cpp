@@ -0,0 +1,65 @@
+#include "core/codec_stats.hpp"
+
+#include "util/metrics.hpp"
+
+namespace gvrdp {
+
+// Per-codec decode time in the process-wide registry, across sessions
+static Histogram& decode_histogram(Codec codec) {
+    static const auto histograms = [] {
+        std::array<Histogram*, static_cast<size_t>(Codec::Count)> all{};
+        for (size_t i = 0; i < all.size(); i++) {
+            all[i] = &Metrics::global().histogram("gvrdp_decode_seconds",
+                                                  "Bitmap decode time per codec",
+                                                  {{"codec", codec_name(static_cast<Codec>(i))}});
+        }
+        return all;
+    }();
+    return *histograms[static_cast<size_t>(codec)];
+}
+
+const char* codec_name(Codec codec) {
+    switch (codec) {
+        case Codec::Uncompressed: return "Uncompressed";
+        case Codec::Interleaved: return "Interleaved";
+        case Codec::Planar: return "Planar";
+        case Codec::RemoteFx: return "RemoteFX";
+        case Codec::NsCodec: return "NSCodec";
+        case Codec::ClearCodec: return "ClearCodec";
+        case Codec::Progressive: return "Progressive";
+        case Codec::Avc420: return "AVC420";
+        case Codec::Avc444: return "AVC444";
+        case Codec::Alpha: return "Alpha";
+        case Codec::Count: break;
+    }
+    return "Unknown";
+}
+
+void CodecStats::record(Codec codec, size_t bytes, std::chrono::nanoseconds decode_time) {
+    if (codec >= Codec::Count) return;
+    Counters& c = counters_[static_cast<size_t>(codec)];
+    c.commands.fetch_add(1, std::memory_order_relaxed);
+    c.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    c.decode_ns.fetch_add(decode_time.count(), std::memory_order_relaxed);
+    decode_histogram(codec).observe(decode_time);
+}
+
+CodecTotals CodecStats::totals(Codec codec) const {
+    CodecTotals totals;
+    if (codec >= Codec::Count) return totals;
+    const Counters& c = counters_[static_cast<size_t>(codec)];
+    totals.commands = c.commands.load(std::memory_order_relaxed);
+    totals.bytes = c.bytes.load(std::memory_order_relaxed);
+    totals.decode_time = std::chrono::nanoseconds(c.decode_ns.load(std::memory_order_relaxed));
+    return totals;
+}
+
+void CodecStats::reset() {
+    for (auto& c : counters_) {
+        c.commands.store(0, std::memory_order_relaxed);
+        c.bytes.store(0, std::memory_order_relaxed);
+        c.decode_ns.store(0, std::memory_order_relaxed);
+    }
+}
+
+}  // namespace gvrdp
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace gvrdp {
+
+// Bitmap codecs we can tell apart in the update stream
+enum class Codec : uint8_t {
+    Uncompressed,
+    Interleaved,  // Legacy RLE bitmap updates
+    Planar,
+    RemoteFx,
+    NsCodec,
+    ClearCodec,
+    Progressive,
+    Avc420,
+    Avc444,
+    Alpha,
+    Count,
+};
+
+const char* codec_name(Codec codec);
+
+struct CodecTotals {
+    uint64_t commands = 0;
+    uint64_t bytes = 0;  // Compressed payload received
+    std::chrono::nanoseconds decode_time{0};
+};
+
+// Per-codec counters of payload size and decode time. Written by the RDP
+// thread, read by the overlay; every counter is an independent relaxed atomic.
+class CodecStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void record(Codec codec, size_t bytes, std::chrono::nanoseconds decode_time);
+    CodecTotals totals(Codec codec) const;
+    void reset();
+
+    // Times a decode call and records it when the scope ends
+    class Scope {
+    public:
+        Scope(CodecStats* stats, Codec codec, size_t bytes)
+            : stats_(stats), codec_(codec), bytes_(bytes), start_(Clock::now()) {}
+        ~Scope() {
+            if (stats_) stats_->record(codec_, bytes_, Clock::now() - start_);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        CodecStats* stats_;
+        Codec codec_;
+        size_t bytes_;
+        Clock::time_point start_;
+    };
+
+private:
+    struct Counters {
+        std::atomic<uint64_t> commands{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<int64_t> decode_ns{0};
+    };
+
+    std::array<Counters, static_cast<size_t>(Codec::Count)> counters_;
+};
+
+}  // namespace gvrdp
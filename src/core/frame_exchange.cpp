@@ -0,0 +1,109 @@
+#include "core/frame_exchange.hpp"
+
+#include <cstring>
+
+namespace gvrdp {
+
+static constexpr uint32_t kBytesPerPixel = 4;
+
+static void copy_rect(DesktopFrame& dst, const uint8_t* src, uint32_t src_stride,
+                      const Rect& rect) {
+    size_t row_bytes = static_cast<size_t>(rect.width) * kBytesPerPixel;
+    for (uint32_t row = rect.y; row < rect.bottom(); row++) {
+        std::memcpy(dst.pixels.data() + static_cast<size_t>(row) * dst.stride +
+                        static_cast<size_t>(rect.x) * kBytesPerPixel,
+                    src + static_cast<size_t>(row) * src_stride +
+                        static_cast<size_t>(rect.x) * kBytesPerPixel,
+                    row_bytes);
+    }
+}
+
+FrameExchange::FrameExchange() : ready_(1) {}
+
+void FrameExchange::publish(const uint8_t* src, uint32_t width, uint32_t height,
+                            uint32_t stride, const DamageRegion& damage,
+                            std::chrono::steady_clock::time_point received,
+                            std::chrono::steady_clock::time_point decoded) {
+    if (!src || width == 0 || height == 0) return;
+
+    DamageRegion frame_damage = damage;
+    bool resized = width != last_width_ || height != last_height_;
+    if (resized) {
+        frame_damage.clear();
+        frame_damage.add(Rect{0, 0, width, height});
+        carry_.clear();
+        last_width_ = width;
+        last_height_ = height;
+    }
+    frame_damage.clip(width, height);
+
+    // Bring the back buffer up to date: it is missing this frame's damage
+    // plus whatever was painted while it was owned by the consumer.
+    DesktopFrame& frame = slots_[back_];
+    if (frame.width != width || frame.height != height) {
+        frame.width = width;
+        frame.height = height;
+        frame.stride = frame_stride(width);
+        frame.pixels = FrameBuffer(static_cast<size_t>(frame.stride) * height);
+        if (!frame.pixels.data()) {
+            // Out of memory: drop the frame, the next publish starts over full-frame
+            frame.width = 0;
+            frame.height = 0;
+            last_width_ = 0;
+            return;
+        }
+        copy_rect(frame, src, stride, Rect{0, 0, width, height});
+    } else {
+        DamageRegion missing = stale_[back_];
+        missing.add(frame_damage);
+        missing.clip(width, height);
+        for (const auto& rect : missing.rects()) {
+            copy_rect(frame, src, stride, rect);
+        }
+    }
+
+    DamageRegion published = carry_;
+    published.add(frame_damage);
+    frame.damage = published;
+    frame.sequence = ++sequence_;
+    frame.received = received;
+    frame.decoded = decoded;
+
+    uint8_t published_index = back_;
+    uint8_t previous = ready_.exchange(static_cast<uint8_t>(published_index | kFreshBit),
+                                       std::memory_order_acq_rel);
+    back_ = previous & kIndexMask;
+
+    // The other two slots now lag behind the source by this frame's damage
+    for (uint8_t i = 0; i < slots_.size(); i++) {
+        if (i == published_index) {
+            stale_[i].clear();
+        } else {
+            stale_[i].add(frame_damage);
+        }
+    }
+
+    // If the previous frame was never picked up, the consumer has not seen
+    // anything we published since it last acquired: keep accumulating.
+    // Otherwise it has everything up to the previous frame.
+    if (previous & kFreshBit) {
+        carry_ = std::move(published);
+    } else {
+        carry_ = std::move(frame_damage);
+    }
+}
+
+const DesktopFrame* FrameExchange::acquire() {
+    if (!(ready_.load(std::memory_order_relaxed) & kFreshBit)) return nullptr;
+
+    uint8_t previous = ready_.exchange(front_, std::memory_order_acq_rel);
+    front_ = previous & kIndexMask;
+    has_frame_ = true;
+    return &slots_[front_];
+}
+
+const DesktopFrame* FrameExchange::current() const {
+    return has_frame_ ? &slots_[front_] : nullptr;
+}
+
+}  // namespace gvrdp
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "render/frame_allocator.hpp"
+#include "util/damage_region.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace gvrdp {
+
+// A complete desktop frame as handed from the RDP thread to the main thread.
+// Pixel rows are padded to kFrameRowAlignment so they can be uploaded as-is.
+struct DesktopFrame {
+    FrameBuffer pixels;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t stride = 0;
+    uint64_t sequence = 0;
+
+    // When the RDP thread woke for the frame's first PDU, and when EndPaint
+    // finished it (unset for frames not caused by server updates)
+    std::chrono::steady_clock::time_point received;
+    std::chrono::steady_clock::time_point decoded;
+
+    // Everything that changed since the last frame the consumer acquired,
+    // including the damage of any frames it never saw.
+    DamageRegion damage;
+};
+
+// Lock-free single-producer/single-consumer triple buffer for desktop frames.
+//
+// The producer (RDP thread) copies the damaged parts of the GDI buffer into
+// its private back buffer and publishes it; the consumer (main thread) always
+// gets the newest published frame. Frames the consumer was too slow to pick
+// up are dropped, but their damage is carried into the next published frame,
+// so uploading just frame->damage keeps a texture in sync.
+//
+// The GDI buffer is only read during publish(), i.e. on the RDP thread, so
+// gdi_resize() can never free memory the main thread is reading.
+class FrameExchange {
+public:
+    FrameExchange();
+
+    FrameExchange(const FrameExchange&) = delete;
+    FrameExchange& operator=(const FrameExchange&) = delete;
+
+    // Producer side. Brings the back buffer up to date with `src` (copying
+    // only what it is missing) and publishes it. A size change publishes a
+    // full-frame update. The timestamps are passed through to the frame.
+    void publish(const uint8_t* src, uint32_t width, uint32_t height, uint32_t stride,
+                 const DamageRegion& damage,
+                 std::chrono::steady_clock::time_point received = {},
+                 std::chrono::steady_clock::time_point decoded = {});
+
+    // Consumer side. Returns the newest frame if one was published since the
+    // previous call, nullptr otherwise. The frame stays valid and unchanged
+    // until the next call to acquire().
+    const DesktopFrame* acquire();
+
+    // Consumer side. The frame returned by the last successful acquire().
+    const DesktopFrame* current() const;
+
+private:
+    static constexpr uint8_t kIndexMask = 0x3;
+    static constexpr uint8_t kFreshBit = 0x4;
+
+    std::array<DesktopFrame, 3> slots_;
+
+    // Index of the published slot, plus kFreshBit until the consumer takes it
+    std::atomic<uint8_t> ready_;
+
+    // Producer-owned state
+    uint8_t back_ = 0;
+    uint64_t sequence_ = 0;
+    uint32_t last_width_ = 0;
+    uint32_t last_height_ = 0;
+    std::array<DamageRegion, 3> stale_;  // What each slot is missing vs. the source
+    DamageRegion carry_;                 // Published damage the consumer may not have seen
+
+    // Consumer-owned state
+    uint8_t front_ = 2;
+    bool has_frame_ = false;
+};
+
+}  // namespace gvrdp
@@ -0,0 +1,66 @@
+#include "core/frame_stats.hpp"
+
+namespace gvrdp {
+
+const char* frame_stage_name(FrameStage stage) {
+    switch (stage) {
+        case FrameStage::Decode: return "Decode";
+        case FrameStage::Upload: return "Upload";
+        case FrameStage::Present: return "Present";
+        case FrameStage::Total: return "Total";
+        case FrameStage::Count: break;
+    }
+    return "Unknown";
+}
+
+static std::chrono::microseconds to_us(FrameStats::Clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration);
+}
+
+void FrameStats::record_uploaded(Clock::time_point received, Clock::time_point decoded,
+                                 Clock::time_point uploaded) {
+    uploaded_++;
+    if (received == Clock::time_point{} || decoded < received) return;
+
+    histogram(FrameStage::Decode).record(to_us(decoded - received));
+    histogram(FrameStage::Upload).record(to_us(uploaded - decoded));
+    if (timed_ < unpresented_.size()) {
+        unpresented_[timed_++] = {received, uploaded};
+    }
+}
+
+void FrameStats::record_presented(Clock::time_point presented) {
+    for (size_t i = 0; i < timed_; i++) {
+        histogram(FrameStage::Present).record(to_us(presented - unpresented_[i].uploaded));
+        histogram(FrameStage::Total).record(to_us(presented - unpresented_[i].received));
+    }
+    if (uploaded_ > 1) dropped_ += uploaded_ - 1;
+    frames_ += uploaded_;
+    uploaded_ = 0;
+    timed_ = 0;
+}
+
+void FrameStats::record_dirty(uint64_t dirty_pixels, uint64_t desktop_pixels) {
+    dirty_pixels_ += dirty_pixels;
+    desktop_pixels_ += desktop_pixels;
+}
+
+void FrameStats::record_sequence(uint64_t sequence) {
+    if (last_sequence_ != 0 && sequence > last_sequence_ + 1) {
+        dropped_ += sequence - last_sequence_ - 1;
+    }
+    last_sequence_ = sequence;
+}
+
+void FrameStats::reset() {
+    for (auto& histogram : stages_) histogram.reset();
+    timed_ = 0;
+    uploaded_ = 0;
+    frames_ = 0;
+    dropped_ = 0;
+    dirty_pixels_ = 0;
+    desktop_pixels_ = 0;
+    last_sequence_ = 0;
+}
+
+}  // namespace gvrdp
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "util/histogram.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace gvrdp {
+
+// Where a frame's time goes, from the first PDU of a frame being readable
+// on the RDP thread to the present() that shows it
+enum class FrameStage : uint8_t {
+    Decode,   // PDU received to EndPaint/EndFrame
+    Upload,   // EndPaint/EndFrame to texture upload done on the main thread
+    Present,  // Upload done to present() returned
+    Total,    // PDU received to present() returned
+    Count,
+};
+
+const char* frame_stage_name(FrameStage stage);
+
+// Per-session frame latency and volume counters. Main thread only: frames
+// carry their RDP-thread timestamps to the main thread, which records them
+// when it uploads them and again when present() shows them. Nothing
+// allocates.
+class FrameStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // A frame is on the GPU. Frames without a receive time (e.g. the full
+    // frame after connect) are counted but not timed.
+    void record_uploaded(Clock::time_point received, Clock::time_point decoded,
+                         Clock::time_point uploaded);
+
+    // present() returned, showing every frame uploaded since the last call.
+    // All but the newest of those count as dropped: never shown on their own.
+    void record_presented(Clock::time_point presented);
+
+    // Pixels a frame changed, against the desktop size
+    void record_dirty(uint64_t dirty_pixels, uint64_t desktop_pixels);
+
+    // Sequence number of an acquired DesktopFrame; gaps are dropped frames
+    void record_sequence(uint64_t sequence);
+
+    void reset();
+
+    const LatencyHistogram& stage(FrameStage stage) const {
+        return stages_[static_cast<size_t>(stage)];
+    }
+    uint64_t frames() const { return frames_; }  // Shown, including dropped ones
+    uint64_t dropped() const { return dropped_; }
+    uint64_t dirty_pixels() const { return dirty_pixels_; }
+    uint64_t desktop_pixels() const { return desktop_pixels_; }
+
+private:
+    struct Uploaded {
+        Clock::time_point received;
+        Clock::time_point uploaded;
+    };
+
+    LatencyHistogram& histogram(FrameStage stage) {
+        return stages_[static_cast<size_t>(stage)];
+    }
+
+    std::array<LatencyHistogram, static_cast<size_t>(FrameStage::Count)> stages_;
+    // Timed frames waiting for present(); more than fit are counted only
+    std::array<Uploaded, 16> unpresented_{};
+    size_t timed_ = 0;
+    uint64_t uploaded_ = 0;
+    uint64_t frames_ = 0;
+    uint64_t dropped_ = 0;
+    uint64_t dirty_pixels_ = 0;
+    uint64_t desktop_pixels_ = 0;
+    uint64_t last_sequence_ = 0;
+};
+
+}  // namespace gvrdp
@@ -0,0 +1,180 @@
+#include "core/h264_decoder.hpp"
+
+#include "util/logger.hpp"
+
+#ifdef GVRDP_WITH_FFMPEG
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+}
+#endif
+
+#include <array>
+#include <cstring>
+#include <vector>
+
+namespace gvrdp {
+
+#ifdef GVRDP_WITH_FFMPEG
+
+// Full-range (JPEG) samples to the limited (video) range that the GPU and
+// FreeRDP's CPU conversions both assume: luma to 16-235, chroma to 16-240
+static std::array<uint8_t, 256> range_table(int low, int high) {
+    std::array<uint8_t, 256> table{};
+    for (int i = 0; i < 256; i++) {
+        table[static_cast<size_t>(i)] = static_cast<uint8_t>(low + (i * (high - low) + 127) / 255);
+    }
+    return table;
+}
+
+static void to_limited_range(const uint8_t* src, int pitch, uint32_t rows,
+                             const std::array<uint8_t, 256>& table, std::vector<uint8_t>& out) {
+    size_t size = static_cast<size_t>(pitch) * rows;
+    out.resize(size);
+    for (size_t i = 0; i < size; i++) {
+        out[i] = table[src[i]];
+    }
+}
+
+struct H264Decoder::Impl {
+    AVCodecContext* codec = nullptr;
+    AVPacket* packet = nullptr;
+    AVFrame* frame = nullptr;    // Backs `picture`
+    AVFrame* scratch = nullptr;  // Receives, so a failed decode keeps `frame`
+    std::vector<uint8_t> input;  // Bitstream plus the padding libavcodec wants
+    std::array<std::vector<uint8_t>, 3> limited;  // Full-range planes, rescaled
+    YuvPicture picture;
+    bool has_picture = false;
+
+    ~Impl() {
+        av_frame_free(&scratch);
+        av_frame_free(&frame);
+        av_packet_free(&packet);
+        avcodec_free_context(&codec);
+    }
+};
+
+bool H264Decoder::available() {
+    return avcodec_find_decoder(AV_CODEC_ID_H264) != nullptr;
+}
+
+std::unique_ptr<H264Decoder> H264Decoder::create() {
+    const AVCodec* h264 = avcodec_find_decoder(AV_CODEC_ID_H264);
+    if (!h264) return nullptr;
+
+    auto impl = std::make_unique<Impl>();
+    impl->codec = avcodec_alloc_context3(h264);
+    impl->packet = av_packet_alloc();
+    impl->frame = av_frame_alloc();
+    impl->scratch = av_frame_alloc();
+    if (!impl->codec || !impl->packet || !impl->frame || !impl->scratch) return nullptr;
+
+    // Remote desktop frames must come out as soon as they go in: no frame
+    // threading (it adds a frame of latency per thread), slices only.
+    impl->codec->flags |= AV_CODEC_FLAG_LOW_DELAY;
+    impl->codec->thread_type = FF_THREAD_SLICE;
+    impl->codec->thread_count = 0;
+
+    if (avcodec_open2(impl->codec, h264, nullptr) < 0) {
+        LOG_ERROR("Failed to open the H.264 decoder");
+        return nullptr;
+    }
+    return std::unique_ptr<H264Decoder>(new H264Decoder(std::move(impl)));
+}
+
+const YuvPicture* H264Decoder::decode(const uint8_t* data, size_t size) {
+    if (!data || size == 0) return nullptr;
+
+    impl_->input.resize(size + AV_INPUT_BUFFER_PADDING_SIZE);
+    std::memcpy(impl_->input.data(), data, size);
+    std::memset(impl_->input.data() + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    impl_->packet->data = impl_->input.data();
+    impl_->packet->size = static_cast<int>(size);
+
+    int rc = avcodec_send_packet(impl_->codec, impl_->packet);
+    impl_->packet->data = nullptr;
+    impl_->packet->size = 0;
+    if (rc < 0) {
+        LOG_WARN("H.264 decode failed ({})", rc);
+        return nullptr;
+    }
+
+    bool got_frame = false;
+    while (avcodec_receive_frame(impl_->codec, impl_->scratch) == 0) {
+        av_frame_unref(impl_->frame);
+        av_frame_move_ref(impl_->frame, impl_->scratch);
+        got_frame = true;
+    }
+    if (!got_frame) return nullptr;
+
+    const AVFrame* frame = impl_->frame;
+    YuvPicture& picture = impl_->picture;
+    switch (frame->format) {
+        case AV_PIX_FMT_YUV420P:
+        case AV_PIX_FMT_YUVJ420P:
+            picture.layout = YuvPicture::Layout::I420;
+            break;
+        case AV_PIX_FMT_NV12:
+            picture.layout = YuvPicture::Layout::NV12;
+            break;
+        default:
+            LOG_WARN("Unsupported H.264 output format {}", frame->format);
+            impl_->has_picture = false;
+            return nullptr;
+    }
+    for (int i = 0; i < 3; i++) {
+        picture.planes[i] = frame->data[i];
+        picture.pitches[i] = frame->linesize[i];
+    }
+    picture.width = static_cast<uint32_t>(frame->width);
+    picture.height = static_cast<uint32_t>(frame->height);
+
+    // Rescaled into our own planes: the decoder's are still reference frames
+    if (frame->format == AV_PIX_FMT_YUVJ420P || frame->color_range == AVCOL_RANGE_JPEG) {
+        static const std::array<uint8_t, 256> luma = range_table(16, 235);
+        static const std::array<uint8_t, 256> chroma = range_table(16, 240);
+        uint32_t chroma_rows = (picture.height + 1) / 2;
+        int planes = picture.layout == YuvPicture::Layout::I420 ? 3 : 2;
+        for (int i = 0; i < planes; i++) {
+            auto plane = static_cast<size_t>(i);
+            to_limited_range(frame->data[i], frame->linesize[i],
+                             i == 0 ? picture.height : chroma_rows, i == 0 ? luma : chroma,
+                             impl_->limited[plane]);
+            picture.planes[i] = impl_->limited[plane].data();
+        }
+    }
+    impl_->has_picture = true;
+    return &picture;
+}
+
+const YuvPicture* H264Decoder::picture() const {
+    return impl_->has_picture ? &impl_->picture : nullptr;
+}
+
+#else  // !GVRDP_WITH_FFMPEG
+
+struct H264Decoder::Impl {};
+
+bool H264Decoder::available() {
+    return false;
+}
+
+std::unique_ptr<H264Decoder> H264Decoder::create() {
+    return nullptr;
+}
+
+const YuvPicture* H264Decoder::decode(const uint8_t* /*data*/, size_t /*size*/) {
+    return nullptr;
+}
+
+const YuvPicture* H264Decoder::picture() const {
+    return nullptr;
+}
+
+#endif  // GVRDP_WITH_FFMPEG
+
+H264Decoder::H264Decoder(std::unique_ptr<Impl> impl) : impl_(std::move(impl)) {}
+
+H264Decoder::~H264Decoder() = default;
+
+}  // namespace gvrdp
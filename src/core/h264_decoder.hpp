@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace gvrdp {
+
+// A decoded picture, still in YUV and always limited range (full-range
+// streams are rescaled). Plane pointers stay valid until the next decode()
+// on the same decoder.
+struct YuvPicture {
+    enum class Layout : uint8_t {
+        I420,  // planes[0..2] = Y, U, V (SDL_PIXELFORMAT_IYUV)
+        NV12,  // planes[0] = Y, planes[1] = interleaved UV
+    };
+
+    Layout layout = Layout::I420;
+    const uint8_t* planes[3] = {};
+    int pitches[3] = {};
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+// H.264 (AVC420) decoder that stops at YUV, so colour conversion can happen
+// on the GPU. Backed by libavcodec when built with GVRDP_WITH_FFMPEG; without
+// it create() returns nullptr and FreeRDP's own decoder is used.
+class H264Decoder {
+public:
+    static bool available();
+    static std::unique_ptr<H264Decoder> create();
+
+    ~H264Decoder();
+
+    H264Decoder(const H264Decoder&) = delete;
+    H264Decoder& operator=(const H264Decoder&) = delete;
+
+    // Decodes one access unit. Returns nullptr on error or if the decoder
+    // has no picture to output yet.
+    const YuvPicture* decode(const uint8_t* data, size_t size);
+
+    // The last picture returned by decode(), or nullptr
+    const YuvPicture* picture() const;
+
+private:
+    struct Impl;
+    explicit H264Decoder(std::unique_ptr<Impl> impl);
+
+    std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace gvrdp
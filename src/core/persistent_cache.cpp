@@ -0,0 +1,361 @@
+#include "core/persistent_cache.hpp"
+
+#include "util/platform.hpp"
+
+#if GVRDP_WINDOWS
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <system_error>
+
+namespace gvrdp {
+
+// ── File format ───────────────────────────────────────────────────────
+//
+//   FileHeader | IndexRecord[count] | pixel data
+//
+// Native byte order: the file is a local cache, not an interchange format.
+
+namespace {
+
+constexpr char kMagic[8] = {'G', 'V', 'R', 'D', 'P', 'B', 'C', '\0'};
+constexpr uint32_t kVersion = 1;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t generation;
+    uint32_t index_checksum;
+    uint32_t reserved;
+};
+static_assert(sizeof(FileHeader) == 32);
+
+struct IndexRecord {
+    uint64_t key;
+    uint64_t offset;
+    uint64_t last_used;
+    uint32_t checksum;
+    uint16_t width;
+    uint16_t height;
+};
+static_assert(sizeof(IndexRecord) == 32);
+
+// FNV-1a; catches torn or bit-rotted data, not adversaries
+uint32_t checksum(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Flushes a written file to disk before it is renamed into place
+bool sync_file(FILE* file) {
+    if (std::fflush(file) != 0) return false;
+#if GVRDP_WINDOWS
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Makes the rename itself durable
+void sync_directory(const std::filesystem::path& dir) {
+#if !GVRDP_WINDOWS
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        fsync(fd);
+        ::close(fd);
+    }
+#else
+    (void)dir;
+#endif
+}
+
+}  // namespace
+
+// ── Read-only mapping ─────────────────────────────────────────────────
+
+class PersistentCache::MappedFile {
+public:
+    static std::unique_ptr<MappedFile> open(const std::filesystem::path& path) {
+        auto file = std::unique_ptr<MappedFile>(new MappedFile());
+#if GVRDP_WINDOWS
+        HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) return nullptr;
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+            CloseHandle(handle);
+            return nullptr;
+        }
+        HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(handle);
+        if (!mapping) return nullptr;
+        // The view keeps the mapping alive
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (!view) return nullptr;
+        file->data_ = static_cast<const uint8_t*>(view);
+        file->size_ = static_cast<size_t>(size.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return nullptr;
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return nullptr;
+        }
+        void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (view == MAP_FAILED) return nullptr;
+        file->data_ = static_cast<const uint8_t*>(view);
+        file->size_ = static_cast<size_t>(st.st_size);
+#endif
+        return file;
+    }
+
+    ~MappedFile() {
+        if (!data_) return;
+#if GVRDP_WINDOWS
+        UnmapViewOfFile(data_);
+#else
+        munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    MappedFile() = default;
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// ── PersistentCache ───────────────────────────────────────────────────
+
+PersistentCache::PersistentCache(std::filesystem::path path, uint64_t limit_bytes)
+    : path_(std::move(path)), limit_bytes_(limit_bytes) {
+    load();
+}
+
+PersistentCache::~PersistentCache() = default;
+
+std::filesystem::path PersistentCache::path_for(const std::filesystem::path& dir,
+                                                const std::string& host, uint16_t port) {
+    std::string name;
+    for (char c : host) {
+        unsigned char uc = static_cast<unsigned char>(c);
+        name += (std::isalnum(uc) || c == '.' || c == '-') ? static_cast<char>(std::tolower(uc))
+                                                          : '_';
+    }
+    if (name.empty()) name = "_";
+    return dir / (name + "_" + std::to_string(port) + ".gvc");
+}
+
+void PersistentCache::load() {
+    entries_.clear();
+    bytes_ = 0;
+    generation_ = 1;
+
+    file_ = MappedFile::open(path_);
+    if (!file_) return;
+
+    const uint8_t* data = file_->data();
+    size_t size = file_->size();
+    FileHeader header{};
+    if (size < sizeof(header)) {
+        file_.reset();
+        return;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    size_t index_end = sizeof(header) + static_cast<size_t>(header.count) * sizeof(IndexRecord);
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+        index_end > size ||
+        checksum(data + sizeof(header), index_end - sizeof(header)) != header.index_checksum) {
+        file_.reset();
+        return;
+    }
+
+    for (uint32_t i = 0; i < header.count; i++) {
+        IndexRecord record{};
+        std::memcpy(&record, data + sizeof(header) + i * sizeof(IndexRecord), sizeof(record));
+
+        Entry entry;
+        entry.width = record.width;
+        entry.height = record.height;
+        entry.offset = record.offset;
+        entry.checksum = record.checksum;
+        entry.last_used = record.last_used;
+        if (entry.size() == 0 || entry.offset < index_end || entry.offset > size ||
+            entry.size() > size - entry.offset || entries_.count(record.key)) {
+            continue;
+        }
+        bytes_ += entry.size();
+        entries_.emplace(record.key, std::move(entry));
+    }
+    generation_ = header.generation + 1;
+}
+
+const uint8_t* PersistentCache::pixels_of(const Entry& entry) const {
+    if (!entry.owned.empty()) return entry.owned.data();
+    return file_ ? file_->data() + entry.offset : nullptr;
+}
+
+std::vector<std::pair<uint64_t, const PersistentCache::Entry*>>
+PersistentCache::by_recency() const {
+    std::vector<std::pair<uint64_t, const Entry*>> sorted;
+    sorted.reserve(entries_.size());
+    for (const auto& [key, entry] : entries_) {
+        sorted.emplace_back(key, &entry);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        if (a.second->last_used != b.second->last_used) {
+            return a.second->last_used > b.second->last_used;
+        }
+        return a.first < b.first;
+    });
+    return sorted;
+}
+
+std::vector<CachedBitmap> PersistentCache::offer(size_t max_count, uint64_t max_bytes) const {
+    std::vector<CachedBitmap> result;
+    uint64_t total = 0;
+    for (const auto& [key, entry] : by_recency()) {
+        if (result.size() >= max_count || total + entry->size() > max_bytes) break;
+        total += entry->size();
+        result.push_back({key, entry->width, entry->height, pixels_of(*entry)});
+    }
+    return result;
+}
+
+bool PersistentCache::find(uint64_t key, CachedBitmap& out) {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return false;
+
+    Entry& entry = it->second;
+    const uint8_t* pixels = pixels_of(entry);
+    if (!entry.verified) {
+        if (!pixels || checksum(pixels, entry.size()) != entry.checksum) {
+            bytes_ -= entry.size();
+            entries_.erase(it);
+            return false;
+        }
+        entry.verified = true;
+    }
+    entry.last_used = generation_;
+    out = {key, entry.width, entry.height, pixels};
+    return true;
+}
+
+void PersistentCache::put(uint64_t key, uint16_t width, uint16_t height, const uint8_t* pixels,
+                          size_t stride) {
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        // Keys are content hashes: same key, same pixels
+        it->second.last_used = generation_;
+        return;
+    }
+    if (!pixels || width == 0 || height == 0) return;
+
+    Entry entry;
+    entry.width = width;
+    entry.height = height;
+    entry.last_used = generation_;
+    entry.verified = true;
+    size_t row_bytes = static_cast<size_t>(width) * 4;
+    entry.owned.resize(entry.size());
+    for (uint16_t y = 0; y < height; y++) {
+        std::memcpy(entry.owned.data() + y * row_bytes, pixels + y * stride, row_bytes);
+    }
+    entry.checksum = checksum(entry.owned.data(), entry.owned.size());
+    bytes_ += entry.size();
+    entries_.emplace(key, std::move(entry));
+}
+
+bool PersistentCache::save() {
+    // Newest first, then cut at the limit: that drops the least recently used
+    auto kept = by_recency();
+    uint64_t total = 0;
+    size_t count = 0;
+    while (count < kept.size() && total + kept[count].second->size() <= limit_bytes_) {
+        total += kept[count].second->size();
+        count++;
+    }
+    kept.resize(count);
+
+    std::error_code ec;
+    std::filesystem::create_directories(path_.parent_path(), ec);
+    std::filesystem::path tmp = path_;
+    tmp += ".tmp";
+
+    std::vector<IndexRecord> index;
+    index.reserve(kept.size());
+    uint64_t offset = sizeof(FileHeader) + kept.size() * sizeof(IndexRecord);
+    for (const auto& [key, entry] : kept) {
+        index.push_back({key, offset, entry->last_used, entry->checksum, entry->width,
+                         entry->height});
+        offset += entry->size();
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.count = static_cast<uint32_t>(index.size());
+    header.generation = generation_;
+    header.index_checksum = checksum(reinterpret_cast<const uint8_t*>(index.data()),
+                                     index.size() * sizeof(IndexRecord));
+
+#if GVRDP_WINDOWS
+    FILE* file = _wfopen(tmp.c_str(), L"wb");
+#else
+    FILE* file = std::fopen(tmp.c_str(), "wb");
+#endif
+    if (!file) return false;
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && !index.empty()) {
+        ok = std::fwrite(index.data(), sizeof(IndexRecord), index.size(), file) == index.size();
+    }
+    for (size_t i = 0; ok && i < kept.size(); i++) {
+        const Entry& entry = *kept[i].second;
+        const uint8_t* pixels = pixels_of(entry);
+        ok = pixels && std::fwrite(pixels, 1, entry.size(), file) == entry.size();
+    }
+    ok = sync_file(file) && ok;
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+
+    // Windows cannot replace a file that is still mapped
+    file_.reset();
+    std::filesystem::rename(tmp, path_, ec);
+    if (ec) {
+        // The old file is still in place; keep serving from it
+        std::filesystem::remove(tmp, ec);
+        file_ = MappedFile::open(path_);
+        return false;
+    }
+    sync_directory(path_.parent_path());
+    load();
+    return true;
+}
+
+}  // namespace gvrdp
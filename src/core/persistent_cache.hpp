@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gvrdp {
+
+// A cached bitmap: 32bpp BGRX rows of width * 4 bytes. `pixels` points into
+// the store and stays valid until the next save().
+struct CachedBitmap {
+    uint64_t key = 0;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    const uint8_t* pixels = nullptr;
+
+    size_t size() const { return static_cast<size_t>(width) * height * 4; }
+};
+
+// On-disk bitmap cache for one server, keyed by the server's 64-bit cache
+// keys (RDPGFX cacheKey, a hash of the bitmap content).
+//
+// The file is a header, an index and the pixel data, memory-mapped read-only
+// while a session runs, so entries are served without reading the whole file.
+// New entries are held in memory. save() writes the used and new entries,
+// newest first, up to the size limit, to a temporary file. It then
+// renames that over the old one, so a crash never leaves a torn cache behind.
+// Entries unused for longest are the ones evicted.
+//
+// Not thread-safe; GfxPipeline uses it under the RDPGFX context lock.
+class PersistentCache {
+public:
+    // Opens the cache at `path`. A missing, truncated or foreign file is
+    // treated as empty (and replaced on save()).
+    PersistentCache(std::filesystem::path path, uint64_t limit_bytes);
+    ~PersistentCache();
+
+    PersistentCache(const PersistentCache&) = delete;
+    PersistentCache& operator=(const PersistentCache&) = delete;
+
+    // <dir>/<host>_<port>.gvc with the host name made filename-safe
+    static std::filesystem::path path_for(const std::filesystem::path& dir,
+                                          const std::string& host, uint16_t port);
+
+    // Entries to offer the server, most recently used first, stopping at
+    // max_count entries or max_bytes of pixel data
+    std::vector<CachedBitmap> offer(size_t max_count, uint64_t max_bytes) const;
+
+    // Looks an entry up and marks it used. Entries whose pixels fail their
+    // checksum are dropped. Returns false if missing.
+    bool find(uint64_t key, CachedBitmap& out);
+
+    // Adds an entry (copying `stride`-spaced rows), or marks an existing one used
+    void put(uint64_t key, uint16_t width, uint16_t height, const uint8_t* pixels,
+             size_t stride);
+
+    // Persists the cache as described above. The store stays usable.
+    bool save();
+
+    size_t size() const { return entries_.size(); }
+    uint64_t bytes() const { return bytes_; }
+    const std::filesystem::path& path() const { return path_; }
+
+private:
+    struct Entry {
+        uint16_t width = 0;
+        uint16_t height = 0;
+        uint64_t offset = 0;            // Into the mapping, when `owned` is empty
+        uint32_t checksum = 0;
+        uint64_t last_used = 0;         // Generation of the session that last used it
+        bool verified = false;
+        std::vector<uint8_t> owned;     // Pixels added this session
+
+        size_t size() const { return static_cast<size_t>(width) * height * 4; }
+    };
+
+    class MappedFile;
+
+    void load();
+    // Entries, most recently used first (ties by key, for stable files)
+    std::vector<std::pair<uint64_t, const Entry*>> by_recency() const;
+    const uint8_t* pixels_of(const Entry& entry) const;
+
+    std::filesystem::path path_;
+    uint64_t limit_bytes_;
+    std::unique_ptr<MappedFile> file_;
+    std::unordered_map<uint64_t, Entry> entries_;
+    uint64_t generation_ = 1;  // Of this session; the file holds generation_ - 1
+    uint64_t bytes_ = 0;
+};
+
+}  // namespace gvrdp
@@ -3,6 +3,7 @@
 #include "core/rdp_context.hpp"
 #include "core/rdp_session.hpp"
 #include "util/logger.hpp"
+#include "util/tracer.hpp"
 
 using namespace gvrdp;
 
@@ -36,23 +37,40 @@ void gvrdp_post_disconnect(freerdp* instance) {
 }
 
 BOOL gvrdp_begin_paint(rdpContext* context) {
+    TRACE_SCOPE("begin_paint");
     auto* session = get_session(context);
     if (!session) return FALSE;
     return session->on_begin_paint() ? TRUE : FALSE;
 }
 
 BOOL gvrdp_end_paint(rdpContext* context) {
+    TRACE_SCOPE("end_paint");
     auto* session = get_session(context);
     if (!session) return FALSE;
     return session->on_end_paint() ? TRUE : FALSE;
 }
 
 BOOL gvrdp_desktop_resize(rdpContext* context) {
+    TRACE_SCOPE("desktop_resize");
     auto* session = get_session(context);
     if (!session) return FALSE;
     return session->on_desktop_resize() ? TRUE : FALSE;
 }
 
+BOOL gvrdp_surface_bits(rdpContext* context, const SURFACE_BITS_COMMAND* cmd) {
+    TRACE_SCOPE("surface_bits");
+    auto* session = get_session(context);
+    if (!session) return FALSE;
+    return session->on_surface_bits(cmd) ? TRUE : FALSE;
+}
+
+BOOL gvrdp_bitmap_update(rdpContext* context, const BITMAP_UPDATE* bitmap) {
+    TRACE_SCOPE("bitmap_update");
+    auto* session = get_session(context);
+    if (!session) return FALSE;
+    return session->on_bitmap_update(bitmap) ? TRUE : FALSE;
+}
+
 DWORD gvrdp_verify_certificate_ex(freerdp* instance, const char* host, UINT16 port,
                                    const char* common_name, const char* subject,
                                    const char* issuer, const char* fingerprint, DWORD flags) {
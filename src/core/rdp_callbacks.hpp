@@ -14,6 +14,8 @@ void gvrdp_post_disconnect(freerdp* instance);
 BOOL gvrdp_begin_paint(rdpContext* context);
 BOOL gvrdp_end_paint(rdpContext* context);
 BOOL gvrdp_desktop_resize(rdpContext* context);
+BOOL gvrdp_surface_bits(rdpContext* context, const SURFACE_BITS_COMMAND* cmd);
+BOOL gvrdp_bitmap_update(rdpContext* context, const BITMAP_UPDATE* bitmap);
 DWORD gvrdp_verify_certificate_ex(freerdp* instance, const char* host, UINT16 port,
                                    const char* common_name, const char* subject,
                                    const char* issuer, const char* fingerprint, DWORD flags);
@@ -2,7 +2,9 @@
 
 #include "core/rdp_context.hpp"
 #include "core/rdp_session.hpp"
+#include "util/flight_recorder.hpp"
 #include "util/logger.hpp"
+#include "util/tracer.hpp"
 
 #include <freerdp/event.h>
 
@@ -11,19 +13,25 @@ using namespace gvrdp;
 extern "C" {
 
 void gvrdp_on_channel_connected(void* context, const ChannelConnectedEventArgs* e) {
+    TRACE_SCOPE("channel_connected");
     auto* ctx = reinterpret_cast<rdpContext*>(context);
     auto* session = reinterpret_cast<GvrdpContext*>(ctx)->session;
     if (session && e) {
         LOG_INFO("Channel connected: {}", e->name);
+        FlightRecorder::record(FlightEvent::ChannelConnected, 0,
+                               FlightRecorder::pack_name(e->name));
         session->on_channel_connected(e->name, e->pInterface);
     }
 }
 
 void gvrdp_on_channel_disconnected(void* context, const ChannelDisconnectedEventArgs* e) {
+    TRACE_SCOPE("channel_disconnected");
     auto* ctx = reinterpret_cast<rdpContext*>(context);
     auto* session = reinterpret_cast<GvrdpContext*>(ctx)->session;
     if (session && e) {
         LOG_INFO("Channel disconnected: {}", e->name);
+        FlightRecorder::record(FlightEvent::ChannelDisconnected, 0,
+                               FlightRecorder::pack_name(e->name));
         session->on_channel_disconnected(e->name, e->pInterface);
     }
 }
@@ -6,12 +6,14 @@
 namespace gvrdp {
 
 class RdpSession;
+class UpdateProfiler;
 
 // Custom context extending rdpClientContext.
 // MUST have rdpClientContext as first member for C-style inheritance.
 struct GvrdpContext {
     rdpClientContext common;  // Must be first
     RdpSession* session;     // Back-pointer to C++ session object
+    UpdateProfiler* profiler;  // Set while update profiling is on
 };
 
 }  // namespace gvrdp
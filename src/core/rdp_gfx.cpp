@@ -0,0 +1,1212 @@
+#include "core/rdp_gfx.hpp"
+
+#include "channels/channel_interface.hpp"
+#include "core/rdp_context.hpp"
+#include "core/rdp_session.hpp"
+#include "util/flight_recorder.hpp"
+#include "util/logger.hpp"
+#include "util/metrics.hpp"
+#include "util/tracer.hpp"
+
+#include <freerdp/cache/persistent.h>
+#include <freerdp/codec/color.h>
+#include <freerdp/codec/planar.h>
+#include <freerdp/codec/region.h>
+#include <freerdp/gdi/gfx.h>
+#include <freerdp/primitives.h>
+#include <winpr/synch.h>
+
+#include <SDL2/SDL_pixels.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace gvrdp {
+
+// Holds the RDPGFX context lock for the duration of a wrapped callback, so
+// resync() on the main thread never sees a half-applied operation.
+class GfxLock {
+public:
+    explicit GfxLock(RdpgfxClientContext* context) : context_(context) {
+        EnterCriticalSection(&context_->mux);
+    }
+    ~GfxLock() { LeaveCriticalSection(&context_->mux); }
+
+    GfxLock(const GfxLock&) = delete;
+    GfxLock& operator=(const GfxLock&) = delete;
+
+private:
+    RdpgfxClientContext* context_;
+};
+
+static gdiGfxSurface* get_surface(RdpgfxClientContext* context, uint16_t surface_id) {
+    if (!context->GetSurfaceData) return nullptr;
+    return static_cast<gdiGfxSurface*>(context->GetSurfaceData(context, surface_id));
+}
+
+static Rect to_rect(const RECTANGLE_16& r) {
+    if (r.right <= r.left || r.bottom <= r.top) return {};
+    return {r.left, r.top, static_cast<uint32_t>(r.right - r.left),
+            static_cast<uint32_t>(r.bottom - r.top)};
+}
+
+static Rect command_rect(const RDPGFX_SURFACE_COMMAND* cmd) {
+    if (cmd->right <= cmd->left || cmd->bottom <= cmd->top) return {};
+    return {cmd->left, cmd->top, cmd->right - cmd->left, cmd->bottom - cmd->top};
+}
+
+// Grows a rect to even coordinates (4:2:0 chroma covers 2x2 pixels), clipped
+// to a limit that is itself even
+static Rect align_to_chroma(const Rect& rect, uint32_t limit_w, uint32_t limit_h) {
+    uint32_t x = rect.x & ~1u;
+    uint32_t y = rect.y & ~1u;
+    uint32_t right = std::min((rect.right() + 1) & ~1u, limit_w & ~1u);
+    uint32_t bottom = std::min((rect.bottom() + 1) & ~1u, limit_h & ~1u);
+    if (right <= x || bottom <= y) return {};
+    return {x, y, right - x, bottom - y};
+}
+
+// Stale AVC areas tracked per surface before everything is converted at once
+static constexpr size_t kMaxStaleRects = 64;
+
+static Codec codec_for(UINT16 codec_id) {
+    switch (codec_id) {
+        case RDPGFX_CODECID_UNCOMPRESSED: return Codec::Uncompressed;
+        case RDPGFX_CODECID_CAVIDEO: return Codec::RemoteFx;
+        case RDPGFX_CODECID_CLEARCODEC: return Codec::ClearCodec;
+        case RDPGFX_CODECID_PLANAR: return Codec::Planar;
+        case RDPGFX_CODECID_AVC420: return Codec::Avc420;
+        case RDPGFX_CODECID_AVC444:
+        case RDPGFX_CODECID_AVC444v2: return Codec::Avc444;
+        case RDPGFX_CODECID_ALPHA: return Codec::Alpha;
+        case RDPGFX_CODECID_CAPROGRESSIVE:
+        case RDPGFX_CODECID_CAPROGRESSIVE_V2: return Codec::Progressive;
+        default: return Codec::Count;
+    }
+}
+
+GfxPipeline::GfxPipeline(FrameCallback on_frame, const Options& options)
+    : on_frame_(std::move(on_frame)),
+      stats_(options.stats),
+      gpu_yuv_(options.gpu_yuv && H264Decoder::available()),
+      cache_path_(options.cache_path),
+      cache_limit_bytes_(options.cache_limit_bytes),
+      ack_window_(options.ack_window),
+      max_surface_size_(options.max_surface_size) {
+    if (options.decode_threads != 1) {
+        decoders_ = std::make_unique<WorkerPool>(options.decode_threads);
+        if (decoders_->size() < 2) decoders_.reset();
+    }
+}
+
+GfxPipeline::~GfxPipeline() {
+    detach();
+}
+
+GfxPipeline* GfxPipeline::from_context(RdpgfxClientContext* context) {
+    // context->custom belongs to FreeRDP's GDI; find ourselves through it
+    auto* gdi = static_cast<rdpGdi*>(context->custom);
+    if (!gdi || !gdi->context) return nullptr;
+    RdpSession* session = reinterpret_cast<GvrdpContext*>(gdi->context)->session;
+    return session ? session->gfx_pipeline() : nullptr;
+}
+
+bool GfxPipeline::attach(rdpGdi* gdi, RdpgfxClientContext* gfx) {
+    if (!gdi || !gfx) return false;
+    std::lock_guard lock(lifecycle_mutex_);
+
+    if (!gdi_graphics_pipeline_init(gdi, gfx)) {
+        LOG_ERROR("gdi_graphics_pipeline_init failed");
+        return false;
+    }
+
+    gdi_ = gdi;
+    gfx_ = gfx;
+
+    reset_graphics_ = gfx->ResetGraphics;
+    start_frame_ = gfx->StartFrame;
+    end_frame_ = gfx->EndFrame;
+    surface_command_ = gfx->SurfaceCommand;
+    create_surface_ = gfx->CreateSurface;
+    delete_surface_ = gfx->DeleteSurface;
+    solid_fill_ = gfx->SolidFill;
+    surface_to_surface_ = gfx->SurfaceToSurface;
+    surface_to_cache_ = gfx->SurfaceToCache;
+    cache_to_surface_ = gfx->CacheToSurface;
+    evict_cache_entry_ = gfx->EvictCacheEntry;
+    map_surface_to_output_ = gfx->MapSurfaceToOutput;
+    update_surfaces_ = gfx->UpdateSurfaces;
+    on_open_ = gfx->OnOpen;
+    caps_confirm_ = gfx->CapsConfirm;
+    cache_import_reply_ = gfx->CacheImportReply;
+
+    gfx->ResetGraphics = on_reset_graphics;
+    gfx->StartFrame = on_start_frame;
+    gfx->EndFrame = on_end_frame;
+    gfx->SurfaceCommand = on_surface_command;
+    gfx->CreateSurface = on_create_surface;
+    gfx->DeleteSurface = on_delete_surface;
+    gfx->SolidFill = on_solid_fill;
+    gfx->SurfaceToSurface = on_surface_to_surface;
+    gfx->SurfaceToCache = on_surface_to_cache;
+    gfx->CacheToSurface = on_cache_to_surface;
+    gfx->EvictCacheEntry = on_evict_cache_entry;
+    gfx->MapSurfaceToOutput = on_map_surface_to_output;
+    gfx->UpdateSurfaces = on_update_surfaces;
+    gfx->OnOpen = on_open;
+    gfx->CapsConfirm = on_caps_confirm;
+    gfx->CacheImportReply = on_cache_import_reply;
+
+    if (!cache_path_.empty() && cache_limit_bytes_ > 0) {
+        cache_ = std::make_unique<PersistentCache>(cache_path_, cache_limit_bytes_);
+        cache_offered_ = false;
+        LOG_INFO("Persistent GFX cache: {} ({} entries, {} KiB)", cache_path_.string(),
+                 cache_->size(), cache_->bytes() / 1024);
+    }
+
+    manual_acks_ = false;
+    qoe_ = false;
+    gdi_fallback_ = false;
+    frames_decoded_ = 0;
+    unpresented_ = 0;
+    active_ = true;
+    LOG_INFO("RDPGFX pipeline attached (GPU surface composition{})",
+             gpu_yuv_ ? ", GPU YUV conversion" : "");
+    return true;
+}
+
+void GfxPipeline::detach() {
+    std::lock_guard lock(lifecycle_mutex_);
+    if (!gfx_) return;
+
+    active_ = false;
+    {
+        GfxLock lock(gfx_);
+        drain();
+        collect_cache();
+    }
+    restore_callbacks();
+
+    gdi_graphics_pipeline_uninit(gdi_, gfx_);
+    gfx_ = nullptr;
+    gdi_ = nullptr;
+    pending_.clear();
+    avc_.clear();
+    offered_.clear();
+    slot_keys_.clear();
+
+    if (cache_) {
+        if (cache_->save()) {
+            LOG_INFO("Persistent GFX cache saved ({} entries, {} KiB)", cache_->size(),
+                     cache_->bytes() / 1024);
+        } else {
+            LOG_WARN("Failed to save persistent GFX cache {}", cache_path_.string());
+        }
+        cache_.reset();
+    }
+    LOG_INFO("RDPGFX pipeline detached");
+}
+
+void GfxPipeline::restore_callbacks() {
+    gfx_->ResetGraphics = reset_graphics_;
+    gfx_->StartFrame = start_frame_;
+    gfx_->EndFrame = end_frame_;
+    gfx_->SurfaceCommand = surface_command_;
+    gfx_->CreateSurface = create_surface_;
+    gfx_->DeleteSurface = delete_surface_;
+    gfx_->SolidFill = solid_fill_;
+    gfx_->SurfaceToSurface = surface_to_surface_;
+    gfx_->SurfaceToCache = surface_to_cache_;
+    gfx_->CacheToSurface = cache_to_surface_;
+    gfx_->EvictCacheEntry = evict_cache_entry_;
+    gfx_->MapSurfaceToOutput = map_surface_to_output_;
+    gfx_->UpdateSurfaces = update_surfaces_;
+    gfx_->OnOpen = on_open_;
+    gfx_->CapsConfirm = caps_confirm_;
+    gfx_->CacheImportReply = cache_import_reply_;
+}
+
+void GfxPipeline::fall_back_to_gdi(RdpgfxClientContext* context, uint32_t width,
+                                   uint32_t height) {
+    LOG_WARN("RDPGFX surface {}x{} exceeds the {} px texture limit, composing in the GDI "
+             "buffer for the rest of the session",
+             width, height, max_surface_size_);
+    drain();
+    // The CPU surfaces become what is shown: bring the AVC areas up to date
+    for (auto& [id, avc] : avc_) {
+        materialize_all(id);
+    }
+    avc_.clear();
+    pending_.clear();
+    // Cache slots are no longer tracked; keep them out of the persistent store
+    slot_keys_.clear();
+
+    // The main thread stops replaying batches; acknowledge the ones it never will
+    while (std::optional<GfxBatch> batch = batches_.try_pop()) {
+        if (!batch->frame) continue;
+        if (unpresented_ > 0) unpresented_--;
+        if (manual_acks_ && !batch->frame->acknowledged) send_frame_ack(context, batch->frame_id);
+    }
+
+    restore_callbacks();
+    // Still ours: FreeRDP's acks stay off, so frames are acknowledged on arrival
+    gfx_->EndFrame = on_end_frame;
+    gdi_fallback_ = true;
+
+    // FreeRDP's UpdateSurfaces copies invalid areas to the GDI buffer; make
+    // that everything, so surfaces the server does not redraw appear too
+    UINT16* ids = nullptr;
+    UINT16 count = 0;
+    if (context->GetSurfaceIds && context->GetSurfaceIds(context, &ids, &count) == CHANNEL_RC_OK) {
+        for (UINT16 i = 0; i < count; i++) {
+            gdiGfxSurface* surface = get_surface(context, ids[i]);
+            if (!surface) continue;
+            RECTANGLE_16 all = {0, 0, static_cast<UINT16>(surface->width),
+                                static_cast<UINT16>(surface->height)};
+            region16_union_rect(&surface->invalidRegion, &surface->invalidRegion, &all);
+        }
+        free(ids);
+    }
+    if (on_frame_) on_frame_();
+}
+
+bool GfxPipeline::too_large(uint32_t width, uint32_t height) const {
+    return max_surface_size_ > 0 && (width > max_surface_size_ || height > max_surface_size_);
+}
+
+void GfxPipeline::resync() {
+    std::lock_guard guard(lifecycle_mutex_);
+    if (!active_ || gdi_fallback_ || !gfx_) return;
+    GfxLock lock(gfx_);
+
+    // The CPU surfaces (once decodes finish and AVC output is caught up)
+    // reflect everything still pending
+    drain();
+    pending_.clear();
+    for (auto& [id, avc] : avc_) {
+        materialize_all(id);
+    }
+
+    GfxBatch batch;
+    GfxCommand reset;
+    reset.type = GfxCommand::Type::ResetGraphics;
+    reset.rect = {0, 0, output_width_, output_height_};
+    batch.commands.push_back(std::move(reset));
+
+    UINT16* ids = nullptr;
+    UINT16 count = 0;
+    if (gfx_->GetSurfaceIds && gfx_->GetSurfaceIds(gfx_, &ids, &count) == CHANNEL_RC_OK) {
+        for (UINT16 i = 0; i < count; i++) {
+            gdiGfxSurface* surface = get_surface(gfx_, ids[i]);
+            if (!surface) continue;
+
+            GfxCommand create;
+            create.type = GfxCommand::Type::CreateSurface;
+            create.surface_id = ids[i];
+            create.rect = {0, 0, surface->width, surface->height};
+            batch.commands.push_back(std::move(create));
+
+            if (surface->outputMapped) {
+                GfxCommand map;
+                map.type = GfxCommand::Type::MapSurfaceToOutput;
+                map.surface_id = ids[i];
+                map.rect = {surface->outputOriginX, surface->outputOriginY, surface->width,
+                            surface->height};
+                batch.commands.push_back(std::move(map));
+            }
+            record_upload(ids[i], Rect{0, 0, surface->width, surface->height});
+        }
+        free(ids);
+    }
+
+    for (uint16_t slot = 1; slot <= RDPGFX_CACHE_ENTRY_MAX_COUNT; slot++) {
+        record_cache_import(slot);
+    }
+
+    // record_upload() and record_cache_import() queued into pending_
+    for (auto& command : pending_) {
+        batch.commands.push_back(std::move(command));
+    }
+    pending_.clear();
+
+    LOG_INFO("RDPGFX resync: {} commands", batch.commands.size());
+    batches_.push(std::move(batch));
+    if (on_frame_) on_frame_();
+}
+
+// ── Frame acknowledgement ─────────────────────────────────────────────
+
+std::optional<GfxBatch> GfxPipeline::pop_batch() {
+    std::optional<GfxBatch> batch = batches_.try_pop();
+    if (batch && batch->frame) popped_.emplace_back(batch->frame_id, *batch->frame);
+    return batch;
+}
+
+bool GfxPipeline::send_frame_ack(RdpgfxClientContext* context, uint32_t frame_id) {
+    if (!context->FrameAcknowledge) return false;
+    RDPGFX_FRAME_ACKNOWLEDGE_PDU ack{};
+    ack.frameId = frame_id;
+    ack.totalFramesDecoded = frames_decoded_;
+    // Frames decoded but not yet on screen (0 also means "unavailable")
+    ack.queueDepth = unpresented_;
+    return context->FrameAcknowledge(context, &ack) == CHANNEL_RC_OK;
+}
+
+void GfxPipeline::acknowledge_presented() {
+    if (popped_.empty()) return;
+    std::lock_guard guard(lifecycle_mutex_);
+    if (!active_ || !gfx_ || !manual_acks_) {
+        popped_.clear();
+        return;
+    }
+
+    // Under the context lock, like on_end_frame()'s early acks, so the two
+    // threads' PDUs and the counters they report never interleave
+    GfxLock lock(gfx_);
+    using namespace std::chrono;
+    auto now = steady_clock::now();
+    auto to_ms16 = [](auto duration) {
+        return static_cast<UINT16>(
+            std::clamp<int64_t>(duration_cast<milliseconds>(duration).count(), 0, UINT16_MAX));
+    };
+    for (const auto& [frame_id, info] : popped_) {
+        if (unpresented_ > 0) unpresented_--;
+        if (!info.acknowledged) send_frame_ack(gfx_, frame_id);
+
+        if (qoe_ && gfx_->QoeFrameAcknowledge) {
+            RDPGFX_QOE_FRAME_ACKNOWLEDGE_PDU qoe{};
+            qoe.frameId = frame_id;
+            // When decoding started, as MS-RDPEGFX defines it
+            qoe.timestamp = static_cast<UINT32>(
+                duration_cast<milliseconds>(info.started.time_since_epoch()).count());
+            qoe.timeDiffSE = to_ms16(info.decode_time);
+            qoe.timeDiffEDR = to_ms16(now - info.ended);
+            gfx_->QoeFrameAcknowledge(gfx_, &qoe);
+        }
+    }
+    popped_.clear();
+}
+
+// ── Recording helpers (channel thread, context lock held) ─────────────
+
+void GfxPipeline::record(GfxCommand command) {
+    pending_.push_back(std::move(command));
+}
+
+void GfxPipeline::flush(uint32_t frame_id, std::optional<GfxFrameInfo> frame) {
+    GfxBatch batch;
+    batch.frame_id = frame_id;
+    batch.frame = frame;
+    batch.commands = std::move(pending_);
+    pending_.clear();
+    batches_.push(std::move(batch));
+    if (on_frame_) on_frame_();
+}
+
+void GfxPipeline::clear_invalid(uint16_t surface_id) {
+    gdiGfxSurface* surface = get_surface(gfx_, surface_id);
+    if (surface) region16_clear(&surface->invalidRegion);
+}
+
+void GfxPipeline::record_upload(uint16_t surface_id, const Rect& rect) {
+    gdiGfxSurface* surface = get_surface(gfx_, surface_id);
+    if (!surface || !surface->data) return;
+
+    Rect clipped = rect;
+    if (clipped.x >= surface->width || clipped.y >= surface->height) return;
+    clipped.width = std::min(clipped.width, surface->width - clipped.x);
+    clipped.height = std::min(clipped.height, surface->height - clipped.y);
+    if (clipped.empty()) return;
+
+    GfxCommand upload;
+    upload.type = GfxCommand::Type::Upload;
+    upload.surface_id = surface_id;
+    upload.rect = clipped;
+    size_t row_bytes = static_cast<size_t>(clipped.width) * 4;
+    upload.pixels.resize(row_bytes * clipped.height);
+    const BYTE* src = surface->data + static_cast<size_t>(clipped.y) * surface->scanline +
+                      static_cast<size_t>(clipped.x) * 4;
+    for (uint32_t y = 0; y < clipped.height; y++) {
+        std::memcpy(upload.pixels.data() + y * row_bytes, src + y * surface->scanline,
+                    row_bytes);
+    }
+    record(std::move(upload));
+}
+
+void GfxPipeline::record_cache_import(uint16_t cache_slot) {
+    if (!gfx_->GetCacheSlotData) return;
+    auto* entry = static_cast<gdiGfxCacheEntry*>(gfx_->GetCacheSlotData(gfx_, cache_slot));
+    if (!entry || !entry->data || entry->width == 0 || entry->height == 0) return;
+
+    GfxCommand import;
+    import.type = GfxCommand::Type::ImportCacheEntry;
+    import.cache_slot = cache_slot;
+    import.rect = {0, 0, entry->width, entry->height};
+    size_t row_bytes = static_cast<size_t>(entry->width) * 4;
+    import.pixels.resize(row_bytes * entry->height);
+    for (uint32_t y = 0; y < entry->height; y++) {
+        std::memcpy(import.pixels.data() + y * row_bytes,
+                    entry->data + static_cast<size_t>(y) * entry->scanline, row_bytes);
+    }
+    record(std::move(import));
+}
+
+void GfxPipeline::record_invalid_uploads(uint16_t surface_id) {
+    gdiGfxSurface* surface = get_surface(gfx_, surface_id);
+    if (!surface) return;
+
+    UINT32 count = 0;
+    const RECTANGLE_16* rects = region16_rects(&surface->invalidRegion, &count);
+    for (UINT32 i = 0; i < count; i++) {
+        record_upload(surface_id, to_rect(rects[i]));
+    }
+    region16_clear(&surface->invalidRegion);
+}
+
+// ── Persistent cache (channel thread, context lock held) ──────────────
+
+void GfxPipeline::offer_cache(RdpgfxClientContext* context,
+                              const RDPGFX_CAPS_CONFIRM_PDU* confirm) {
+    // One offer per connection, and only for a cache we can fill from
+    if (!cache_ || cache_offered_ || !context->CacheImportOffer) return;
+    cache_offered_ = true;
+
+    // The offer must fit in the server's cache (MS-RDPEGFX 2.2.2.16)
+    bool small_cache = confirm && confirm->capsSet &&
+                       (confirm->capsSet->flags & RDPGFX_CAPS_FLAG_SMALL_CACHE);
+    uint64_t max_bytes = (small_cache ? 16ull : 100ull) << 20;
+    std::vector<CachedBitmap> entries = cache_->offer(RDPGFX_CACHE_ENTRY_MAX_COUNT, max_bytes);
+    if (entries.empty()) return;
+
+    auto offer = std::make_unique<RDPGFX_CACHE_IMPORT_OFFER_PDU>();
+    offered_.clear();
+    for (const auto& entry : entries) {
+        RDPGFX_CACHE_ENTRY_METADATA& meta = offer->cacheEntries[offer->cacheEntriesCount++];
+        meta.cacheKey = entry.key;
+        meta.bitmapLength = static_cast<UINT32>(entry.size());
+        offered_.push_back(entry.key);
+    }
+    UINT status = context->CacheImportOffer(context, offer.get());
+    if (status != CHANNEL_RC_OK) {
+        LOG_WARN("RDPGFX cache import offer failed ({})", status);
+        offered_.clear();
+        return;
+    }
+    LOG_INFO("RDPGFX cache import: offered {} entries", offered_.size());
+}
+
+void GfxPipeline::collect_cache() {
+    if (!cache_ || !gfx_->GetCacheSlotData) return;
+
+    // The store holds BGRX32, which is what FreeRDP's ImportCacheEntry expects
+    std::vector<uint8_t> converted;
+    for (const auto& [slot, key] : slot_keys_) {
+        auto* entry = static_cast<gdiGfxCacheEntry*>(gfx_->GetCacheSlotData(gfx_, slot));
+        if (!entry || !entry->data || entry->width == 0 || entry->height == 0 ||
+            entry->width > UINT16_MAX || entry->height > UINT16_MAX) {
+            continue;
+        }
+        const BYTE* pixels = entry->data;
+        size_t stride = entry->scanline;
+        if (entry->format != PIXEL_FORMAT_BGRX32 && entry->format != PIXEL_FORMAT_BGRA32) {
+            converted.resize(static_cast<size_t>(entry->width) * entry->height * 4);
+            if (!freerdp_image_copy(converted.data(), PIXEL_FORMAT_BGRX32, entry->width * 4, 0, 0,
+                                    entry->width, entry->height, entry->data, entry->format,
+                                    entry->scanline, 0, 0, nullptr, FREERDP_FLIP_NONE)) {
+                continue;
+            }
+            pixels = converted.data();
+            stride = static_cast<size_t>(entry->width) * 4;
+        }
+        cache_->put(key, static_cast<uint16_t>(entry->width), static_cast<uint16_t>(entry->height),
+                    pixels, stride);
+    }
+    slot_keys_.clear();
+}
+
+// ── Parallel decode (channel thread, context lock held) ───────────────
+
+using PlanarContext = std::unique_ptr<BITMAP_PLANAR_CONTEXT,
+                                      decltype(&freerdp_bitmap_planar_context_free)>;
+
+static bool decode_tile(UINT32 codec_id, const std::vector<uint8_t>& data, UINT32 src_format,
+                        uint32_t width, uint32_t height, BYTE* dst, UINT32 dst_format,
+                        UINT32 dst_stride, uint32_t x, uint32_t y) {
+    if (codec_id == RDPGFX_CODECID_UNCOMPRESSED) {
+        size_t needed = static_cast<size_t>(FreeRDPGetBytesPerPixel(src_format)) * width * height;
+        if (data.size() < needed) return false;
+        return freerdp_image_copy(dst, dst_format, dst_stride, x, y, width, height, data.data(),
+                                  src_format, 0, 0, 0, nullptr, FREERDP_FLIP_NONE);
+    }
+
+    // Planar keeps scratch planes in its context: one per worker thread
+    thread_local PlanarContext planar(nullptr, freerdp_bitmap_planar_context_free);
+    if (!planar) planar.reset(freerdp_bitmap_planar_context_new(0, width, height));
+    if (!planar || !freerdp_bitmap_planar_context_reset(planar.get(), width, height)) return false;
+    return planar_decompress(planar.get(), data.data(), static_cast<UINT32>(data.size()), width,
+                             height, dst, dst_format, dst_stride, x, y, width, height, FALSE);
+}
+
+UINT GfxPipeline::submit_decode(RdpgfxClientContext* context,
+                                const RDPGFX_SURFACE_COMMAND* cmd) {
+    auto surface_id = static_cast<uint16_t>(cmd->surfaceId);
+    gdiGfxSurface* surface = get_surface(context, surface_id);
+    if (!surface || !surface->data) return ERROR_NOT_FOUND;
+    if (cmd->right > surface->width || cmd->bottom > surface->height) return ERROR_INVALID_DATA;
+
+    Rect rect = command_rect(cmd);
+    if (rect.empty()) return CHANNEL_RC_OK;
+
+    // Overlapping tiles must land in order
+    bool overlaps = std::any_of(in_flight_.begin(), in_flight_.end(), [&](const auto& job) {
+        return job->surface_id == surface_id && job->rect.intersects(rect);
+    });
+    auto avc = avc_.find(surface_id);
+    bool stale = avc != avc_.end() &&
+                 std::any_of(avc->second.stale.begin(), avc->second.stale.end(),
+                             [&](const Rect& r) { return r.intersects(rect); });
+    if (overlaps || stale) drain();
+    materialize(surface_id, rect);
+
+    auto job = std::make_shared<DecodeJob>();
+    job->surface_id = surface_id;
+    job->rect = rect;
+    in_flight_.push_back(job);
+
+    // The PDU buffer is only valid during this callback. The surface itself
+    // outlives the job: deleting it drains first.
+    decoders_->submit([job, stats = stats_, codec_id = cmd->codecId,
+                       data = std::vector<uint8_t>(cmd->data, cmd->data + cmd->length),
+                       src_format = cmd->format, dst = surface->data,
+                       dst_format = surface->format, dst_stride = surface->scanline] {
+        CodecStats::Scope timing(stats, codec_for(static_cast<UINT16>(codec_id)), data.size());
+        TRACE_SCOPE("decode_tile");
+        job->ok = decode_tile(codec_id, data, src_format, job->rect.width, job->rect.height,
+                              dst, dst_format, dst_stride, job->rect.x, job->rect.y);
+    });
+    return CHANNEL_RC_OK;
+}
+
+void GfxPipeline::drain() {
+    if (in_flight_.empty()) return;
+    decoders_->wait_idle();
+    for (const auto& job : in_flight_) {
+        if (job->ok) {
+            record_upload(job->surface_id, job->rect);
+        } else {
+            LOG_WARN("Failed to decode {}x{} tile on surface {}", job->rect.width,
+                     job->rect.height, job->surface_id);
+        }
+    }
+    in_flight_.clear();
+}
+
+// ── AVC420 on the GPU (channel thread, context lock held) ─────────────
+
+UINT GfxPipeline::surface_command_avc420(RdpgfxClientContext* context,
+                                         const RDPGFX_SURFACE_COMMAND* cmd) {
+    auto surface_id = static_cast<uint16_t>(cmd->surfaceId);
+    gdiGfxSurface* surface = get_surface(context, surface_id);
+    auto* bitstream = static_cast<const RDPGFX_AVC420_BITMAP_STREAM*>(cmd->extra);
+    if (!surface || !bitstream) return ERROR_NOT_FOUND;
+
+    AvcSurface& avc = avc_[surface_id];
+    if (!avc.decoder) {
+        avc.decoder = H264Decoder::create();
+        if (!avc.decoder) {
+            LOG_ERROR("No H.264 decoder for surface {}", surface_id);
+            return ERROR_INTERNAL_ERROR;
+        }
+    }
+
+    // Tracking too many disjoint areas costs more than converting them
+    if (avc.stale.size() >= kMaxStaleRects) {
+        materialize_all(surface_id);
+    }
+
+    const YuvPicture* picture = avc.decoder->decode(bitstream->data, bitstream->length);
+    if (!picture) {
+        // Drop the frame rather than the session; the next IDR repairs it
+        return CHANNEL_RC_OK;
+    }
+
+    std::vector<Rect> regions;
+    const RDPGFX_H264_METABLOCK& meta = bitstream->meta;
+    for (UINT32 i = 0; i < meta.numRegionRects; i++) {
+        Rect rect = to_rect(meta.regionRects[i]);
+        if (rect.x >= surface->width || rect.y >= surface->height) continue;
+        rect.width = std::min(rect.width, surface->width - rect.x);
+        rect.height = std::min(rect.height, surface->height - rect.y);
+        if (rect.empty()) continue;
+        regions.push_back(rect);
+
+        bool covered = std::any_of(avc.stale.begin(), avc.stale.end(),
+                                   [&](const Rect& stale) { return stale.contains(rect); });
+        if (!covered) avc.stale.push_back(rect);
+    }
+    record_yuv_upload(surface_id, *picture, regions);
+    return CHANNEL_RC_OK;
+}
+
+void GfxPipeline::record_yuv_upload(uint16_t surface_id, const YuvPicture& picture,
+                                    const std::vector<Rect>& regions) {
+    if (regions.empty()) return;
+
+    Rect bounds = regions.front();
+    for (const auto& rect : regions) {
+        bounds = bounds.united(rect);
+    }
+    // Only the planes under the changed regions are copied and uploaded
+    Rect area = align_to_chroma(bounds, picture.width, picture.height);
+    if (area.empty()) return;
+
+    GfxCommand upload;
+    upload.type = GfxCommand::Type::UploadYuv;
+    upload.surface_id = surface_id;
+    upload.rect = area;
+    upload.rects = regions;
+
+    size_t luma = static_cast<size_t>(area.width) * area.height;
+    upload.pixels.resize(luma + luma / 2);
+    uint8_t* out = upload.pixels.data();
+    auto copy_plane = [&](int plane, uint32_t x_bytes, uint32_t y, uint32_t row_bytes,
+                          uint32_t rows) {
+        const uint8_t* src = picture.planes[plane] +
+                             static_cast<size_t>(y) * static_cast<size_t>(picture.pitches[plane]) +
+                             x_bytes;
+        for (uint32_t row = 0; row < rows; row++) {
+            std::memcpy(out, src + static_cast<size_t>(row) * picture.pitches[plane], row_bytes);
+            out += row_bytes;
+        }
+    };
+
+    copy_plane(0, area.x, area.y, area.width, area.height);
+    if (picture.layout == YuvPicture::Layout::I420) {
+        upload.yuv_format = SDL_PIXELFORMAT_IYUV;
+        copy_plane(1, area.x / 2, area.y / 2, area.width / 2, area.height / 2);
+        copy_plane(2, area.x / 2, area.y / 2, area.width / 2, area.height / 2);
+    } else {
+        upload.yuv_format = SDL_PIXELFORMAT_NV12;
+        copy_plane(1, area.x, area.y / 2, area.width, area.height / 2);
+    }
+    record(std::move(upload));
+}
+
+void GfxPipeline::materialize(uint16_t surface_id, const Rect& area) {
+    auto it = avc_.find(surface_id);
+    if (it == avc_.end() || it->second.stale.empty() || area.empty()) return;
+
+    AvcSurface& avc = it->second;
+    gdiGfxSurface* surface = get_surface(gfx_, surface_id);
+    const YuvPicture* picture = avc.decoder ? avc.decoder->picture() : nullptr;
+    if (!surface || !surface->data || !picture) {
+        avc.stale.clear();
+        return;
+    }
+
+    primitives_t* prims = primitives_get();
+    std::vector<uint8_t> rgb;
+    std::vector<uint8_t> chroma;
+    auto next = avc.stale.begin();
+    for (auto stale = avc.stale.begin(); stale != avc.stale.end(); ++stale) {
+        if (!stale->intersects(area)) {
+            *next++ = *stale;
+            continue;
+        }
+
+        // Convert the chroma-aligned area, then copy back only the stale pixels
+        Rect aligned = align_to_chroma(*stale, picture->width, picture->height);
+        if (!aligned.contains(*stale)) continue;
+
+        const BYTE* planes[3];
+        UINT32 steps[3];
+        planes[0] = picture->planes[0] + static_cast<size_t>(aligned.y) * picture->pitches[0] +
+                    aligned.x;
+        steps[0] = static_cast<UINT32>(picture->pitches[0]);
+        if (picture->layout == YuvPicture::Layout::I420) {
+            for (int p = 1; p < 3; p++) {
+                planes[p] = picture->planes[p] +
+                            static_cast<size_t>(aligned.y / 2) * picture->pitches[p] +
+                            aligned.x / 2;
+                steps[p] = static_cast<UINT32>(picture->pitches[p]);
+            }
+        } else {
+            // Split interleaved UV so the I420 primitive can be used
+            uint32_t cw = aligned.width / 2;
+            uint32_t ch = aligned.height / 2;
+            chroma.resize(static_cast<size_t>(cw) * ch * 2);
+            uint8_t* u = chroma.data();
+            uint8_t* v = u + static_cast<size_t>(cw) * ch;
+            for (uint32_t row = 0; row < ch; row++) {
+                const uint8_t* uv = picture->planes[1] +
+                                    static_cast<size_t>(aligned.y / 2 + row) * picture->pitches[1] +
+                                    aligned.x;
+                for (uint32_t col = 0; col < cw; col++) {
+                    u[row * cw + col] = uv[col * 2];
+                    v[row * cw + col] = uv[col * 2 + 1];
+                }
+            }
+            planes[1] = u;
+            planes[2] = v;
+            steps[1] = cw;
+            steps[2] = cw;
+        }
+
+        UINT32 rgb_stride = aligned.width * 4;
+        rgb.resize(static_cast<size_t>(rgb_stride) * aligned.height);
+        prim_size_t roi = {aligned.width, aligned.height};
+        if (prims->YUV420ToRGB_8u_P3AC4R(planes, steps, rgb.data(), rgb_stride, surface->format,
+                                         &roi) != PRIMITIVES_SUCCESS) {
+            continue;
+        }
+
+        const Rect& dst = *stale;  // Clipped to the surface when recorded
+        size_t row_bytes = static_cast<size_t>(dst.width) * 4;
+        for (uint32_t row = 0; row < dst.height; row++) {
+            std::memcpy(surface->data + static_cast<size_t>(dst.y + row) * surface->scanline +
+                            static_cast<size_t>(dst.x) * 4,
+                        rgb.data() + static_cast<size_t>(dst.y - aligned.y + row) * rgb_stride +
+                            static_cast<size_t>(dst.x - aligned.x) * 4,
+                        row_bytes);
+        }
+    }
+    avc.stale.erase(next, avc.stale.end());
+}
+
+void GfxPipeline::materialize_all(uint16_t surface_id) {
+    gdiGfxSurface* surface = get_surface(gfx_, surface_id);
+    if (surface) materialize(surface_id, Rect{0, 0, surface->width, surface->height});
+}
+
+// ── Wrapped callbacks ─────────────────────────────────────────────────
+
+UINT GfxPipeline::on_reset_graphics(RdpgfxClientContext* context,
+                                    const RDPGFX_RESET_GRAPHICS_PDU* reset) {
+    TRACE_SCOPE("gfx_reset_graphics");
+    GfxPipeline* self = from_context(context);
+    if (!self) return ERROR_INTERNAL_ERROR;
+    GfxLock lock(context);
+    if (self->too_large(reset->width, reset->height)) {
+        self->fall_back_to_gdi(context, reset->width, reset->height);
+        return self->reset_graphics_(context, reset);
+    }
+    self->drain();
+
+    self->avc_.clear();
+    UINT status = self->reset_graphics_(context, reset);
+    if (status != CHANNEL_RC_OK) return status;
+
+    self->output_width_ = reset->width;
+    self->output_height_ = reset->height;
+
+    GfxCommand command;
+    command.type = GfxCommand::Type::ResetGraphics;
+    command.rect = {0, 0, reset->width, reset->height};
+    self->record(std::move(command));
+    if (!self->in_frame_) self->flush(0);
+    return status;
+}
+
+UINT GfxPipeline::on_start_frame(RdpgfxClientContext* context,
+                                 const RDPGFX_START_FRAME_PDU* start_frame) {
+    TRACE_SCOPE("gfx_start_frame");
+    GfxPipeline* self = from_context(context);
+    if (!self) return ERROR_INTERNAL_ERROR;
+    GfxLock lock(context);
+    self->drain();
+
+    self->in_frame_ = true;
+    self->frame_start_ = std::chrono::steady_clock::now();
+    return self->start_frame_(context, start_frame);
+}
+
+UINT GfxPipeline::on_end_frame(RdpgfxClientContext* context,
+                               const RDPGFX_END_FRAME_PDU* end_frame) {
+    TRACE_SCOPE("gfx_end_frame");
+    GfxPipeline* self = from_context(context);
+    if (!self) return ERROR_INTERNAL_ERROR;
+    GfxLock lock(context);
+    if (self->gdi_fallback_) {
+        UINT status = self->end_frame_(context, end_frame);
+        self->frames_decoded_++;
+        if (self->manual_acks_) self->send_frame_ack(context, end_frame->frameId);
+        return status;
+    }
+    self->drain();
+
+    UINT status = self->end_frame_(context, end_frame);
+    self->in_frame_ = false;
+
+    GfxFrameInfo frame;
+    frame.started = self->frame_start_;
+    frame.ended = std::chrono::steady_clock::now();
+    frame.decode_time =
+        std::chrono::duration_cast<std::chrono::microseconds>(frame.ended - self->frame_start_);
+    self->frames_decoded_++;
+    if (self->manual_acks_ && self->unpresented_ < self->ack_window_) {
+        frame.acknowledged = self->send_frame_ack(context, end_frame->frameId);
+    }
+    self->unpresented_++;
+    FlightRecorder::record(FlightEvent::GfxFrame, end_frame->frameId,
+                           static_cast<uint64_t>(frame.decode_time.count()));
+    static Counter& frames =
+        Metrics::global().counter("gvrdp_frames_received_total", "Frames completed by the server");
+    frames.add();
+    self->flush(end_frame->frameId, frame);
+    return status;
+}
+
+UINT GfxPipeline::on_surface_command(RdpgfxClientContext* context,
+                                     const RDPGFX_SURFACE_COMMAND* cmd) {
+    TRACE_SCOPE("gfx_surface_command");
+    GfxPipeline* self = from_context(context);
+    if (!self) return ERROR_INTERNAL_ERROR;
+    GfxLock lock(context);
+    static Counter& bytes_in = channel_bytes("rdpgfx", "in");
+    bytes_in.add(cmd->length);
+
+    auto surface_id = static_cast<uint16_t>(cmd->surfaceId);
+    if (self->decoders_ && (cmd->codecId == RDPGFX_CODECID_PLANAR ||
+                            cmd->codecId == RDPGFX_CODECID_UNCOMPRESSED)) {
+        UINT status = self->submit_decode(context, cmd);
+        if (!self->in_frame_) {
+            self->drain();
+            self->flush(0);
+        }
+        return status;
+    }
+
+    // Everything else is ordered after the decodes already in flight
+    self->drain();
+    CodecStats::Scope timing(self->stats_, codec_for(static_cast<UINT16>(cmd->codecId)),
+                             cmd->length);
+    if (cmd->codecId == RDPGFX_CODECID_AVC420 && self->gpu_yuv_) {
+        UINT status = self->surface_command_avc420(context, cmd);
+        if (!self->in_frame_) self->flush(0);
+        return status;
+    }
+
+    // Codecs such as Alpha and Progressive build on the existing pixels
+    self->materialize(surface_id, command_rect(cmd));
+    self->clear_invalid(surface_id);
+    UINT status = self->surface_command_(context, cmd);
+
+    // Whatever the codec touched is exactly the surface's invalid region now
+    self->record_invalid_uploads(surface_id);
+    if (!self->in_frame_) self->flush(0);
+    return status;
+}
+
+UINT GfxPipeline::on_create_surface(RdpgfxClientContext* context,
+                                    const RDPGFX_CREATE_SURFACE_PDU* create) {
+    TRACE_SCOPE("gfx_create_surface");
+    GfxPipeline* self = from_context(context);
+    if (!self) return ERROR_INTERNAL_ERROR;
+    GfxLock lock(context);
+    if (self->too_large(create->width, create->height)) {
+        self->fall_back_to_gdi(context, create->width, create->height);
+        return self->create_surface_(context, create);
+    }
+    self->drain();
+
+    self->avc_.erase(create->surfaceId);
+    UINT status = self->create_surface_(context, create);
+    if (status != CHANNEL_RC_OK) return status;
+
+    GfxCommand command;
+    command.type = GfxCommand::Type::CreateSurface;
+    command.surface_id = create->surfaceId;
+    command.rect = {0, 0, create->width, create->height};
+    self->record(std::move(command));
+    if (!self->in_frame_) self->flush(0);
+    return status;
+}
+
+UINT GfxPipeline::on_delete_surface(RdpgfxClientContext* context,
+                                    const RDPGFX_DELETE_SURFACE_PDU* del) {
+    TRACE_SCOPE("gfx_delete_surface");
+    GfxPipeline* self = from_context(context);
+    if (!self) return ERROR_INTERNAL_ERROR;
+    GfxLock lock(context);
+    self->drain();
+
+    self->avc_.erase(del->surfaceId);
+    UINT status = self->delete_surface_(context, del);
+
+    GfxCommand command;
+    command.type = GfxCommand::Type::DeleteSurface;
+    command.surface_id = del->surfaceId;
+    self->record(std::move(command));
+    if (!self->in_frame_) self->flush(0);
+    return status;
+}
+
+UINT GfxPipeline::on_solid_fill(RdpgfxClientContext* context, const RDPGFX_SOLID_FILL_PDU* fill) {
+    TRACE_SCOPE("gfx_solid_fill");
+    GfxPipeline* self = from_context(context);
+    if (!self) return ERROR_INTERNAL_ERROR;
+    GfxLock lock(context);
+    self->drain();
+
+    for (UINT16 i = 0; i < fill->fillRectCount; i++) {
+        self->materialize(fill->surfaceId, to_rect(fill->fillRects[i]));
+    }
+    UINT status = self->solid_fill_(context, fill);
+    if (status != CHANNEL_RC_OK) return status;
+    self->clear_invalid(fill->surfaceId);
+
+    GfxCommand command;
+    command.type = GfxCommand::Type::SolidFill;
+    command.surface_id = fill->surfaceId;
+    command.color = 0xFF000000u | (static_cast<uint32_t>(fill->fillPixel.R) << 16) |
+                    (static_cast<uint32_t>(fill->fillPixel.G) << 8) | fill->fillPixel.B;
+    for (UINT16 i = 0; i < fill->fillRectCount; i++) {
+        Rect rect = to_rect(fill->fillRects[i]);
+        if (!rect.empty()) command.rects.push_back(rect);
+    }
+    self->record(std::move(command));
+    if (!self->in_frame_) self->flush(0);
+    return status;
+}
+
+UINT GfxPipeline::on_surface_to_surface(RdpgfxClientContext* context,
+                                        const RDPGFX_SURFACE_TO_SURFACE_PDU* copy) {
+    TRACE_SCOPE("gfx_surface_to_surface");
+    GfxPipeline* self = from_context(context);
+    if (!self) return ERROR_INTERNAL_ERROR;
+    GfxLock lock(context);
+    self->drain();
+
+    Rect src_rect = to_rect(copy->rectSrc);
+    self->materialize(copy->surfaceIdSrc, src_rect);
+    for (UINT16 i = 0; i < copy->destPtsCount; i++) {
+        const RDPGFX_POINT16& pt = copy->destPts[i];
+        self->materialize(copy->surfaceIdDest,
+                          {static_cast<uint32_t>(std::max<INT16>(pt.x, 0)),
+                           static_cast<uint32_t>(std::max<INT16>(pt.y, 0)), src_rect.width,
+                           src_rect.height});
+    }
+    UINT status = self->surface_to_surface_(context, copy);
+    if (status != CHANNEL_RC_OK) return status;
+    self->clear_invalid(copy->surfaceIdDest);
+
+    GfxCommand command;
+    command.type = GfxCommand::Type::SurfaceToSurface;
+    command.src_surface_id = copy->surfaceIdSrc;
+    command.surface_id = copy->surfaceIdDest;
+    command.rect = to_rect(copy->rectSrc);
+    for (UINT16 i = 0; i < copy->destPtsCount; i++) {
+        const RDPGFX_POINT16& pt = copy->destPts[i];
+        if (pt.x < 0 || pt.y < 0) continue;
+        command.rects.push_back({static_cast<uint32_t>(pt.x), static_cast<uint32_t>(pt.y),
+                                 command.rect.width, command.rect.height});
+    }
+    self->record(std::move(command));
+    if (!self->in_frame_) self->flush(0);
+    return status;
+}
+
+UINT GfxPipeline::on_surface_to_cache(RdpgfxClientContext* context,
+                                      const RDPGFX_SURFACE_TO_CACHE_PDU* to_cache) {
+    TRACE_SCOPE("gfx_surface_to_cache");
+    GfxPipeline* self = from_context(context);
+    if (!self) return ERROR_INTERNAL_ERROR;
+    GfxLock lock(context);
+    self->drain();
+
+    self->materialize(to_cache->surfaceId, to_rect(to_cache->rectSrc));
+    UINT status = self->surface_to_cache_(context, to_cache);
+    if (status != CHANNEL_RC_OK) return status;
+    if (self->cache_) self->slot_keys_[to_cache->cacheSlot] = to_cache->cacheKey;
+
+    GfxCommand command;
+    command.type = GfxCommand::Type::SurfaceToCache;
+    command.surface_id = to_cache->surfaceId;
+    command.cache_slot = to_cache->cacheSlot;
+    command.rect = to_rect(to_cache->rectSrc);
+    self->record(std::move(command));
+    if (!self->in_frame_) self->flush(0);
+    return status;
+}
+
+UINT GfxPipeline::on_cache_to_surface(RdpgfxClientContext* context,
+                                      const RDPGFX_CACHE_TO_SURFACE_PDU* from_cache) {
+    TRACE_SCOPE("gfx_cache_to_surface");
+    GfxPipeline* self = from_context(context);
+    if (!self) return ERROR_INTERNAL_ERROR;
+    GfxLock lock(context);
+    self->drain();
+
+    auto* entry = static_cast<gdiGfxCacheEntry*>(
+        context->GetCacheSlotData ? context->GetCacheSlotData(context, from_cache->cacheSlot)
+                                  : nullptr);
+    if (entry) {
+        for (UINT16 i = 0; i < from_cache->destPtsCount; i++) {
+            const RDPGFX_POINT16& pt = from_cache->destPts[i];
+            self->materialize(from_cache->surfaceId,
+                              {static_cast<uint32_t>(std::max<INT16>(pt.x, 0)),
+                               static_cast<uint32_t>(std::max<INT16>(pt.y, 0)), entry->width,
+                               entry->height});
+        }
+    }
+
+    UINT status = self->cache_to_surface_(context, from_cache);
+    if (status != CHANNEL_RC_OK) return status;
+    self->clear_invalid(from_cache->surfaceId);
+    if (!entry) return status;
+
+    GfxCommand command;
+    command.type = GfxCommand::Type::CacheToSurface;
+    command.cache_slot = from_cache->cacheSlot;
+    command.surface_id = from_cache->surfaceId;
+    for (UINT16 i = 0; i < from_cache->destPtsCount; i++) {
+        const RDPGFX_POINT16& pt = from_cache->destPts[i];
+        if (pt.x < 0 || pt.y < 0) continue;
+        command.rects.push_back({static_cast<uint32_t>(pt.x), static_cast<uint32_t>(pt.y),
+                                 entry->width, entry->height});
+    }
+    self->record(std::move(command));
+    if (!self->in_frame_) self->flush(0);
+    return status;
+}
+
+UINT GfxPipeline::on_evict_cache_entry(RdpgfxClientContext* context,
+                                       const RDPGFX_EVICT_CACHE_ENTRY_PDU* evict) {
+    TRACE_SCOPE("gfx_evict_cache_entry");
+    GfxPipeline* self = from_context(context);
+    if (!self) return ERROR_INTERNAL_ERROR;
+    GfxLock lock(context);
+    self->drain();
+
+    UINT status = self->evict_cache_entry_(context, evict);
+    self->slot_keys_.erase(evict->cacheSlot);
+
+    GfxCommand command;
+    command.type = GfxCommand::Type::EvictCache;
+    command.cache_slot = evict->cacheSlot;
+    self->record(std::move(command));
+    if (!self->in_frame_) self->flush(0);
+    return status;
+}
+
+UINT GfxPipeline::on_map_surface_to_output(RdpgfxClientContext* context,
+                                           const RDPGFX_MAP_SURFACE_TO_OUTPUT_PDU* map) {
+    TRACE_SCOPE("gfx_map_surface_to_output");
+    GfxPipeline* self = from_context(context);
+    if (!self) return ERROR_INTERNAL_ERROR;
+    GfxLock lock(context);
+    self->drain();
+
+    UINT status = self->map_surface_to_output_(context, map);
+    if (status != CHANNEL_RC_OK) return status;
+
+    GfxCommand command;
+    command.type = GfxCommand::Type::MapSurfaceToOutput;
+    command.surface_id = map->surfaceId;
+    command.rect = {map->outputOriginX, map->outputOriginY, 0, 0};
+    self->record(std::move(command));
+    if (!self->in_frame_) self->flush(0);
+    return status;
+}
+
+UINT GfxPipeline::on_update_surfaces(RdpgfxClientContext* context) {
+    TRACE_SCOPE("gfx_update_surfaces");
+    // Composition happens on the GPU (GfxRenderer). Skipping FreeRDP's
+    // surface-to-primary-buffer copy is the point of this pipeline; just
+    // make sure stale invalid regions don't accumulate.
+    GfxPipeline* self = from_context(context);
+    if (!self) return ERROR_INTERNAL_ERROR;
+    GfxLock lock(context);
+    self->drain();
+
+    UINT16* ids = nullptr;
+    UINT16 count = 0;
+    if (context->GetSurfaceIds && context->GetSurfaceIds(context, &ids, &count) == CHANNEL_RC_OK) {
+        for (UINT16 i = 0; i < count; i++) {
+            self->clear_invalid(ids[i]);
+        }
+        free(ids);
+    }
+    return CHANNEL_RC_OK;
+}
+
+UINT GfxPipeline::on_open(RdpgfxClientContext* context, BOOL* do_caps_advertise,
+                          BOOL* do_frame_acks) {
+    TRACE_SCOPE("gfx_open");
+    GfxPipeline* self = from_context(context);
+    if (!self) return ERROR_INTERNAL_ERROR;
+
+    UINT status = self->on_open_ ? self->on_open_(context, do_caps_advertise, do_frame_acks)
+                                 : CHANNEL_RC_OK;
+    // FreeRDP would acknowledge every frame as soon as it is decoded; we
+    // acknowledge once it is on screen
+    if (status == CHANNEL_RC_OK && do_frame_acks && context->FrameAcknowledge) {
+        *do_frame_acks = FALSE;
+        self->manual_acks_ = true;
+    }
+    return status;
+}
+
+UINT GfxPipeline::on_caps_confirm(RdpgfxClientContext* context,
+                                  RDPGFX_CAPS_CONFIRM_PDU* confirm) {
+    TRACE_SCOPE("gfx_caps_confirm");
+    GfxPipeline* self = from_context(context);
+    if (!self) return ERROR_INTERNAL_ERROR;
+    GfxLock lock(context);
+
+    UINT status = self->caps_confirm_ ? self->caps_confirm_(context, confirm) : CHANNEL_RC_OK;
+    if (status != CHANNEL_RC_OK) return status;
+    // QoE frame acknowledgements exist from RDPGFX 10 on
+    self->qoe_ = confirm && confirm->capsSet && confirm->capsSet->version >= RDPGFX_CAPVERSION_10;
+    self->offer_cache(context, confirm);
+    return status;
+}
+
+UINT GfxPipeline::on_cache_import_reply(RdpgfxClientContext* context,
+                                        const RDPGFX_CACHE_IMPORT_REPLY_PDU* reply) {
+    TRACE_SCOPE("gfx_cache_import_reply");
+    GfxPipeline* self = from_context(context);
+    if (!self) return ERROR_INTERNAL_ERROR;
+    GfxLock lock(context);
+    self->drain();
+
+    // cacheSlots[i] is the slot the server gave the i-th offered entry (0 = declined)
+    size_t imported = 0;
+    if (self->cache_ && context->ImportCacheEntry) {
+        size_t count = std::min<size_t>(reply->importedEntriesCount, self->offered_.size());
+        for (size_t i = 0; i < count; i++) {
+            UINT16 slot = reply->cacheSlots[i];
+            if (slot == 0) continue;
+
+            CachedBitmap bitmap;
+            if (!self->cache_->find(self->offered_[i], bitmap)) {
+                LOG_WARN("RDPGFX cache entry {:#x} vanished before import", self->offered_[i]);
+                continue;
+            }
+            PERSISTENT_CACHE_ENTRY entry{};
+            entry.key64 = bitmap.key;
+            entry.width = bitmap.width;
+            entry.height = bitmap.height;
+            entry.size = static_cast<UINT32>(bitmap.size());
+            entry.data = const_cast<uint8_t*>(bitmap.pixels);
+            if (context->ImportCacheEntry(context, slot, &entry) != CHANNEL_RC_OK) continue;
+
+            self->slot_keys_[slot] = bitmap.key;
+            self->record_cache_import(slot);
+            imported++;
+        }
+    }
+    self->offered_.clear();
+
+    // FreeRDP gives the slots we did not fill blank entries
+    UINT status = self->cache_import_reply_ ? self->cache_import_reply_(context, reply)
+                                            : CHANNEL_RC_OK;
+    LOG_INFO("RDPGFX cache import: {} of {} entries restored", imported,
+             reply->importedEntriesCount);
+    if (!self->in_frame_) self->flush(0);
+    return status;
+}
+
+}  // namespace gvrdp
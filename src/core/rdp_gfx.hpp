@@ -0,0 +1,241 @@
+#pragma once
+
+#include "core/codec_stats.hpp"
+#include "core/h264_decoder.hpp"
+#include "core/persistent_cache.hpp"
+#include "render/gfx_command.hpp"
+#include "util/thread_safe_queue.hpp"
+#include "util/worker_pool.hpp"
+
+#include <freerdp/client/rdpgfx.h>
+#include <freerdp/gdi/gdi.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gvrdp {
+
+// RDPGFX (MS-RDPEGFX) integration. FreeRDP's GDI graphics pipeline still
+// decodes codecs into CPU-side surfaces, but composition is taken over: every
+// surface operation is recorded as a GfxCommand and replayed by GfxRenderer
+// on GPU textures. SolidFill, SurfaceToSurface and CacheToSurface become GPU
+// fills/copies, and only codec-decoded pixels are uploaded.
+//
+// The CPU surfaces are kept as the source of truth: codecs such as Alpha read
+// the destination, and after a GPU device reset everything can be re-uploaded
+// from them (see resync()).
+//
+// AVC420 frames skip FreeRDP's decoder on the GPU YUV path (GVRDP_WITH_FFMPEG):
+// they are decoded to YUV here and converted to RGB by the GPU. The CPU
+// surface only catches up (see materialize()) when something else needs it.
+//
+// Planar and uncompressed tiles are decoded on a worker pool. Their uploads
+// are committed in submission order by drain(), which every other operation
+// calls first, so the CPU surfaces and the command stream keep the order the
+// server sent.
+//
+// With a persistent cache, bitmaps the server caches (keyed by its cacheKey)
+// are written to a per-host PersistentCache when the channel closes. The
+// next connection offers them in a CacheImportOffer, and the entries the
+// server accepts are loaded into their cache slots without being re-sent.
+//
+// Frame acknowledgements are ours too: a frame is acknowledged once the main
+// thread has presented it (acknowledge_presented()), optionally with QoE
+// timings, so the server paces itself to what actually reaches the screen.
+// Up to `ack_window` frames may be acknowledged on arrival instead.
+//
+// GfxRenderer keeps each surface in one texture. An output or surface larger
+// than `max_surface_size` cannot be shown that way, so the pipeline hands
+// composition back to FreeRDP's GDI for the rest of the connection: the
+// desktop then reaches the screen through the tiled GDI texture, and frames
+// are acknowledged on arrival.
+//
+// Callbacks run on FreeRDP's channel thread; batches are consumed by the main thread.
+class GfxPipeline {
+public:
+    using FrameCallback = std::function<void()>;
+
+    struct Options {
+        bool gpu_yuv = false;          // Decode AVC420 ourselves (CodecSelection::gpu_h264)
+        CodecStats* stats = nullptr;   // Receives per-codec decode costs
+        size_t decode_threads = 0;     // 0 = cores - 1; 1 = decode inline
+        std::filesystem::path cache_path;  // Persistent bitmap cache (empty = none)
+        uint64_t cache_limit_bytes = 0;
+        uint32_t ack_window = 0;       // Frames acknowledged before being presented
+        uint32_t max_surface_size = 0; // GfxRenderer's texture limit (0 = none)
+    };
+
+    GfxPipeline(FrameCallback on_frame, const Options& options);
+    ~GfxPipeline();
+
+    GfxPipeline(const GfxPipeline&) = delete;
+    GfxPipeline& operator=(const GfxPipeline&) = delete;
+
+    // Channel lifecycle (called from the channel connect/disconnect handlers)
+    bool attach(rdpGdi* gdi, RdpgfxClientContext* gfx);
+    void detach();
+    // Composing on the GPU: attached and not fallen back to GDI
+    bool is_active() const { return active_ && !gdi_fallback_; }
+    bool is_attached() const { return active_; }
+
+    // Main thread: next completed batch, in order. Batches cannot be skipped.
+    std::optional<GfxBatch> pop_batch();
+
+    // Main thread: every batch popped so far is on screen. Acknowledges
+    // their frames, with decode and present times on servers that take QoE.
+    void acknowledge_presented();
+
+    // Main thread: GPU textures were lost; re-send every surface and cache
+    // entry from the CPU copies as a fresh batch.
+    void resync();
+
+private:
+    // Wrapped RdpgfxClientContext callbacks
+    static UINT on_reset_graphics(RdpgfxClientContext* context,
+                                  const RDPGFX_RESET_GRAPHICS_PDU* reset);
+    static UINT on_start_frame(RdpgfxClientContext* context,
+                               const RDPGFX_START_FRAME_PDU* start_frame);
+    static UINT on_end_frame(RdpgfxClientContext* context, const RDPGFX_END_FRAME_PDU* end_frame);
+    static UINT on_surface_command(RdpgfxClientContext* context,
+                                   const RDPGFX_SURFACE_COMMAND* cmd);
+    static UINT on_create_surface(RdpgfxClientContext* context,
+                                  const RDPGFX_CREATE_SURFACE_PDU* create);
+    static UINT on_delete_surface(RdpgfxClientContext* context,
+                                  const RDPGFX_DELETE_SURFACE_PDU* del);
+    static UINT on_solid_fill(RdpgfxClientContext* context, const RDPGFX_SOLID_FILL_PDU* fill);
+    static UINT on_surface_to_surface(RdpgfxClientContext* context,
+                                      const RDPGFX_SURFACE_TO_SURFACE_PDU* copy);
+    static UINT on_surface_to_cache(RdpgfxClientContext* context,
+                                    const RDPGFX_SURFACE_TO_CACHE_PDU* to_cache);
+    static UINT on_cache_to_surface(RdpgfxClientContext* context,
+                                    const RDPGFX_CACHE_TO_SURFACE_PDU* from_cache);
+    static UINT on_evict_cache_entry(RdpgfxClientContext* context,
+                                     const RDPGFX_EVICT_CACHE_ENTRY_PDU* evict);
+    static UINT on_map_surface_to_output(RdpgfxClientContext* context,
+                                         const RDPGFX_MAP_SURFACE_TO_OUTPUT_PDU* map);
+    static UINT on_update_surfaces(RdpgfxClientContext* context);
+    static UINT on_open(RdpgfxClientContext* context, BOOL* do_caps_advertise,
+                        BOOL* do_frame_acks);
+    static UINT on_caps_confirm(RdpgfxClientContext* context, RDPGFX_CAPS_CONFIRM_PDU* confirm);
+    static UINT on_cache_import_reply(RdpgfxClientContext* context,
+                                      const RDPGFX_CACHE_IMPORT_REPLY_PDU* reply);
+
+    static GfxPipeline* from_context(RdpgfxClientContext* context);
+
+    // Puts FreeRDP's GDI handlers back in the context
+    void restore_callbacks();
+    // Hands composition to FreeRDP's GDI for good; see the class comment
+    void fall_back_to_gdi(RdpgfxClientContext* context, uint32_t width, uint32_t height);
+    bool too_large(uint32_t width, uint32_t height) const;
+
+    // Parallel decode of stateless codecs
+    UINT submit_decode(RdpgfxClientContext* context, const RDPGFX_SURFACE_COMMAND* cmd);
+    // Waits for in-flight decodes and records their uploads in order
+    void drain();
+
+    // AVC420 on the GPU YUV path
+    UINT surface_command_avc420(RdpgfxClientContext* context, const RDPGFX_SURFACE_COMMAND* cmd);
+    void record_yuv_upload(uint16_t surface_id, const YuvPicture& picture,
+                           const std::vector<Rect>& regions);
+    // Converts the CPU-stale AVC areas of a surface that intersect `area`
+    // (all of them for materialize_all) from the last decoded picture
+    void materialize(uint16_t surface_id, const Rect& area);
+    void materialize_all(uint16_t surface_id);
+
+    // Drops the CPU invalid region of a surface; composition is ours now
+    void clear_invalid(uint16_t surface_id);
+    // Records Upload commands for the CPU surface's invalid region, then clears it
+    void record_invalid_uploads(uint16_t surface_id);
+    void record_upload(uint16_t surface_id, const Rect& rect);
+    // Records an ImportCacheEntry command with the CPU copy of a cache slot
+    void record_cache_import(uint16_t cache_slot);
+    void record(GfxCommand command);
+    void flush(uint32_t frame_id, std::optional<GfxFrameInfo> frame = std::nullopt);
+    bool send_frame_ack(RdpgfxClientContext* context, uint32_t frame_id);
+
+    // Persistent cache: offers stored entries once the capabilities are
+    // known; collect_cache() copies the keyed slots into the store
+    void offer_cache(RdpgfxClientContext* context, const RDPGFX_CAPS_CONFIRM_PDU* confirm);
+    void collect_cache();
+
+    FrameCallback on_frame_;
+    CodecStats* stats_;
+
+    // Serializes attach/detach (channel thread) against resync (main thread)
+    std::mutex lifecycle_mutex_;
+    rdpGdi* gdi_ = nullptr;
+    RdpgfxClientContext* gfx_ = nullptr;
+    std::atomic<bool> active_{false};
+    uint32_t max_surface_size_ = 0;
+    std::atomic<bool> gdi_fallback_{false};  // FreeRDP composes; batches stop
+
+    // Original FreeRDP GDI handlers we chain to
+    pcRdpgfxResetGraphics reset_graphics_ = nullptr;
+    pcRdpgfxStartFrame start_frame_ = nullptr;
+    pcRdpgfxEndFrame end_frame_ = nullptr;
+    pcRdpgfxSurfaceCommand surface_command_ = nullptr;
+    pcRdpgfxCreateSurface create_surface_ = nullptr;
+    pcRdpgfxDeleteSurface delete_surface_ = nullptr;
+    pcRdpgfxSolidFill solid_fill_ = nullptr;
+    pcRdpgfxSurfaceToSurface surface_to_surface_ = nullptr;
+    pcRdpgfxSurfaceToCache surface_to_cache_ = nullptr;
+    pcRdpgfxCacheToSurface cache_to_surface_ = nullptr;
+    pcRdpgfxEvictCacheEntry evict_cache_entry_ = nullptr;
+    pcRdpgfxMapSurfaceToOutput map_surface_to_output_ = nullptr;
+    pcRdpgfxUpdateSurfaces update_surfaces_ = nullptr;
+    pcRdpgfxOnOpen on_open_ = nullptr;
+    pcRdpgfxCapsConfirm caps_confirm_ = nullptr;
+    pcRdpgfxCacheImportReply cache_import_reply_ = nullptr;
+
+    // Channel-thread state (guarded by the RDPGFX context mutex)
+    bool in_frame_ = false;
+    std::vector<GfxCommand> pending_;
+    uint32_t output_width_ = 0;
+    uint32_t output_height_ = 0;
+
+    // Per-surface H.264 state. `stale` lists surface areas that were only
+    // decoded to YUV; the CPU surface is behind there.
+    struct AvcSurface {
+        std::unique_ptr<H264Decoder> decoder;
+        std::vector<Rect> stale;
+    };
+    bool gpu_yuv_ = false;
+    std::unordered_map<uint16_t, AvcSurface> avc_;
+
+    struct DecodeJob {
+        uint16_t surface_id = 0;
+        Rect rect;
+        bool ok = false;  // Written by the worker, read after wait_idle()
+    };
+    std::unique_ptr<WorkerPool> decoders_;
+    std::deque<std::shared_ptr<DecodeJob>> in_flight_;
+
+    std::filesystem::path cache_path_;
+    uint64_t cache_limit_bytes_ = 0;
+    std::unique_ptr<PersistentCache> cache_;         // Open while attached
+    bool cache_offered_ = false;
+    std::vector<uint64_t> offered_;                  // Keys, in offer order
+    std::unordered_map<uint16_t, uint64_t> slot_keys_;  // Cache slot -> cacheKey
+
+    // Frame acknowledgement
+    uint32_t ack_window_ = 0;
+    std::atomic<bool> manual_acks_{false};     // FreeRDP's automatic acks are off
+    std::atomic<bool> qoe_{false};             // Server confirmed caps version >= 10
+    std::chrono::steady_clock::time_point frame_start_;
+    std::atomic<uint32_t> frames_decoded_{0};
+    std::atomic<uint32_t> unpresented_{0};     // Ended, not yet presented
+    std::vector<std::pair<uint32_t, GfxFrameInfo>> popped_;  // Main thread
+
+    ThreadSafeQueue<GfxBatch> batches_;
+};
+
+}  // namespace gvrdp
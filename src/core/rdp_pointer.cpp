@@ -0,0 +1,119 @@
+#include "core/rdp_pointer.hpp"
+
+#include "core/rdp_context.hpp"
+#include "core/rdp_session.hpp"
+#include "render/pointer_shape.hpp"
+#include "util/logger.hpp"
+#include "util/tracer.hpp"
+
+#include <freerdp/codec/color.h>
+#include <freerdp/gdi/gdi.h>
+#include <freerdp/graphics.h>
+
+#include <utility>
+
+namespace gvrdp {
+
+namespace {
+
+// FreeRDP allocates `size` bytes per pointer; our id follows its fields
+struct GvrdpPointer {
+    rdpPointer pointer;
+    uint32_t id;
+};
+
+RdpSession* session_of(rdpContext* context) {
+    return reinterpret_cast<GvrdpContext*>(context)->session;
+}
+
+void send(rdpContext* context, PointerCommand command) {
+    if (RdpSession* session = session_of(context)) {
+        session->push_pointer_command(std::move(command));
+    }
+}
+
+BOOL pointer_new(rdpContext* context, rdpPointer* pointer) {
+    TRACE_SCOPE("pointer_new");
+    static uint32_t next_id = 0;  // RDP thread only
+
+    PointerCommand command;
+    command.type = PointerCommand::Type::Define;
+    PointerShape& shape = command.shape;
+    shape.width = pointer->width;
+    shape.height = pointer->height;
+    shape.hotspot_x = pointer->xPos;
+    shape.hotspot_y = pointer->yPos;
+    shape.argb.resize(static_cast<size_t>(shape.width) * shape.height);
+
+    PointerMasks masks;
+    masks.width = pointer->width;
+    masks.height = pointer->height;
+    masks.xor_bpp = pointer->xorBpp;
+    masks.xor_mask = pointer->xorMaskData;
+    masks.xor_length = pointer->lengthXorMask;
+    masks.and_mask = pointer->andMaskData;
+    masks.and_length = pointer->lengthAndMask;
+    if (!convert_pointer(masks, shape.argb.data())) {
+        // Palette shapes (and anything malformed): FreeRDP's converter
+        const gdiPalette* palette = context->gdi ? &context->gdi->palette : nullptr;
+        if (shape.argb.empty() ||
+            !freerdp_image_copy_from_pointer_data(
+                reinterpret_cast<BYTE*>(shape.argb.data()), PIXEL_FORMAT_BGRA32,
+                shape.width * 4, 0, 0, shape.width, shape.height, pointer->xorMaskData,
+                pointer->lengthXorMask, pointer->andMaskData, pointer->lengthAndMask,
+                pointer->xorBpp, palette)) {
+            LOG_WARN("Unsupported {}x{} pointer at {} bpp", pointer->width, pointer->height,
+                     pointer->xorBpp);
+            return FALSE;
+        }
+    }
+
+    if (++next_id == 0) ++next_id;  // 0 means "none" to the cursor
+    command.id = next_id;
+    reinterpret_cast<GvrdpPointer*>(pointer)->id = next_id;
+    send(context, std::move(command));
+    return TRUE;
+}
+
+void pointer_free(rdpContext* context, rdpPointer* pointer) {
+    uint32_t id = reinterpret_cast<GvrdpPointer*>(pointer)->id;
+    if (id != 0) send(context, {PointerCommand::Type::Release, id, {}});
+}
+
+BOOL pointer_set(rdpContext* context, rdpPointer* pointer) {
+    uint32_t id = reinterpret_cast<GvrdpPointer*>(pointer)->id;
+    if (id == 0) return FALSE;
+    send(context, {PointerCommand::Type::Set, id, {}});
+    return TRUE;
+}
+
+BOOL pointer_set_null(rdpContext* context) {
+    send(context, {PointerCommand::Type::Hide, 0, {}});
+    return TRUE;
+}
+
+BOOL pointer_set_default(rdpContext* context) {
+    send(context, {PointerCommand::Type::Default, 0, {}});
+    return TRUE;
+}
+
+// Server-side pointer moves would fight the user's own mouse; ignored
+BOOL pointer_set_position(rdpContext*, UINT32, UINT32) {
+    return TRUE;
+}
+
+}  // namespace
+
+void register_pointer(rdpContext* context) {
+    rdpPointer pointer = {};
+    pointer.size = sizeof(GvrdpPointer);
+    pointer.New = pointer_new;
+    pointer.Free = pointer_free;
+    pointer.Set = pointer_set;
+    pointer.SetNull = pointer_set_null;
+    pointer.SetDefault = pointer_set_default;
+    pointer.SetPosition = pointer_set_position;
+    graphics_register_pointer(context->graphics, &pointer);
+}
+
+}  // namespace gvrdp
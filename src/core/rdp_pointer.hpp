@@ -0,0 +1,14 @@
+#pragma once
+
+#include <freerdp/freerdp.h>
+
+namespace gvrdp {
+
+// Registers our rdpPointer with FreeRDP's graphics module. Shapes are
+// converted to ARGB on the RDP thread and handed to the main thread's
+// SdlCursor as PointerCommands (see RdpSession::pop_pointer_command()).
+// FreeRDP's pointer cache keeps one rdpPointer per server cache slot, so a
+// Cached Pointer update arrives as Set of a shape we already sent.
+void register_pointer(rdpContext* context);
+
+}  // namespace gvrdp
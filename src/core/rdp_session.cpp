@@ -1,15 +1,26 @@
 #include "core/rdp_session.hpp"
 
 #include "channels/disp_channel.hpp"
+#include "core/h264_decoder.hpp"
+#include "core/persistent_cache.hpp"
 #include "core/rdp_callbacks.hpp"
 #include "core/rdp_channels.hpp"
+#include "core/rdp_pointer.hpp"
 #include "core/rdp_settings.hpp"
+#include "input/input_coalescer.hpp"
+#include "render/frame_allocator.hpp"
+#include "util/fd_reactor.hpp"
+#include "util/flight_recorder.hpp"
 #include "util/logger.hpp"
+#include "util/metrics.hpp"
+#include "util/tracer.hpp"
 
+#include <freerdp/autodetect.h>
 #include <freerdp/client/channels.h>
 #include <freerdp/client/cliprdr.h>
 #include <freerdp/client/cmdline.h>
 #include <freerdp/client/disp.h>
+#include <freerdp/client/rdpgfx.h>
 #include <freerdp/client/rdpsnd.h>
 #include <freerdp/codec/color.h>
 #include <freerdp/event.h>
@@ -20,17 +31,46 @@
 
 #include <SDL2/SDL.h>
 
+#include <algorithm>
 #include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace gvrdp {
 
+// Adds a GDI region (signed, possibly off-surface) to a damage set.
+static void add_gdi_rgn(DamageRegion& damage, const GDI_RGN& rgn) {
+    if (rgn.null || rgn.w <= 0 || rgn.h <= 0) return;
+    INT32 x = std::max(rgn.x, 0);
+    INT32 y = std::max(rgn.y, 0);
+    INT32 w = rgn.x + rgn.w - x;
+    INT32 h = rgn.y + rgn.h - y;
+    if (w <= 0 || h <= 0) return;
+    damage.add(Rect{static_cast<uint32_t>(x), static_cast<uint32_t>(y),
+                    static_cast<uint32_t>(w), static_cast<uint32_t>(h)});
+}
+
+// FreeRDP names formats in memory byte order, SDL as packed little-endian
+// words: BGRA32 in memory is SDL's ARGB8888.
+static UINT32 freerdp_format_for(uint32_t sdl_format) {
+    switch (sdl_format) {
+        case SDL_PIXELFORMAT_RGB888: return PIXEL_FORMAT_BGRX32;
+        case SDL_PIXELFORMAT_BGR888: return PIXEL_FORMAT_RGBX32;
+        case SDL_PIXELFORMAT_ABGR8888: return PIXEL_FORMAT_RGBA32;
+        case SDL_PIXELFORMAT_ARGB8888:
+        default: return PIXEL_FORMAT_BGRA32;
+    }
+}
+
 RdpSession::RdpSession() = default;
 
 RdpSession::~RdpSession() {
     disconnect();
 }
 
-bool RdpSession::connect(const ConnectionProfile& profile, uint32_t sdl_window_id) {
+bool RdpSession::connect(const ConnectionProfile& profile, uint32_t sdl_window_id,
+                         uint32_t sdl_pixel_format) {
     if (connected_) {
         LOG_WARN("Already connected, disconnect first");
         return false;
@@ -38,9 +78,12 @@ bool RdpSession::connect(const ConnectionProfile& profile, uint32_t sdl_window_i
 
     profile_ = profile;
     sdl_window_id_ = sdl_window_id;
+    sdl_pixel_format_ = sdl_pixel_format;
     ignore_certificate_ = profile.ignore_certificate;
     last_error_ = RdpError::None;
     should_disconnect_ = false;
+    visible_area_.reset();
+    whole_desktop_visible_ = false;
 
     // Create FreeRDP instance
     instance_ = freerdp_new();
@@ -74,7 +117,12 @@ bool RdpSession::connect(const ConnectionProfile& profile, uint32_t sdl_window_i
 
     // Apply connection profile settings
     rdpSettings* settings = instance_->context->settings;
-    if (!apply_profile_to_settings(settings, profile_)) {
+    std::filesystem::path cache_file;
+    if (cache_limit_bytes_ > 0 && !cache_dir_.empty()) {
+        cache_file = PersistentCache::path_for(cache_dir_, profile_.hostname, profile_.port);
+    }
+    if (!apply_profile_to_settings(settings, profile_) ||
+        !apply_cache_settings(settings, profile_, cache_file)) {
         LOG_ERROR("Failed to apply profile settings");
         freerdp_context_free(instance_);
         freerdp_free(instance_);
@@ -86,6 +134,36 @@ bool RdpSession::connect(const ConnectionProfile& profile, uint32_t sdl_window_i
 
     // Create display channel handler
     disp_channel_ = std::make_unique<DispChannel>();
+    codec_stats_.reset();
+    if (profile_.enable_gfx_pipeline) {
+        GfxPipeline::Options options;
+        options.gpu_yuv = resolve_codecs(profile_, H264Decoder::available()).gpu_h264;
+        options.stats = &codec_stats_;
+        options.decode_threads = decode_threads_;
+        options.cache_path = cache_file;
+        options.cache_limit_bytes = cache_limit_bytes_;
+        options.ack_window = profile_.gfx_ack_window;
+        options.max_surface_size = gfx_surface_limit_;
+        gfx_pipeline_ = std::make_unique<GfxPipeline>(
+            [this] { push_sdl_event(GVRDP_EVENT_FRAME_READY); }, options);
+    }
+
+    // Input ring wake-up, waited on by the RDP thread alongside FreeRDP's handles
+    input_.clear();
+    input_wake_pending_ = false;
+    input_backlogged_ = false;
+    input_event_ = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    if (!input_event_) {
+        LOG_ERROR("Failed to create the input event");
+        disp_channel_.reset();
+        gfx_pipeline_.reset();
+        freerdp_context_free(instance_);
+        freerdp_free(instance_);
+        instance_ = nullptr;
+        context_ = nullptr;
+        last_error_ = RdpError::InternalError;
+        return false;
+    }
 
     // Launch RDP thread
     rdp_thread_ = std::thread(&RdpSession::rdp_thread_func, this);
@@ -95,6 +173,8 @@ bool RdpSession::connect(const ConnectionProfile& profile, uint32_t sdl_window_i
 
 void RdpSession::disconnect() {
     should_disconnect_ = true;
+    // The RDP thread waits without a timeout
+    if (input_event_) SetEvent(input_event_);
 
     if (instance_ && connected_) {
         freerdp_abort_connect_context(instance_->context);
@@ -105,6 +185,12 @@ void RdpSession::disconnect() {
     }
 
     disp_channel_.reset();
+    gfx_pipeline_.reset();
+
+    if (input_event_) {
+        CloseHandle(input_event_);
+        input_event_ = nullptr;
+    }
 
     if (instance_) {
         freerdp_context_free(instance_);
@@ -124,34 +210,180 @@ RdpError RdpSession::last_error() const {
     return last_error_;
 }
 
-void RdpSession::request_resolution_change(uint32_t width, uint32_t height) {
-    if (disp_channel_) {
-        disp_channel_->send_layout(width, height);
-    }
+bool RdpSession::request_resolution_change(uint32_t width, uint32_t height) {
+    return disp_channel_ && disp_channel_->send_layout(width, height);
 }
 
 void RdpSession::send_keyboard_event(uint16_t flags, uint8_t code) {
-    if (!connected_ || !instance_ || !instance_->context) return;
-    std::lock_guard lock(send_mutex_);
-    freerdp_input_send_keyboard_event(instance_->context->input, flags, code);
+    InputEvent event;
+    event.type = InputEvent::Type::Keyboard;
+    event.flags = flags;
+    event.code = code;
+    enqueue_input(event);
 }
 
 void RdpSession::send_mouse_event(uint16_t flags, uint16_t x, uint16_t y) {
-    if (!connected_ || !instance_ || !instance_->context) return;
-    std::lock_guard lock(send_mutex_);
-    freerdp_input_send_mouse_event(instance_->context->input, flags, x, y);
+    InputEvent event;
+    event.type = InputEvent::Type::Mouse;
+    event.flags = flags;
+    event.x = x;
+    event.y = y;
+    enqueue_input(event);
 }
 
 void RdpSession::send_extended_mouse_event(uint16_t flags, uint16_t x, uint16_t y) {
-    if (!connected_ || !instance_ || !instance_->context) return;
-    std::lock_guard lock(send_mutex_);
-    freerdp_input_send_extended_mouse_event(instance_->context->input, flags, x, y);
+    InputEvent event;
+    event.type = InputEvent::Type::ExtendedMouse;
+    event.flags = flags;
+    event.x = x;
+    event.y = y;
+    enqueue_input(event);
 }
 
-const uint8_t* RdpSession::gdi_buffer() const {
-    if (!instance_ || !instance_->context) return nullptr;
-    rdpGdi* gdi = instance_->context->gdi;
-    return gdi ? gdi->primary_buffer : nullptr;
+void RdpSession::set_visible_area(const std::optional<Rect>& area) {
+    InputEvent event;
+    event.type = InputEvent::Type::VisibleArea;
+    event.area = area.value_or(Rect{});
+    event.whole_desktop = !area;
+    enqueue_input(event);
+}
+
+void RdpSession::enqueue_input(const InputEvent& event) {
+    if (!connected_) return;
+    // Full: the RDP thread is stuck behind the transport, and input waits in
+    // the backlog. Of pointer moves waiting there, only the newest is kept.
+    bool move = event.type == InputEvent::Type::Mouse && event.flags == PTR_FLAGS_MOVE;
+    switch (move ? input_.push_latest(event) : input_.push(event)) {
+        case BacklogRing<InputEvent, kInputRingSize>::Push::Queued:
+            break;
+        case BacklogRing<InputEvent, kInputRingSize>::Push::Backlogged:
+            watch_backlog();
+            break;
+        case BacklogRing<InputEvent, kInputRingSize>::Push::Dropped: {
+            static Counter& dropped = Metrics::global().counter(
+                "gvrdp_input_dropped_total", "Input events dropped with the backlog full");
+            if (dropped.value() == 0) {
+                LOG_WARN("Input backlog full, dropping input until the server catches up");
+            }
+            dropped.add();
+            return;
+        }
+    }
+    wake_input();
+}
+
+void RdpSession::flush_input() {
+    if (input_.backlog() == 0) return;
+    if (!input_.flush()) watch_backlog();
+    wake_input();
+}
+
+void RdpSession::watch_backlog() {
+    // Set the flag, then look at the ring again: either the RDP thread's
+    // next drain sees the flag, or this flush sees the room that drain made
+    input_backlogged_.store(true, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    input_.flush();
+}
+
+void RdpSession::wake_input() {
+    // One wake-up per drain is enough
+    if (!input_wake_pending_.exchange(true, std::memory_order_acq_rel)) {
+        SetEvent(input_event_);
+    }
+}
+
+// ── RDP thread: input ring consumer ───────────────────────────────────
+
+static RECTANGLE_16 to_rect16(const Rect& rect) {
+    auto clamp = [](uint32_t v) { return static_cast<UINT16>(std::min<uint32_t>(v, UINT16_MAX)); };
+    return {clamp(rect.x), clamp(rect.y), clamp(rect.right()), clamp(rect.bottom())};
+}
+
+void RdpSession::drain_input() {
+    TRACE_SCOPE("drain_input");
+    ResetEvent(input_event_);
+    // Pairs with the producer's exchange: everything pushed before it set
+    // the flag is visible to the pops below
+    input_wake_pending_.exchange(false, std::memory_order_acq_rel);
+
+    // Moves that piled up while we were busy (e.g. blocked in a TLS write)
+    // collapse to the last one before the next other event
+    rdpInput* input = instance_->context->input;
+    InputCoalescer motion;
+    auto send_motion = [&](std::optional<PointerPosition> position) {
+        if (position) {
+            freerdp_input_send_mouse_event(input, PTR_FLAGS_MOVE, position->x, position->y);
+        }
+    };
+    while (auto event = input_.pop()) {
+        FlightRecorder::record(FlightEvent::InputSent, static_cast<uint32_t>(event->type),
+                               static_cast<uint64_t>(event->code) << 32 | event->flags);
+        if (event->type == InputEvent::Type::Mouse && event->flags == PTR_FLAGS_MOVE) {
+            send_motion(motion.motion(event->x, event->y));
+            continue;
+        }
+        send_motion(motion.take());
+        switch (event->type) {
+            case InputEvent::Type::Keyboard:
+                freerdp_input_send_keyboard_event(input, event->flags,
+                                                  static_cast<UINT8>(event->code));
+                break;
+            case InputEvent::Type::Mouse:
+                freerdp_input_send_mouse_event(input, event->flags, event->x, event->y);
+                break;
+            case InputEvent::Type::ExtendedMouse:
+                freerdp_input_send_extended_mouse_event(input, event->flags, event->x, event->y);
+                break;
+            case InputEvent::Type::VisibleArea:
+                send_visible_area(event->area, event->whole_desktop);
+                break;
+        }
+    }
+    send_motion(motion.take());
+
+    // The main thread holds input back until there is room for it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (input_backlogged_.exchange(false, std::memory_order_seq_cst)) {
+        push_sdl_event(GVRDP_EVENT_INPUT_DRAINED);
+    }
+}
+
+void RdpSession::send_visible_area(Rect area, bool whole_desktop) {
+    // Sized here, so a desktop resize the main thread has not seen yet is
+    // still covered
+    if (whole_desktop) {
+        area = {0, 0, gdi_width(), gdi_height()};
+        if (area.empty()) return;
+    }
+    whole_desktop_visible_ = whole_desktop;
+    if (visible_area_ && *visible_area_ == area) return;
+
+    // Before the first report the server sends everything, so nothing is stale
+    std::vector<Rect> exposed;
+    if (visible_area_ && !area.empty()) exposed = area.subtracted(*visible_area_);
+    bool was_suppressed = visible_area_ && visible_area_->empty();
+    visible_area_ = area;
+
+    rdpContext* context = instance_->context;
+    if (area.empty()) {
+        LOG_DEBUG("Window not visible, suppressing output");
+        IFCALL(context->update->SuppressOutput, context, FALSE, nullptr);
+        return;
+    }
+
+    RECTANGLE_16 visible = to_rect16(area);
+    IFCALL(context->update->SuppressOutput, context, TRUE, &visible);
+    if (!exposed.empty()) {
+        std::vector<RECTANGLE_16> rects;
+        for (const auto& rect : exposed) {
+            rects.push_back(to_rect16(rect));
+        }
+        IFCALL(context->update->RefreshRect, context, static_cast<BYTE>(rects.size()),
+               rects.data());
+    }
+    LOG_DEBUG("Visible area {}x{}+{}+{}{}", area.width, area.height, area.x, area.y,
+              was_suppressed ? " (output resumed)" : "");
 }
 
 uint32_t RdpSession::gdi_width() const {
@@ -164,9 +396,16 @@ uint32_t RdpSession::gdi_height() const {
     return static_cast<uint32_t>(instance_->context->gdi->height);
 }
 
-uint32_t RdpSession::gdi_stride() const {
-    if (!instance_ || !instance_->context || !instance_->context->gdi) return 0;
-    return static_cast<uint32_t>(instance_->context->gdi->stride);
+void RdpSession::publish_frame(const DamageRegion& damage,
+                               std::chrono::steady_clock::time_point received) {
+    rdpGdi* gdi = instance_->context->gdi;
+    frames_.publish(gdi->primary_buffer, static_cast<uint32_t>(gdi->width),
+                    static_cast<uint32_t>(gdi->height), static_cast<uint32_t>(gdi->stride),
+                    damage, received, std::chrono::steady_clock::now());
+    FlightRecorder::record(FlightEvent::FrameReady, 0, damage.area());
+    static Counter& frames =
+        Metrics::global().counter("gvrdp_frames_received_total", "Frames completed by the server");
+    frames.add();
 }
 
 // ── Callbacks ──────────────────────────────────────────────────────────
@@ -190,29 +429,55 @@ bool RdpSession::on_post_connect() {
 
     rdpContext* ctx = instance_->context;
 
-    // Initialize GDI with BGRA32 format (matches SDL ARGB8888)
-    if (!gdi_init(instance_, PIXEL_FORMAT_BGRA32)) {
+    // Initialize GDI painting straight into our own frame memory, in the
+    // renderer's native texture format. FreeRDP takes ownership of the buffer.
+    rdpSettings* settings = ctx->settings;
+    uint32_t width = freerdp_settings_get_uint32(settings, FreeRDP_DesktopWidth);
+    uint32_t height = freerdp_settings_get_uint32(settings, FreeRDP_DesktopHeight);
+    desktop_size_.store(static_cast<uint64_t>(width) << 32 | height, std::memory_order_relaxed);
+    uint32_t stride = frame_stride(width);
+    auto* buffer = static_cast<BYTE*>(frame_alloc(static_cast<size_t>(stride) * height));
+    if (!buffer) {
+        LOG_ERROR("Failed to allocate {}x{} frame buffer", width, height);
+        return false;
+    }
+    if (!gdi_init_ex(instance_, freerdp_format_for(sdl_pixel_format_), stride, buffer,
+                     frame_free)) {
         LOG_ERROR("Failed to initialize GDI");
         return false;
     }
 
+    // Server pointers become the local hardware cursor
+    register_pointer(ctx);
+
     // Set update callbacks
     rdpUpdate* update = ctx->update;
     update->BeginPaint = gvrdp_begin_paint;
     update->EndPaint = gvrdp_end_paint;
     update->DesktopResize = gvrdp_desktop_resize;
 
+    // GDI's decoders for the legacy paths, timed per codec
+    gdi_surface_bits_ = update->SurfaceBits;
+    gdi_bitmap_update_ = update->BitmapUpdate;
+    update->SurfaceBits = gvrdp_surface_bits;
+    update->BitmapUpdate = gvrdp_bitmap_update;
+
+    // Outermost, so it times our overrides and GDI's handlers alike
+    if (profile_updates_) {
+        if (!update_profiler_) update_profiler_ = std::make_unique<UpdateProfiler>(ctx);
+        update_profiler_->install();
+        LOG_INFO("Profiling update handlers");
+    }
+
     // Subscribe to channel connect/disconnect events
     PubSub_SubscribeChannelConnected(ctx->pubSub, gvrdp_on_channel_connected);
     PubSub_SubscribeChannelDisconnected(ctx->pubSub, gvrdp_on_channel_disconnected);
 
-    // Register graphics pipeline if available
-    if (!gdi_init_ex(instance_, PIXEL_FORMAT_BGRA32, 0, nullptr, nullptr)) {
-        // Not fatal, gdi_init already succeeded
-    }
-
     connected_ = true;
 
+    // Publish the initial (blank) frame; the first publish is always full-frame
+    publish_frame(DamageRegion{});
+
     // Push event to main thread
     push_sdl_event(GVRDP_EVENT_FRAME_READY);
 
@@ -222,6 +487,16 @@ bool RdpSession::on_post_connect() {
 void RdpSession::on_post_disconnect() {
     LOG_INFO("PostDisconnect callback");
 
+    if (update_profiler_) {
+        std::string report = update_profiler_->stats().report();
+        LOG_INFO("Update handler profile:");
+        for (size_t start = 0; start < report.size();) {
+            size_t end = report.find('\n', start);
+            LOG_INFO("  {}", report.substr(start, end - start));
+            start = end + 1;
+        }
+    }
+
     if (instance_ && instance_->context) {
         PubSub_UnsubscribeChannelConnected(instance_->context->pubSub,
                                            gvrdp_on_channel_connected);
@@ -238,12 +513,28 @@ bool RdpSession::on_begin_paint() {
     rdpGdi* gdi = instance_->context->gdi;
     gdi->primary->hdc->hwnd->invalid->null = TRUE;
     gdi->primary->hdc->hwnd->ninvalid = 0;
+    // A frame may span several paints; it was received with its first PDU
+    if (frame_received_ == std::chrono::steady_clock::time_point{}) {
+        frame_received_ = wake_time_;
+    }
     return true;
 }
 
 bool RdpSession::on_end_paint() {
     rdpGdi* gdi = instance_->context->gdi;
-    if (gdi->primary->hdc->hwnd->invalid->null) return true;
+    HGDI_WND hwnd = gdi->primary->hdc->hwnd;
+    if (hwnd->invalid->null) return true;
+
+    DamageRegion damage;
+    if (hwnd->ninvalid > 0) {
+        for (INT32 i = 0; i < hwnd->ninvalid; i++) {
+            add_gdi_rgn(damage, hwnd->cinvalid[i]);
+        }
+    } else {
+        add_gdi_rgn(damage, *hwnd->invalid);
+    }
+    publish_frame(damage, frame_received_);
+    frame_received_ = {};
 
     // Push frame ready event to main thread
     push_sdl_event(GVRDP_EVENT_FRAME_READY);
@@ -258,16 +549,61 @@ bool RdpSession::on_desktop_resize() {
 
     uint32_t width = freerdp_settings_get_uint32(settings, FreeRDP_DesktopWidth);
     uint32_t height = freerdp_settings_get_uint32(settings, FreeRDP_DesktopHeight);
-
-    if (!gdi_resize(gdi, width, height)) {
-        LOG_ERROR("gdi_resize failed");
-        return false;
+    desktop_size_.store(static_cast<uint64_t>(width) << 32 | height, std::memory_order_relaxed);
+
+    // gdi_resize_ex() ignores a same-size request without taking the buffer
+    if (width != static_cast<uint32_t>(gdi->width) ||
+        height != static_cast<uint32_t>(gdi->height)) {
+        uint32_t stride = frame_stride(width);
+        auto* buffer = static_cast<BYTE*>(frame_alloc(static_cast<size_t>(stride) * height));
+        if (!buffer) {
+            LOG_ERROR("Failed to allocate {}x{} frame buffer", width, height);
+            return false;
+        }
+        if (!gdi_resize_ex(gdi, width, height, stride, gdi->dstFormat, buffer, frame_free)) {
+            LOG_ERROR("gdi_resize failed");
+            return false;
+        }
     }
 
+    // gdi_resize() reallocated the primary buffer; the exchange notices the
+    // new size and publishes a full frame from the new buffer
+    publish_frame(DamageRegion{});
+
+    // A fully visible window now sees the new size; a partly visible one is
+    // re-reported by the main thread once its viewport follows
+    if (visible_area_ && whole_desktop_visible_) send_visible_area({}, true);
+
     push_sdl_event(GVRDP_EVENT_RESIZE);
     return true;
 }
 
+bool RdpSession::on_surface_bits(const SURFACE_BITS_COMMAND* cmd) {
+    Codec codec = Codec::Uncompressed;
+    switch (cmd->bmp.codecID) {
+        case RDP_CODEC_ID_REMOTEFX: codec = Codec::RemoteFx; break;
+        case RDP_CODEC_ID_NSCODEC: codec = Codec::NsCodec; break;
+        default: break;
+    }
+    CodecStats::Scope timing(&codec_stats_, codec, cmd->bmp.bitmapDataLength);
+    return gdi_surface_bits_ && gdi_surface_bits_(instance_->context, cmd);
+}
+
+bool RdpSession::on_bitmap_update(const BITMAP_UPDATE* bitmap) {
+    // One update mixes rectangles; attribute it to the first one's codec
+    Codec codec = Codec::Uncompressed;
+    size_t bytes = 0;
+    for (UINT32 i = 0; i < bitmap->number; i++) {
+        const BITMAP_DATA& data = bitmap->rectangles[i];
+        if (i == 0 && data.compressed) {
+            codec = data.bitsPerPixel == 32 ? Codec::Planar : Codec::Interleaved;
+        }
+        bytes += data.bitmapLength;
+    }
+    CodecStats::Scope timing(&codec_stats_, codec, bytes);
+    return gdi_bitmap_update_ && gdi_bitmap_update_(instance_->context, bitmap);
+}
+
 uint32_t RdpSession::on_verify_certificate(const char* host, uint16_t port,
                                             const char* /*common_name*/, const char* subject,
                                             const char* issuer, const char* fingerprint,
@@ -293,17 +629,30 @@ void RdpSession::on_channel_connected(const char* name, void* iface) {
         if (disp_channel_) {
             disp_channel_->on_connected(static_cast<DispClientContext*>(iface));
         }
+    } else if (strcmp(name, RDPGFX_DVC_CHANNEL_NAME) == 0) {
+        auto* gfx = static_cast<RdpgfxClientContext*>(iface);
+        if (!gfx_pipeline_ || !gfx_pipeline_->attach(instance_->context->gdi, gfx)) {
+            // Plain FreeRDP composition into the GDI buffer
+            gdi_graphics_pipeline_init(instance_->context->gdi, gfx);
+        }
     }
     // Additional channels handled here in future phases
 }
 
-void RdpSession::on_channel_disconnected(const char* name, void* /*iface*/) {
+void RdpSession::on_channel_disconnected(const char* name, void* iface) {
     if (!name) return;
 
     if (strcmp(name, DISP_DVC_CHANNEL_NAME) == 0) {
         if (disp_channel_) {
             disp_channel_->on_disconnected();
         }
+    } else if (strcmp(name, RDPGFX_DVC_CHANNEL_NAME) == 0) {
+        if (gfx_pipeline_ && gfx_pipeline_->is_attached()) {
+            gfx_pipeline_->detach();
+        } else {
+            gdi_graphics_pipeline_uninit(instance_->context->gdi,
+                                         static_cast<RdpgfxClientContext*>(iface));
+        }
     }
 }
 
@@ -311,6 +660,7 @@ void RdpSession::on_channel_disconnected(const char* name, void* /*iface*/) {
 
 void RdpSession::rdp_thread_func() {
     LOG_INFO("RDP thread started");
+    Tracer::set_thread_name("rdp");
 
     if (!freerdp_connect(instance_)) {
         LOG_ERROR("freerdp_connect failed");
@@ -318,25 +668,66 @@ void RdpSession::rdp_thread_func() {
         LOG_ERROR("FreeRDP error: 0x{:08X} - {}", error,
                   freerdp_get_last_error_string(error));
         last_error_ = RdpError::ConnectionFailed;
+        FlightRecorder::record(FlightEvent::Error, static_cast<uint32_t>(last_error_), error);
         push_sdl_event(GVRDP_EVENT_ERROR);
         return;
     }
-
-    // Event loop
+    FlightRecorder::record(FlightEvent::Connected);
+
+    // Event loop. Sleeps until the transport, a channel, queued input or
+    // disconnect() signals a handle; there is no polling timeout.
+#if GVRDP_LINUX
+    FdReactor reactor;
+    std::vector<int> fds;
+#endif
+    Gauge& rtt = Metrics::global().gauge("gvrdp_rtt_milliseconds",
+                                         "Average round-trip time reported by the server");
     while (!freerdp_shall_disconnect_context(instance_->context) && !should_disconnect_) {
         HANDLE handles[64] = {};
-        DWORD nCount = freerdp_get_event_handles(instance_->context, handles, 64);
+        DWORD nCount = freerdp_get_event_handles(instance_->context, handles, 63);
         if (nCount == 0) {
             LOG_ERROR("freerdp_get_event_handles failed");
             break;
         }
-
-        DWORD status = WaitForMultipleObjects(nCount, handles, FALSE, 100);
-        if (status == WAIT_FAILED) {
+        // Queued input wakes us like socket data does
+        handles[nCount++] = input_event_;
+
+        auto wait_started = std::chrono::steady_clock::now();
+        bool waited = false;
+#if GVRDP_LINUX
+        // WinPR events are backed by file descriptors. The set rarely
+        // changes, so epoll keeps it registered instead of WinPR building a
+        // poll() set per wait; set_fds() re-adds any descriptor FreeRDP
+        // closed and reopened. Anything without a descriptor falls back.
+        fds.clear();
+        for (DWORD i = 0; i < nCount; i++) {
+            int fd = GetEventFileDescriptor(handles[i]);
+            if (fd < 0) break;
+            fds.push_back(fd);
+        }
+        if (fds.size() == nCount && reactor.set_fds(fds)) {
+            if (reactor.wait(-1) < 0) {
+                LOG_ERROR("epoll_wait failed");
+                break;
+            }
+            waited = true;
+        }
+#endif
+        if (!waited && WaitForMultipleObjects(nCount, handles, FALSE, INFINITE) == WAIT_FAILED) {
             LOG_ERROR("WaitForMultipleObjects failed");
             break;
         }
+        wake_time_ = std::chrono::steady_clock::now();
+        if (Tracer::enabled()) Tracer::record("wait", wait_started, wake_time_);
+        auto waited_us =
+            std::chrono::duration_cast<std::chrono::microseconds>(wake_time_ - wait_started);
+        FlightRecorder::record(FlightEvent::RdpWake,
+                               static_cast<uint32_t>(std::min<int64_t>(waited_us.count(),
+                                                                       UINT32_MAX)));
 
+        drain_input();
+
+        TRACE_SCOPE("check_event_handles");
         if (!freerdp_check_event_handles(instance_->context)) {
             if (freerdp_get_last_error(instance_->context) ==
                 FREERDP_ERROR_SUCCESS) {
@@ -345,13 +736,33 @@ void RdpSession::rdp_thread_func() {
             LOG_ERROR("freerdp_check_event_handles failed");
             break;
         }
+
+        // Filled in by the server's network characteristics results
+        if (rdpAutoDetect* autodetect = instance_->context->autodetect) {
+            rtt.set(autodetect->netCharAverageRTT);
+        }
     }
 
+    FlightRecorder::record(FlightEvent::Disconnected, should_disconnect_ ? 1 : 0,
+                           freerdp_get_last_error(instance_->context));
     freerdp_disconnect(instance_);
     LOG_INFO("RDP thread finished");
 }
 
+void RdpSession::push_pointer_command(PointerCommand command) {
+    pointer_commands_.push(std::move(command));
+    if (!pointer_event_pending_.exchange(true)) {
+        push_sdl_event(GVRDP_EVENT_POINTER);
+    }
+}
+
 void RdpSession::push_sdl_event(GvrdpEvent type, int /*code*/, void* data1) {
+    // Collapse frame notifications: one outstanding event is enough, the main
+    // thread picks up all accumulated damage when it handles it.
+    if (type == GVRDP_EVENT_FRAME_READY && frame_event_pending_.exchange(true)) {
+        return;
+    }
+
     SDL_Event event = {};
     event.type = SDL_USEREVENT;
     event.user.windowID = sdl_window_id_;
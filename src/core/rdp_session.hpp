@@ -1,15 +1,27 @@
 #pragma once
 
 #include "config/connection_profile.hpp"
+#include "core/codec_stats.hpp"
 #include "core/rdp_context.hpp"
+#include "core/frame_exchange.hpp"
 #include "core/rdp_error.hpp"
+#include "core/rdp_gfx.hpp"
+#include "core/update_profiler.hpp"
+#include "render/pointer_shape.hpp"
+#include "util/backlog_ring.hpp"
+#include "util/damage_region.hpp"
+#include "util/thread_safe_queue.hpp"
 
 #include <freerdp/freerdp.h>
 
 #include <atomic>
+#include <chrono>
+#include <filesystem>
 #include <functional>
-#include <mutex>
+#include <memory>
+#include <optional>
 #include <thread>
+#include <utility>
 
 struct SDL_UserEvent;
 
@@ -23,6 +35,8 @@ enum GvrdpEvent : int {
     GVRDP_EVENT_DISCONNECT,
     GVRDP_EVENT_RESIZE,
     GVRDP_EVENT_ERROR,
+    GVRDP_EVENT_POINTER,
+    GVRDP_EVENT_INPUT_DRAINED,  // Room in the input ring; see flush_input()
 };
 
 class RdpSession {
@@ -34,24 +48,102 @@ public:
     RdpSession& operator=(const RdpSession&) = delete;
 
     // Lifecycle
-    bool connect(const ConnectionProfile& profile, uint32_t sdl_window_id);
+    // sdl_pixel_format is the renderer's native texture format; GDI paints in
+    // the matching FreeRDP format so uploads never need a swizzle.
+    bool connect(const ConnectionProfile& profile, uint32_t sdl_window_id,
+                 uint32_t sdl_pixel_format);
     void disconnect();
     bool is_connected() const;
+
+    // GFX tile decode workers for the next connect(); 0 = cores - 1
+    void set_decode_threads(size_t threads) { decode_threads_ = threads; }
+
+    // GfxRenderer's texture size limit for the next connect(); larger GFX
+    // outputs are composed by FreeRDP's GDI instead (0 = no limit)
+    void set_gfx_surface_limit(uint32_t size) { gfx_surface_limit_ = size; }
+
+    // Where per-host bitmap caches live, and their size cap (0 = no cache)
+    void set_persistent_cache(const std::filesystem::path& dir, uint64_t limit_bytes) {
+        cache_dir_ = dir;
+        cache_limit_bytes_ = limit_bytes;
+    }
+    // Time every FreeRDP update handler from the next connect(), see
+    // UpdateProfiler. The report is logged at disconnect.
+    void set_update_profiling(bool enabled) { profile_updates_ = enabled; }
+
     RdpError last_error() const;
+    const ConnectionProfile& profile() const { return profile_; }
 
-    // Called from main thread
-    void request_resolution_change(uint32_t width, uint32_t height);
+    // Called from main thread; false if the layout could not be sent
+    bool request_resolution_change(uint32_t width, uint32_t height);
 
-    // Input forwarding (thread-safe)
+    // Desktop size as of the last connect or server resize (any thread)
+    std::pair<uint32_t, uint32_t> desktop_size() const {
+        uint64_t size = desktop_size_.load(std::memory_order_relaxed);
+        return {static_cast<uint32_t>(size >> 32), static_cast<uint32_t>(size)};
+    }
+
+    // Input forwarding (main thread only). Events go through a lock-free
+    // ring and are encoded and sent by the RDP thread.
     void send_keyboard_event(uint16_t flags, uint8_t code);
     void send_mouse_event(uint16_t flags, uint16_t x, uint16_t y);
     void send_extended_mouse_event(uint16_t flags, uint16_t x, uint16_t y);
 
-    // GDI buffer access (for frame copy on main thread)
-    const uint8_t* gdi_buffer() const;
+    // Main thread: the part of the desktop the user can see (empty = none,
+    // nullopt = all of it, at whatever size the desktop has). The RDP thread
+    // sends Suppress Output when it changes, and a Refresh Rect for the
+    // area that just became visible.
+    void set_visible_area(const std::optional<Rect>& area);
+
+    // Main thread: moves input held back by a full ring into it. Call on
+    // GVRDP_EVENT_INPUT_DRAINED; any later input also flushes first.
+    void flush_input();
+
+    // Current GDI surface size (RDP thread owns the surface itself)
     uint32_t gdi_width() const;
     uint32_t gdi_height() const;
-    uint32_t gdi_stride() const;
+
+    // Main thread: newest complete frame published by EndPaint since the last
+    // call, or nullptr. Its damage covers every change since the previously
+    // acquired frame. Valid until the next call.
+    const DesktopFrame* acquire_frame() { return frames_.acquire(); }
+
+    // Main thread: the newest frame returned by acquire_frame(), for
+    // re-uploading after the renderer lost its textures.
+    const DesktopFrame* current_frame() const { return frames_.current(); }
+
+    // RDPGFX: while active, the desktop is composed from GFX batches instead
+    // of the frames above. FRAME_READY also signals new batches.
+    bool gfx_active() const { return gfx_pipeline_ && gfx_pipeline_->is_active(); }
+    std::optional<GfxBatch> pop_gfx_batch() {
+        return gfx_pipeline_ ? gfx_pipeline_->pop_batch() : std::nullopt;
+    }
+    void resync_gfx() {
+        if (gfx_pipeline_) gfx_pipeline_->resync();
+    }
+    // Main thread, after present(): the popped GFX frames are on screen
+    void gfx_presented() {
+        if (gfx_pipeline_) gfx_pipeline_->acknowledge_presented();
+    }
+    GfxPipeline* gfx_pipeline() const { return gfx_pipeline_.get(); }
+
+    // Bytes and decode time per codec since connect (any thread)
+    const CodecStats& codec_stats() const { return codec_stats_; }
+
+    // Calls, pixels and time per update order, or nullptr unless profiling
+    const UpdateStats* update_stats() const {
+        return update_profiler_ ? &update_profiler_->stats() : nullptr;
+    }
+
+    // Called by the main thread when it handles GVRDP_EVENT_FRAME_READY.
+    // Until then further frames do not push more events (they only add damage).
+    void acknowledge_frame_event() { frame_event_pending_ = false; }
+
+    // Pointer shape changes for SdlCursor. GVRDP_EVENT_POINTER is pushed
+    // once until the main thread acknowledges it and drains the queue.
+    void push_pointer_command(PointerCommand command);  // RDP thread
+    std::optional<PointerCommand> pop_pointer_command() { return pointer_commands_.try_pop(); }
+    void acknowledge_pointer_event() { pointer_event_pending_ = false; }
 
     // Callbacks invoked by C trampolines
     bool on_pre_connect();
@@ -60,6 +152,8 @@ public:
     bool on_begin_paint();
     bool on_end_paint();
     bool on_desktop_resize();
+    bool on_surface_bits(const SURFACE_BITS_COMMAND* cmd);
+    bool on_bitmap_update(const BITMAP_UPDATE* bitmap);
     uint32_t on_verify_certificate(const char* host, uint16_t port, const char* common_name,
                                    const char* subject, const char* issuer, const char* fingerprint,
                                    uint32_t flags);
@@ -77,6 +171,27 @@ public:
 private:
     void rdp_thread_func();
     void push_sdl_event(GvrdpEvent type, int code = 0, void* data1 = nullptr);
+    void publish_frame(const DamageRegion& damage,
+                       std::chrono::steady_clock::time_point received = {});
+
+    // Main thread -> RDP thread, through input_
+    struct InputEvent {
+        enum class Type : uint8_t { Keyboard, Mouse, ExtendedMouse, VisibleArea };
+        Type type = Type::Keyboard;
+        uint16_t flags = 0;  // KBD_FLAGS_* or PTR_FLAGS_*
+        uint16_t code = 0;   // Keyboard scancode
+        uint16_t x = 0;
+        uint16_t y = 0;
+        Rect area;           // VisibleArea
+        bool whole_desktop = false;  // VisibleArea: ignore `area`, send the desktop size
+    };
+    // Never waits: with the ring full, input is held in the ring's backlog
+    // until flush_input()
+    void enqueue_input(const InputEvent& event);
+    void watch_backlog();  // Asks the RDP thread to report its next drain
+    void wake_input();
+    void drain_input();                        // RDP thread
+    void send_visible_area(Rect area, bool whole_desktop);  // RDP thread
 
     freerdp* instance_ = nullptr;
     GvrdpContext* context_ = nullptr;
@@ -86,10 +201,46 @@ private:
     RdpError last_error_ = RdpError::None;
     ConnectionProfile profile_;
     uint32_t sdl_window_id_ = 0;
-    std::mutex send_mutex_;
+    uint32_t sdl_pixel_format_ = 0;
+    size_t decode_threads_ = 0;
+    uint32_t gfx_surface_limit_ = 0;
+    std::filesystem::path cache_dir_;
+    uint64_t cache_limit_bytes_ = 0;
+
+    // Input: single producer (main thread), single consumer (RDP thread)
+    static constexpr size_t kInputRingSize = 1024;
+    BacklogRing<InputEvent, kInputRingSize> input_;
+    HANDLE input_event_ = nullptr;              // Set when the ring has new input
+    std::atomic<bool> input_wake_pending_{false};
+    // Main thread has a backlog: the RDP thread sends GVRDP_EVENT_INPUT_DRAINED
+    // after its next drain
+    std::atomic<bool> input_backlogged_{false};
+    std::optional<Rect> visible_area_;  // RDP thread; unset until reported: all visible
+    bool whole_desktop_visible_ = false;  // RDP thread; visible_area_ follows desktop resizes
+
+    // Completed frames handed from the RDP thread to the main thread
+    FrameExchange frames_;
+    std::atomic<bool> frame_event_pending_{false};
+    std::atomic<uint64_t> desktop_size_{0};  // width << 32 | height
+    ThreadSafeQueue<PointerCommand> pointer_commands_;
+    std::atomic<bool> pointer_event_pending_{false};
+    // RDP thread: when the wait last returned, and when the frame being
+    // painted was received (unset between frames)
+    std::chrono::steady_clock::time_point wake_time_;
+    std::chrono::steady_clock::time_point frame_received_;
+
+    // Legacy (non-GFX) bitmap paths, wrapped for codec statistics
+    CodecStats codec_stats_;
+    pSurfaceBits gdi_surface_bits_ = nullptr;
+    pBitmapUpdate gdi_bitmap_update_ = nullptr;
+
+    // Opt-in timing of every update handler
+    bool profile_updates_ = false;
+    std::unique_ptr<UpdateProfiler> update_profiler_;
 
     // Channel objects
     std::unique_ptr<DispChannel> disp_channel_;
+    std::unique_ptr<GfxPipeline> gfx_pipeline_;
 
     // Certificate auto-accept flag
     bool ignore_certificate_ = false;
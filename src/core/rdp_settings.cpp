@@ -1,9 +1,12 @@
 #include "core/rdp_settings.hpp"
 
+#include "core/h264_decoder.hpp"
 #include "util/logger.hpp"
 
 #include <freerdp/settings.h>
 
+#include <system_error>
+
 namespace gvrdp {
 
 bool apply_profile_to_settings(rdpSettings* settings, const ConnectionProfile& profile) {
@@ -39,12 +42,14 @@ bool apply_profile_to_settings(rdpSettings* settings, const ConnectionProfile& p
     if (!freerdp_settings_set_bool(settings, FreeRDP_Fullscreen, profile.fullscreen))
         return false;
 
-    // Dynamic resolution
+    // Dynamic resolution. Smart sizing scales locally and never sends a
+    // layout, so the display control channel is not even opened.
+    bool dynamic_resolution = profile.dynamic_resolution && !profile.smart_sizing;
     if (!freerdp_settings_set_bool(settings, FreeRDP_SupportDisplayControl,
-                                   profile.dynamic_resolution))
+                                   dynamic_resolution))
         return false;
     if (!freerdp_settings_set_bool(settings, FreeRDP_DynamicResolutionUpdate,
-                                   profile.dynamic_resolution))
+                                   dynamic_resolution))
         return false;
 
     // Software GDI (required for buffer access)
@@ -63,6 +68,56 @@ bool apply_profile_to_settings(rdpSettings* settings, const ConnectionProfile& p
     if (!freerdp_settings_set_bool(settings, FreeRDP_DisableThemes, !profile.enable_themes))
         return false;
 
+    // Let the window stop the server's output while it cannot be seen, and
+    // ask for just the exposed area afterwards (RdpSession::set_visible_area)
+    if (!freerdp_settings_set_bool(settings, FreeRDP_SuppressOutput, TRUE))
+        return false;
+    if (!freerdp_settings_set_bool(settings, FreeRDP_RefreshRect, TRUE))
+        return false;
+
+    // Pointers up to 384x384, kept in the server's pointer cache and shown as
+    // the local cursor (see register_pointer)
+    if (!freerdp_settings_set_uint32(settings, FreeRDP_PointerCacheSize, 25))
+        return false;
+    if (!freerdp_settings_set_uint32(settings, FreeRDP_LargePointerFlag,
+                                     LARGE_POINTER_FLAG_96x96 | LARGE_POINTER_FLAG_384x384))
+        return false;
+
+    // Lets the server measure the connection and report its RTT (see metrics)
+    if (!freerdp_settings_set_bool(settings, FreeRDP_NetworkAutoDetect, TRUE))
+        return false;
+
+    // Graphics pipeline (RDPGFX); composed on the GPU by GfxRenderer. Dynamic
+    // channels get their own thread so GFX decoding never stalls socket reads.
+    if (!freerdp_settings_set_bool(settings, FreeRDP_SynchronousDynamicChannels, FALSE))
+        return false;
+    if (!freerdp_settings_set_bool(settings, FreeRDP_SupportGraphicsPipeline,
+                                   profile.enable_gfx_pipeline))
+        return false;
+
+    // Codecs. AVC420 can be decoded to YUV and converted on the GPU; AVC444
+    // cannot (SDL2 has no 4:4:4 texture format to recombine its two streams).
+    CodecSelection codecs = resolve_codecs(profile, H264Decoder::available());
+    if (!freerdp_settings_set_bool(settings, FreeRDP_RemoteFxCodec, codecs.remotefx))
+        return false;
+    if (!freerdp_settings_set_bool(settings, FreeRDP_NSCodec, codecs.nscodec))
+        return false;
+    if (!freerdp_settings_set_bool(settings, FreeRDP_GfxProgressive, codecs.progressive))
+        return false;
+    if (!freerdp_settings_set_bool(settings, FreeRDP_GfxProgressiveV2, codecs.progressive))
+        return false;
+    if (!freerdp_settings_set_bool(settings, FreeRDP_GfxPlanar, codecs.planar))
+        return false;
+    if (!freerdp_settings_set_bool(settings, FreeRDP_GfxH264, codecs.avc420 || codecs.avc444))
+        return false;
+    if (!freerdp_settings_set_bool(settings, FreeRDP_GfxAVC444, codecs.avc444))
+        return false;
+    if (!freerdp_settings_set_bool(settings, FreeRDP_GfxAVC444v2, codecs.avc444))
+        return false;
+    LOG_INFO("Codecs: RemoteFX={} NSCodec={} progressive={} planar={} AVC420={}{} AVC444={}",
+             codecs.remotefx, codecs.nscodec, codecs.progressive, codecs.planar, codecs.avc420,
+             codecs.gpu_h264 ? " (GPU YUV)" : "", codecs.avc444);
+
     // Auto-logon
     if (!profile.username.empty() && !profile.password.empty()) {
         if (!freerdp_settings_set_bool(settings, FreeRDP_AutoLogonEnabled, TRUE))
@@ -78,4 +133,28 @@ bool apply_profile_to_settings(rdpSettings* settings, const ConnectionProfile& p
     return true;
 }
 
+bool apply_cache_settings(rdpSettings* settings, const ConnectionProfile& profile,
+                          const std::filesystem::path& cache_file) {
+    if (!settings) return false;
+
+    // rdpgfx also offers FreeRDP's file when this is set; that would be a
+    // second import offer next to GfxPipeline's
+    bool legacy = !cache_file.empty() && !profile.enable_gfx_pipeline;
+    if (!freerdp_settings_set_bool(settings, FreeRDP_BitmapCachePersistEnabled, legacy))
+        return false;
+    if (!legacy) return true;
+
+    std::error_code ec;
+    std::filesystem::create_directories(cache_file.parent_path(), ec);
+    std::filesystem::path legacy_file = cache_file;
+    legacy_file.replace_extension(".bmc");
+    if (!freerdp_settings_set_bool(settings, FreeRDP_BitmapCacheEnabled, TRUE))
+        return false;
+    if (!freerdp_settings_set_string(settings, FreeRDP_BitmapCachePersistFile,
+                                     legacy_file.string().c_str()))
+        return false;
+    LOG_INFO("Persistent bitmap cache: {}", legacy_file.string());
+    return true;
+}
+
 }  // namespace gvrdp
@@ -4,9 +4,17 @@
 
 #include <freerdp/freerdp.h>
 
+#include <filesystem>
+
 namespace gvrdp {
 
 // Maps a ConnectionProfile to FreeRDP settings on the rdpContext.
 bool apply_profile_to_settings(rdpSettings* settings, const ConnectionProfile& profile);
 
+// Points FreeRDP's legacy persistent bitmap cache at the host's cache file
+// (empty = no persistent cache). With RDPGFX it stays off: GfxPipeline
+// offers its own store instead.
+bool apply_cache_settings(rdpSettings* settings, const ConnectionProfile& profile,
+                          const std::filesystem::path& cache_file);
+
 }  // namespace gvrdp
@@ -0,0 +1,75 @@
+#include "core/resize_controller.hpp"
+
+#include <algorithm>
+
+namespace gvrdp {
+
+ResizeController::ResizeController(Send send, Options options)
+    : send_(std::move(send)), options_(options) {}
+
+void ResizeController::set_desktop_size(uint32_t width, uint32_t height) {
+    desktop_ = layout_size(width, height);
+}
+
+void ResizeController::request(uint32_t width, uint32_t height, Clock::time_point now) {
+    if (width == 0 || height == 0) return;
+    wanted_ = layout_size(width, height);
+    requested_ = now;
+}
+
+void ResizeController::on_desktop_resize(uint32_t width, uint32_t height, Clock::time_point now) {
+    desktop_ = layout_size(width, height);
+    if (!in_flight_) return;
+
+    // Smoothed like TCP's SRTT: new samples weigh 1/4
+    auto sample = std::chrono::duration_cast<std::chrono::microseconds>(now - in_flight_->sent);
+    srtt_ = srtt_ ? (*srtt_ * 3 + sample) / 4 : sample;
+    in_flight_.reset();
+}
+
+void ResizeController::poll(Clock::time_point now) {
+    // No answer: the server dropped or ignored it
+    if (in_flight_ && now - in_flight_->sent >= options_.confirm_timeout) {
+        in_flight_.reset();
+    }
+    if (in_flight_ || !wanted_ || now - requested_ < debounce()) return;
+
+    if (*wanted_ == desktop_) {
+        wanted_.reset();
+        return;
+    }
+    if (!send_ || !send_(wanted_->width, wanted_->height)) {
+        requested_ = now;  // Try again after another quiet period
+        return;
+    }
+    in_flight_ = InFlight{*wanted_, now};
+    wanted_.reset();
+    layouts_sent_++;
+}
+
+std::optional<ResizeController::Duration> ResizeController::time_until_deadline(
+    Clock::time_point now) const {
+    Clock::time_point deadline;
+    if (in_flight_) {
+        deadline = in_flight_->sent + options_.confirm_timeout;
+    } else if (wanted_) {
+        deadline = requested_ + debounce();
+    } else {
+        return std::nullopt;
+    }
+    if (now >= deadline) return Duration::zero();
+    return std::chrono::ceil<Duration>(deadline - now);
+}
+
+ResizeController::Duration ResizeController::debounce() const {
+    if (!srtt_) return options_.initial_debounce;
+    return std::clamp(std::chrono::ceil<Duration>(*srtt_), options_.min_debounce,
+                      options_.max_debounce);
+}
+
+std::optional<ResizeController::Duration> ResizeController::round_trip() const {
+    if (!srtt_) return std::nullopt;
+    return std::chrono::ceil<Duration>(*srtt_);
+}
+
+}  // namespace gvrdp
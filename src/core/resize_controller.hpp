@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+
+namespace gvrdp {
+
+// Turns a stream of window sizes into display layouts for the server.
+//
+// At most one layout is in flight: the next is held until the server's
+// DesktopResize confirms the previous one (or a timeout gives up on it), and
+// then only the newest requested size is sent, so the final size is never
+// lost. Sizes are debounced, and the quiet period follows the measured
+// layout-to-resize round trip: short on a LAN, longer on slow links where
+// every layout costs the server a full re-layout. Driven by the main loop:
+// poll() sends what is due and time_until_deadline() bounds the wait.
+class ResizeController {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Duration = std::chrono::milliseconds;
+    // Sends one layout; false if it could not be sent (retried later)
+    using Send = std::function<bool(uint32_t width, uint32_t height)>;
+
+    struct Options {
+        Duration initial_debounce{200};  // Until a round trip is measured
+        Duration min_debounce{50};
+        Duration max_debounce{500};
+        Duration confirm_timeout{3000};  // Servers ignore layouts they cannot apply
+    };
+
+    explicit ResizeController(Send send) : ResizeController(std::move(send), Options{}) {}
+    ResizeController(Send send, Options options);
+
+    // The desktop size the session started with
+    void set_desktop_size(uint32_t width, uint32_t height);
+
+    // The window now has this size
+    void request(uint32_t width, uint32_t height, Clock::time_point now = Clock::now());
+
+    // The server resized the desktop; confirms the layout in flight
+    void on_desktop_resize(uint32_t width, uint32_t height, Clock::time_point now = Clock::now());
+
+    // Sends the newest size once it is due and nothing is in flight
+    void poll(Clock::time_point now = Clock::now());
+
+    // Time until poll() has something to do, or nullopt when idle
+    std::optional<Duration> time_until_deadline(Clock::time_point now = Clock::now()) const;
+
+    Duration debounce() const;
+    // Smoothed layout-to-resize time, once one was measured
+    std::optional<Duration> round_trip() const;
+    bool in_flight() const { return in_flight_.has_value(); }
+    uint64_t layouts_sent() const { return layouts_sent_; }
+
+private:
+    struct Size {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        bool operator==(const Size&) const = default;
+    };
+    struct InFlight {
+        Size size;
+        Clock::time_point sent;
+    };
+
+    // Layouts carry even sizes (see DispChannel), so a window one pixel
+    // wider than the desktop is already the right size
+    static Size layout_size(uint32_t width, uint32_t height) {
+        return {width & ~1u, height & ~1u};
+    }
+
+    Send send_;
+    Options options_;
+    Size desktop_;
+    std::optional<Size> wanted_;     // Newest size not yet sent
+    Clock::time_point requested_;    // When wanted_ last changed
+    std::optional<InFlight> in_flight_;
+    std::optional<std::chrono::microseconds> srtt_;
+    uint64_t layouts_sent_ = 0;
+};
+
+}  // namespace gvrdp
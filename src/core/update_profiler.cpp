@@ -0,0 +1,211 @@
+#include "core/update_profiler.hpp"
+
+#include "core/rdp_context.hpp"
+
+#include <freerdp/pointer.h>
+#include <freerdp/primary.h>
+#include <freerdp/secondary.h>
+#include <freerdp/update.h>
+
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+
+namespace gvrdp {
+
+namespace {
+
+// ── Pixels per order ──────────────────────────────────────────────────
+//
+// The area an order draws or caches. Orders are matched by the fields they
+// have; anything else (bounds, sounds, lines, status) counts 0.
+
+uint64_t area(int64_t width, int64_t height) {
+    return width > 0 && height > 0 ? static_cast<uint64_t>(width * height) : 0;
+}
+
+template <typename T>
+concept SizedOrder = requires(const T& o) {
+    o.nWidth;
+    o.nHeight;
+};
+
+template <typename T>
+concept BackgroundOrder = requires(const T& o) {
+    o.bkLeft;
+    o.bkTop;
+    o.bkRight;
+    o.bkBottom;
+};
+
+template <typename T>
+concept MultiRectOrder = requires(const T& o) {
+    o.numRectangles;
+    o.rectangles[0].width;
+    o.rectangles[0].height;
+};
+
+template <typename T>
+concept CachedBitmap = requires(const T& o) {
+    o.bitmapWidth;
+    o.bitmapHeight;
+};
+
+template <typename T>
+concept PointerShape = requires(const T& o) {
+    o.width;
+    o.height;
+    o.xorMaskData;
+};
+
+// Some handlers take their order as a non-const pointer; T is deduced the
+// same either way
+template <typename T>
+uint64_t order_pixels(const T* o) {
+    if constexpr (!std::is_class_v<T>) {
+        return 0;
+    } else if constexpr (SizedOrder<T>) {
+        // DstBlt, PatBlt, ScrBlt, OpaqueRect, MemBlt, Mem3Blt, ...
+        return area(o->nWidth, o->nHeight);
+    } else if constexpr (BackgroundOrder<T>) {
+        // GlyphIndex, FastIndex, FastGlyph: the background box
+        return area(static_cast<int64_t>(o->bkRight) - o->bkLeft,
+                    static_cast<int64_t>(o->bkBottom) - o->bkTop);
+    } else if constexpr (MultiRectOrder<T>) {
+        // Multi*: rectangles are 1-based in FreeRDP's delta arrays
+        uint64_t pixels = 0;
+        for (uint32_t i = 1; i <= o->numRectangles; i++) {
+            pixels += area(o->rectangles[i].width, o->rectangles[i].height);
+        }
+        return pixels;
+    } else if constexpr (CachedBitmap<T>) {
+        // CacheBitmap, CacheBitmapV2
+        return area(o->bitmapWidth, o->bitmapHeight);
+    } else if constexpr (PointerShape<T>) {
+        // PointerColor, PointerLarge
+        return area(o->width, o->height);
+    } else if constexpr (std::is_same_v<T, CACHE_BITMAP_V3_ORDER>) {
+        return area(o->bitmapData.width, o->bitmapData.height);
+    } else if constexpr (std::is_same_v<T, POINTER_NEW_UPDATE>) {
+        return area(o->colorPtrAttr.width, o->colorPtrAttr.height);
+    } else if constexpr (std::is_same_v<T, BITMAP_UPDATE>) {
+        uint64_t pixels = 0;
+        for (uint32_t i = 0; i < o->number; i++) {
+            pixels += area(o->rectangles[i].width, o->rectangles[i].height);
+        }
+        return pixels;
+    } else if constexpr (std::is_same_v<T, SURFACE_BITS_COMMAND>) {
+        return area(o->bmp.width, o->bmp.height);
+    } else {
+        return 0;
+    }
+}
+
+// The order is the first argument after the context (SurfaceFrameBits has
+// more after it)
+template <typename First, typename... Rest>
+uint64_t order_pixels(First first, Rest...) {
+    if constexpr (std::is_pointer_v<First>) {
+        return order_pixels(static_cast<const std::remove_pointer_t<First>*>(first));
+    } else {
+        return 0;
+    }
+}
+
+uint64_t order_pixels() {
+    return 0;
+}
+
+UpdateProfiler* profiler_of(rdpContext* context) {
+    return reinterpret_cast<GvrdpContext*>(context)->profiler;
+}
+
+// Stands in for one handler: calls the original and records the call
+template <UpdateOrder Order, typename... Args>
+BOOL profiled(rdpContext* context, Args... args) {
+    using Clock = std::chrono::steady_clock;
+    using Fn = BOOL (*)(rdpContext*, Args...);
+
+    UpdateProfiler* profiler = profiler_of(context);
+    auto original = reinterpret_cast<Fn>(profiler->original(Order));
+    auto start = Clock::now();
+    BOOL result = original(context, args...);
+    profiler->stats().record(Order, order_pixels(args...), Clock::now() - start);
+    return result;
+}
+
+}  // namespace
+
+template <UpdateOrder Order, typename... Args>
+void UpdateProfiler::hook(BOOL (*&slot)(rdpContext*, Args...)) {
+    // Already ours: post-connect runs again after an automatic reconnect
+    if (!slot || slot == profiled<Order, Args...>) return;
+    originals_[static_cast<size_t>(Order)] = reinterpret_cast<Handler>(slot);
+    slot = profiled<Order, Args...>;
+}
+
+void UpdateProfiler::install() {
+    reinterpret_cast<GvrdpContext*>(context_)->profiler = this;
+
+    // Handlers the client calls to send (RefreshRect, SuppressOutput,
+    // SurfaceFrameAcknowledge) are not updates and are left alone
+    rdpUpdate* update = context_->update;
+    hook<UpdateOrder::BeginPaint>(update->BeginPaint);
+    hook<UpdateOrder::EndPaint>(update->EndPaint);
+    hook<UpdateOrder::SetBounds>(update->SetBounds);
+    hook<UpdateOrder::Synchronize>(update->Synchronize);
+    hook<UpdateOrder::DesktopResize>(update->DesktopResize);
+    hook<UpdateOrder::BitmapUpdate>(update->BitmapUpdate);
+    hook<UpdateOrder::Palette>(update->Palette);
+    hook<UpdateOrder::PlaySound>(update->PlaySound);
+    hook<UpdateOrder::SetKeyboardIndicators>(update->SetKeyboardIndicators);
+    hook<UpdateOrder::SetKeyboardImeStatus>(update->SetKeyboardImeStatus);
+    hook<UpdateOrder::SurfaceBits>(update->SurfaceBits);
+    hook<UpdateOrder::SurfaceFrameMarker>(update->SurfaceFrameMarker);
+    hook<UpdateOrder::SurfaceFrameBits>(update->SurfaceFrameBits);
+    hook<UpdateOrder::SaveSessionInfo>(update->SaveSessionInfo);
+    hook<UpdateOrder::ServerStatusInfo>(update->ServerStatusInfo);
+
+    rdpPrimaryUpdate* primary = update->primary;
+    hook<UpdateOrder::DstBlt>(primary->DstBlt);
+    hook<UpdateOrder::PatBlt>(primary->PatBlt);
+    hook<UpdateOrder::ScrBlt>(primary->ScrBlt);
+    hook<UpdateOrder::OpaqueRect>(primary->OpaqueRect);
+    hook<UpdateOrder::DrawNineGrid>(primary->DrawNineGrid);
+    hook<UpdateOrder::MultiDstBlt>(primary->MultiDstBlt);
+    hook<UpdateOrder::MultiPatBlt>(primary->MultiPatBlt);
+    hook<UpdateOrder::MultiScrBlt>(primary->MultiScrBlt);
+    hook<UpdateOrder::MultiOpaqueRect>(primary->MultiOpaqueRect);
+    hook<UpdateOrder::MultiDrawNineGrid>(primary->MultiDrawNineGrid);
+    hook<UpdateOrder::LineTo>(primary->LineTo);
+    hook<UpdateOrder::Polyline>(primary->Polyline);
+    hook<UpdateOrder::MemBlt>(primary->MemBlt);
+    hook<UpdateOrder::Mem3Blt>(primary->Mem3Blt);
+    hook<UpdateOrder::SaveBitmap>(primary->SaveBitmap);
+    hook<UpdateOrder::GlyphIndex>(primary->GlyphIndex);
+    hook<UpdateOrder::FastIndex>(primary->FastIndex);
+    hook<UpdateOrder::FastGlyph>(primary->FastGlyph);
+    hook<UpdateOrder::PolygonSC>(primary->PolygonSC);
+    hook<UpdateOrder::PolygonCB>(primary->PolygonCB);
+    hook<UpdateOrder::EllipseSC>(primary->EllipseSC);
+    hook<UpdateOrder::EllipseCB>(primary->EllipseCB);
+
+    rdpSecondaryUpdate* secondary = update->secondary;
+    hook<UpdateOrder::CacheBitmap>(secondary->CacheBitmap);
+    hook<UpdateOrder::CacheBitmapV2>(secondary->CacheBitmapV2);
+    hook<UpdateOrder::CacheBitmapV3>(secondary->CacheBitmapV3);
+    hook<UpdateOrder::CacheColorTable>(secondary->CacheColorTable);
+    hook<UpdateOrder::CacheGlyph>(secondary->CacheGlyph);
+    hook<UpdateOrder::CacheGlyphV2>(secondary->CacheGlyphV2);
+    hook<UpdateOrder::CacheBrush>(secondary->CacheBrush);
+
+    rdpPointerUpdate* pointer = update->pointer;
+    hook<UpdateOrder::PointerPosition>(pointer->PointerPosition);
+    hook<UpdateOrder::PointerSystem>(pointer->PointerSystem);
+    hook<UpdateOrder::PointerColor>(pointer->PointerColor);
+    hook<UpdateOrder::PointerLarge>(pointer->PointerLarge);
+    hook<UpdateOrder::PointerNew>(pointer->PointerNew);
+    hook<UpdateOrder::PointerCached>(pointer->PointerCached);
+}
+
+}  // namespace gvrdp
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "core/update_stats.hpp"
+
+#include <freerdp/freerdp.h>
+
+#include <array>
+
+namespace gvrdp {
+
+// Opt-in profiling shim: interposes on every handler in the context's
+// rdpUpdate, rdpPrimaryUpdate, rdpSecondaryUpdate and rdpPointerUpdate
+// tables and records calls, pixels and time per order in UpdateStats.
+//
+// install() must run after GDI and our own overrides are registered, so the
+// shim times the handler that really runs. Handlers that are not set stay
+// unset; FreeRDP treats a null handler differently from one that succeeds.
+class UpdateProfiler {
+public:
+    explicit UpdateProfiler(rdpContext* context) : context_(context) {}
+
+    UpdateProfiler(const UpdateProfiler&) = delete;
+    UpdateProfiler& operator=(const UpdateProfiler&) = delete;
+
+    // Wraps the handlers currently set; safe to call again after FreeRDP
+    // or GDI re-registered some of them
+    void install();
+
+    const UpdateStats& stats() const { return stats_; }
+
+    // Used by the wrappers: the handler that was in place before install()
+    using Handler = void (*)();
+    Handler original(UpdateOrder order) const { return originals_[static_cast<size_t>(order)]; }
+    UpdateStats& stats() { return stats_; }
+
+private:
+    template <UpdateOrder Order, typename... Args>
+    void hook(BOOL (*&slot)(rdpContext*, Args...));
+
+    rdpContext* context_;
+    UpdateStats stats_;
+    std::array<Handler, static_cast<size_t>(UpdateOrder::Count)> originals_{};
+};
+
+}  // namespace gvrdp
@@ -0,0 +1,125 @@
+#include "core/update_stats.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace gvrdp {
+
+const char* update_order_name(UpdateOrder order) {
+    switch (order) {
+        case UpdateOrder::BeginPaint: return "BeginPaint";
+        case UpdateOrder::EndPaint: return "EndPaint";
+        case UpdateOrder::SetBounds: return "SetBounds";
+        case UpdateOrder::Synchronize: return "Synchronize";
+        case UpdateOrder::DesktopResize: return "DesktopResize";
+        case UpdateOrder::BitmapUpdate: return "BitmapUpdate";
+        case UpdateOrder::Palette: return "Palette";
+        case UpdateOrder::PlaySound: return "PlaySound";
+        case UpdateOrder::SetKeyboardIndicators: return "SetKeyboardIndicators";
+        case UpdateOrder::SetKeyboardImeStatus: return "SetKeyboardImeStatus";
+        case UpdateOrder::SurfaceBits: return "SurfaceBits";
+        case UpdateOrder::SurfaceFrameMarker: return "SurfaceFrameMarker";
+        case UpdateOrder::SurfaceFrameBits: return "SurfaceFrameBits";
+        case UpdateOrder::SaveSessionInfo: return "SaveSessionInfo";
+        case UpdateOrder::ServerStatusInfo: return "ServerStatusInfo";
+        case UpdateOrder::DstBlt: return "DstBlt";
+        case UpdateOrder::PatBlt: return "PatBlt";
+        case UpdateOrder::ScrBlt: return "ScrBlt";
+        case UpdateOrder::OpaqueRect: return "OpaqueRect";
+        case UpdateOrder::DrawNineGrid: return "DrawNineGrid";
+        case UpdateOrder::MultiDstBlt: return "MultiDstBlt";
+        case UpdateOrder::MultiPatBlt: return "MultiPatBlt";
+        case UpdateOrder::MultiScrBlt: return "MultiScrBlt";
+        case UpdateOrder::MultiOpaqueRect: return "MultiOpaqueRect";
+        case UpdateOrder::MultiDrawNineGrid: return "MultiDrawNineGrid";
+        case UpdateOrder::LineTo: return "LineTo";
+        case UpdateOrder::Polyline: return "Polyline";
+        case UpdateOrder::MemBlt: return "MemBlt";
+        case UpdateOrder::Mem3Blt: return "Mem3Blt";
+        case UpdateOrder::SaveBitmap: return "SaveBitmap";
+        case UpdateOrder::GlyphIndex: return "GlyphIndex";
+        case UpdateOrder::FastIndex: return "FastIndex";
+        case UpdateOrder::FastGlyph: return "FastGlyph";
+        case UpdateOrder::PolygonSC: return "PolygonSC";
+        case UpdateOrder::PolygonCB: return "PolygonCB";
+        case UpdateOrder::EllipseSC: return "EllipseSC";
+        case UpdateOrder::EllipseCB: return "EllipseCB";
+        case UpdateOrder::CacheBitmap: return "CacheBitmap";
+        case UpdateOrder::CacheBitmapV2: return "CacheBitmapV2";
+        case UpdateOrder::CacheBitmapV3: return "CacheBitmapV3";
+        case UpdateOrder::CacheColorTable: return "CacheColorTable";
+        case UpdateOrder::CacheGlyph: return "CacheGlyph";
+        case UpdateOrder::CacheGlyphV2: return "CacheGlyphV2";
+        case UpdateOrder::CacheBrush: return "CacheBrush";
+        case UpdateOrder::PointerPosition: return "PointerPosition";
+        case UpdateOrder::PointerSystem: return "PointerSystem";
+        case UpdateOrder::PointerColor: return "PointerColor";
+        case UpdateOrder::PointerLarge: return "PointerLarge";
+        case UpdateOrder::PointerNew: return "PointerNew";
+        case UpdateOrder::PointerCached: return "PointerCached";
+        case UpdateOrder::Count: break;
+    }
+    return "Unknown";
+}
+
+void UpdateStats::record(UpdateOrder order, uint64_t pixels, std::chrono::nanoseconds time) {
+    if (order >= UpdateOrder::Count) return;
+    Counters& c = counters_[static_cast<size_t>(order)];
+    c.calls.fetch_add(1, std::memory_order_relaxed);
+    c.pixels.fetch_add(pixels, std::memory_order_relaxed);
+    c.time_ns.fetch_add(time.count(), std::memory_order_relaxed);
+}
+
+UpdateTotals UpdateStats::totals(UpdateOrder order) const {
+    UpdateTotals totals;
+    if (order >= UpdateOrder::Count) return totals;
+    const Counters& c = counters_[static_cast<size_t>(order)];
+    totals.calls = c.calls.load(std::memory_order_relaxed);
+    totals.pixels = c.pixels.load(std::memory_order_relaxed);
+    totals.time = std::chrono::nanoseconds(c.time_ns.load(std::memory_order_relaxed));
+    return totals;
+}
+
+void UpdateStats::reset() {
+    for (auto& c : counters_) {
+        c.calls.store(0, std::memory_order_relaxed);
+        c.pixels.store(0, std::memory_order_relaxed);
+        c.time_ns.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::string UpdateStats::report() const {
+    std::vector<std::pair<UpdateOrder, UpdateTotals>> called;
+    std::chrono::nanoseconds total{0};
+    for (size_t i = 0; i < counters_.size(); i++) {
+        auto order = static_cast<UpdateOrder>(i);
+        UpdateTotals t = totals(order);
+        if (t.calls == 0) continue;
+        called.emplace_back(order, t);
+        total += t.time;
+    }
+    std::stable_sort(called.begin(), called.end(), [](const auto& x, const auto& y) {
+        return x.second.time > y.second.time;
+    });
+
+    std::string out;
+    char line[128];
+    std::snprintf(line, sizeof(line), "%-22s %10s %14s %10s %9s %6s\n", "order", "calls",
+                  "pixels", "total ms", "us/call", "time");
+    out += line;
+    for (const auto& [order, t] : called) {
+        double ms = std::chrono::duration<double, std::milli>(t.time).count();
+        double share = total.count() > 0 ? 100.0 * static_cast<double>(t.time.count()) /
+                                               static_cast<double>(total.count())
+                                         : 0.0;
+        std::snprintf(line, sizeof(line), "%-22s %10llu %14llu %10.2f %9.1f %5.1f%%\n",
+                      update_order_name(order), static_cast<unsigned long long>(t.calls),
+                      static_cast<unsigned long long>(t.pixels), ms,
+                      ms * 1000.0 / static_cast<double>(t.calls), share);
+        out += line;
+    }
+    return out;
+}
+
+}  // namespace gvrdp
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace gvrdp {
+
+// Every update handler FreeRDP dispatches to the client, by table
+enum class UpdateOrder : uint8_t {
+    // rdpUpdate
+    BeginPaint,
+    EndPaint,
+    SetBounds,
+    Synchronize,
+    DesktopResize,
+    BitmapUpdate,
+    Palette,
+    PlaySound,
+    SetKeyboardIndicators,
+    SetKeyboardImeStatus,
+    SurfaceBits,
+    SurfaceFrameMarker,
+    SurfaceFrameBits,
+    SaveSessionInfo,
+    ServerStatusInfo,
+    // rdpPrimaryUpdate
+    DstBlt,
+    PatBlt,
+    ScrBlt,
+    OpaqueRect,
+    DrawNineGrid,
+    MultiDstBlt,
+    MultiPatBlt,
+    MultiScrBlt,
+    MultiOpaqueRect,
+    MultiDrawNineGrid,
+    LineTo,
+    Polyline,
+    MemBlt,
+    Mem3Blt,
+    SaveBitmap,
+    GlyphIndex,
+    FastIndex,
+    FastGlyph,
+    PolygonSC,
+    PolygonCB,
+    EllipseSC,
+    EllipseCB,
+    // rdpSecondaryUpdate
+    CacheBitmap,
+    CacheBitmapV2,
+    CacheBitmapV3,
+    CacheColorTable,
+    CacheGlyph,
+    CacheGlyphV2,
+    CacheBrush,
+    // rdpPointerUpdate
+    PointerPosition,
+    PointerSystem,
+    PointerColor,
+    PointerLarge,
+    PointerNew,
+    PointerCached,
+    Count,
+};
+
+const char* update_order_name(UpdateOrder order);
+
+struct UpdateTotals {
+    uint64_t calls = 0;
+    uint64_t pixels = 0;  // Area drawn or cached; 0 for orders without one
+    std::chrono::nanoseconds time{0};
+};
+
+// Calls, pixels and handler time per update order. Written by the RDP
+// thread, read from any; every counter is an independent relaxed atomic.
+class UpdateStats {
+public:
+    void record(UpdateOrder order, uint64_t pixels, std::chrono::nanoseconds time);
+    UpdateTotals totals(UpdateOrder order) const;
+    void reset();
+
+    // Orders that were called, most time first, as an aligned text table
+    std::string report() const;
+
+private:
+    struct Counters {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> pixels{0};
+        std::atomic<int64_t> time_ns{0};
+    };
+
+    std::array<Counters, static_cast<size_t>(UpdateOrder::Count)> counters_;
+};
+
+}  // namespace gvrdp
@@ -0,0 +1,37 @@
+#include "input/input_coalescer.hpp"
+
+namespace gvrdp {
+
+InputCoalescer::InputCoalescer(bool enabled, Duration min_interval)
+    : enabled_(enabled), min_interval_(min_interval) {}
+
+std::optional<PointerPosition> InputCoalescer::motion(uint16_t x, uint16_t y) {
+    PointerPosition position{x, y};
+    if (!enabled_) return position;
+    if (pending_) coalesced_++;
+    pending_ = position;
+    return std::nullopt;
+}
+
+std::optional<PointerPosition> InputCoalescer::take() {
+    auto position = pending_;
+    pending_.reset();
+    return position;
+}
+
+std::optional<PointerPosition> InputCoalescer::flush(Clock::time_point now) {
+    if (!pending_) return std::nullopt;
+    if (last_sent_ && now - *last_sent_ < min_interval_) return std::nullopt;
+    last_sent_ = now;
+    return take();
+}
+
+std::optional<InputCoalescer::Duration> InputCoalescer::time_until_deadline(
+    Clock::time_point now) const {
+    if (!pending_) return std::nullopt;
+    if (!last_sent_) return Duration::zero();
+    auto remaining = std::chrono::ceil<Duration>(*last_sent_ + min_interval_ - now);
+    return remaining > Duration::zero() ? remaining : Duration::zero();
+}
+
+}  // namespace gvrdp
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace gvrdp {
+
+struct PointerPosition {
+    uint16_t x = 0;
+    uint16_t y = 0;
+
+    bool operator==(const PointerPosition&) const = default;
+};
+
+// Collapses pointer motion to the latest position per send tick.
+//
+// Motion is held instead of sent. Before any other input (button, wheel,
+// key) the held position is taken and sent first, so the order the server
+// sees is exactly the order of the events. At the end of a tick flush()
+// releases it, at most once per `min_interval` (zero: every tick).
+// A disabled coalescer holds nothing and passes every position through.
+class InputCoalescer {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Duration = std::chrono::microseconds;
+
+    explicit InputCoalescer(bool enabled = true, Duration min_interval = Duration::zero());
+
+    // A new pointer position. Returns it if it must be sent right away.
+    std::optional<PointerPosition> motion(uint16_t x, uint16_t y);
+
+    // Before an ordered event: the held position, if any
+    std::optional<PointerPosition> take();
+
+    // End of a tick: the held position once the interval has passed
+    std::optional<PointerPosition> flush(Clock::time_point now);
+
+    bool has_pending() const { return pending_.has_value(); }
+
+    // Time until flush() will release the held position, or nullopt when
+    // nothing is held. Lets an event loop sleep until then.
+    std::optional<Duration> time_until_deadline(Clock::time_point now) const;
+
+    // Positions collapsed into a later one since construction
+    uint64_t coalesced() const { return coalesced_; }
+
+private:
+    bool enabled_;
+    Duration min_interval_;
+    std::optional<PointerPosition> pending_;
+    std::optional<Clock::time_point> last_sent_;
+    uint64_t coalesced_ = 0;
+};
+
+}  // namespace gvrdp
@@ -2,13 +2,15 @@
 
 #include "core/rdp_session.hpp"
 #include "input/keyboard_map.hpp"
+#include "util/damage_region.hpp"
 #include "util/logger.hpp"
 
 #include <freerdp/input.h>
 
 namespace gvrdp {
 
-InputHandler::InputHandler(RdpSession& session) : session_(session) {}
+InputHandler::InputHandler(RdpSession& session, InputCoalescer motion)
+    : session_(session), motion_(motion) {}
 
 bool InputHandler::handle_event(const SDL_Event& event) {
     switch (event.type) {
@@ -34,6 +36,25 @@ bool InputHandler::handle_event(const SDL_Event& event) {
     }
 }
 
+void InputHandler::flush_motion(InputCoalescer::Clock::time_point now) {
+    if (auto position = motion_.flush(now)) {
+        session_.send_mouse_event(PTR_FLAGS_MOVE, position->x, position->y);
+    }
+}
+
+void InputHandler::send_held_motion(std::optional<PointerPosition> next) {
+    auto position = motion_.take();
+    if (position && position != next) {
+        session_.send_mouse_event(PTR_FLAGS_MOVE, position->x, position->y);
+    }
+}
+
+PointerPosition InputHandler::to_desktop(int x, int y) const {
+    PointerPosition position;
+    viewport_.to_desktop(x, y, position.x, position.y);
+    return position;
+}
+
 void InputHandler::handle_key_event(const SDL_KeyboardEvent& key) {
     auto rdp_sc = sdl_scancode_to_rdp(key.keysym.scancode);
     if (rdp_sc.code == 0) return;
@@ -46,13 +67,15 @@ void InputHandler::handle_key_event(const SDL_KeyboardEvent& key) {
         flags |= KBD_FLAGS_EXTENDED;
     }
 
+    send_held_motion();
     session_.send_keyboard_event(flags, rdp_sc.code);
 }
 
 void InputHandler::handle_mouse_motion(const SDL_MouseMotionEvent& motion) {
-    uint16_t flags = PTR_FLAGS_MOVE;
-    session_.send_mouse_event(flags, static_cast<uint16_t>(motion.x),
-                              static_cast<uint16_t>(motion.y));
+    PointerPosition desktop = to_desktop(motion.x, motion.y);
+    if (auto position = motion_.motion(desktop.x, desktop.y)) {
+        session_.send_mouse_event(PTR_FLAGS_MOVE, position->x, position->y);
+    }
 }
 
 void InputHandler::handle_mouse_button(const SDL_MouseButtonEvent& button) {
@@ -76,11 +99,14 @@ void InputHandler::handle_mouse_button(const SDL_MouseButtonEvent& button) {
         flags |= PTR_FLAGS_DOWN;
     }
 
-    session_.send_mouse_event(flags, static_cast<uint16_t>(button.x),
-                              static_cast<uint16_t>(button.y));
+    PointerPosition position = to_desktop(button.x, button.y);
+    send_held_motion(position);
+    session_.send_mouse_event(flags, position.x, position.y);
 }
 
 void InputHandler::handle_mouse_wheel(const SDL_MouseWheelEvent& wheel) {
+    send_held_motion();
+
     if (wheel.y != 0) {
         uint16_t flags = PTR_FLAGS_WHEEL;
         if (wheel.y < 0) {
@@ -91,7 +117,8 @@ void InputHandler::handle_mouse_wheel(const SDL_MouseWheelEvent& wheel) {
         }
         int x, y;
         SDL_GetMouseState(&x, &y);
-        session_.send_mouse_event(flags, static_cast<uint16_t>(x), static_cast<uint16_t>(y));
+        PointerPosition position = to_desktop(x, y);
+        session_.send_mouse_event(flags, position.x, position.y);
     }
 
     if (wheel.x != 0) {
@@ -104,17 +131,99 @@ void InputHandler::handle_mouse_wheel(const SDL_MouseWheelEvent& wheel) {
         }
         int x, y;
         SDL_GetMouseState(&x, &y);
-        session_.send_mouse_event(flags, static_cast<uint16_t>(x), static_cast<uint16_t>(y));
+        PointerPosition position = to_desktop(x, y);
+        session_.send_mouse_event(flags, position.x, position.y);
     }
 }
 
 void InputHandler::handle_window_event(const SDL_WindowEvent& window) {
-    if (window.event == SDL_WINDOWEVENT_RESIZED || window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
-        pending_width_ = static_cast<uint32_t>(window.data1);
-        pending_height_ = static_cast<uint32_t>(window.data2);
-        has_pending_resize_ = true;
-        LOG_DEBUG("Window resize: {}x{}", pending_width_, pending_height_);
+    switch (window.event) {
+        case SDL_WINDOWEVENT_SIZE_CHANGED:
+            // Sent to the server by the main loop's ResizeController
+            LOG_DEBUG("Window resize: {}x{}", window.data1, window.data2);
+            break;
+        case SDL_WINDOWEVENT_MINIMIZED:
+            minimized_ = true;
+            break;
+        case SDL_WINDOWEVENT_RESTORED:
+        case SDL_WINDOWEVENT_MAXIMIZED:
+            minimized_ = false;
+            break;
+        case SDL_WINDOWEVENT_HIDDEN:
+            hidden_ = true;
+            break;
+        case SDL_WINDOWEVENT_SHOWN:
+        case SDL_WINDOWEVENT_EXPOSED:
+            // Being drawn implies being shown (some WMs skip SHOWN on restore)
+            hidden_ = false;
+            break;
+        case SDL_WINDOWEVENT_MOVED:
+            break;
+        case SDL_WINDOWEVENT_FOCUS_GAINED:
+            focused_ = true;
+            return;
+        case SDL_WINDOWEVENT_FOCUS_LOST:
+            focused_ = false;
+            return;
+        default:
+            return;
+    }
+    window_id_ = window.windowID;
+    update_visibility(window.windowID);
+}
+
+void InputHandler::set_viewport(const Viewport& viewport) {
+    if (viewport == viewport_) return;
+    viewport_ = viewport;
+    // Until a window event the server has not been told anything
+    if (window_id_ != 0) update_visibility(window_id_);
+}
+
+void InputHandler::update_visibility(uint32_t window_id) {
+    SDL_Window* window = SDL_GetWindowFromID(window_id);
+    if (!window) return;
+
+    std::optional<Rect> visible = Rect{};
+    if (window_visible()) {
+        SDL_Rect client{};
+        SDL_GetWindowPosition(window, &client.x, &client.y);
+        SDL_GetWindowSize(window, &client.w, &client.h);
+
+        // Bounding box of the client area's parts on each display. SDL2 has
+        // no occlusion events, so covered-but-on-screen still counts.
+        SDL_Rect on_screen{};
+        int displays = SDL_GetNumVideoDisplays();
+        for (int i = 0; i < displays; i++) {
+            SDL_Rect bounds{};
+            SDL_Rect part{};
+            if (SDL_GetDisplayBounds(i, &bounds) != 0) continue;
+            if (!SDL_IntersectRect(&client, &bounds, &part)) continue;
+            if (SDL_RectEmpty(&on_screen)) {
+                on_screen = part;
+            } else {
+                SDL_UnionRect(&on_screen, &part, &on_screen);
+            }
+        }
+        // Without display information, assume the whole window is visible
+        if (displays <= 0) on_screen = client;
+
+        if (!SDL_RectEmpty(&client) && SDL_RectEquals(&on_screen, &client)) {
+            // Not clipped to the old size while a larger desktop is on its way
+            visible = std::nullopt;
+        } else if (!SDL_RectEmpty(&on_screen)) {
+            // Mapped like the pointer, see to_desktop()
+            int x = on_screen.x - client.x;
+            int y = on_screen.y - client.y;
+            if (viewport_.empty()) {
+                visible = Rect{static_cast<uint32_t>(x), static_cast<uint32_t>(y),
+                               static_cast<uint32_t>(on_screen.w),
+                               static_cast<uint32_t>(on_screen.h)};
+            } else {
+                visible = viewport_.to_desktop(x, y, on_screen.w, on_screen.h);
+            }
+        }
     }
+    session_.set_visible_area(visible);
 }
 
 }  // namespace gvrdp
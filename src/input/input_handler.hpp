@@ -1,8 +1,12 @@
 #pragma once
 
+#include "input/input_coalescer.hpp"
+#include "render/viewport.hpp"
+
 #include <SDL2/SDL.h>
 
 #include <cstdint>
+#include <optional>
 
 namespace gvrdp {
 
@@ -11,16 +15,29 @@ class RdpSession;
 // Translates SDL input events into RDP input calls.
 class InputHandler {
 public:
-    explicit InputHandler(RdpSession& session);
+    explicit InputHandler(RdpSession& session, InputCoalescer motion = InputCoalescer());
 
     // Process an SDL event. Returns true if the event was consumed.
     bool handle_event(const SDL_Event& event);
 
-    // Get the last known window size from resize events
-    uint32_t pending_width() const { return pending_width_; }
-    uint32_t pending_height() const { return pending_height_; }
-    bool has_pending_resize() const { return has_pending_resize_; }
-    void clear_pending_resize() { has_pending_resize_ = false; }
+    // Call after each pass over the SDL event queue: sends the pointer
+    // motion held back by the coalescer once it is due
+    void flush_motion(InputCoalescer::Clock::time_point now);
+    std::optional<InputCoalescer::Duration> time_until_motion_due(
+        InputCoalescer::Clock::time_point now) const {
+        return motion_.time_until_deadline(now);
+    }
+
+    // Where the desktop was last drawn; pointer positions are mapped back
+    // through it. Until the first frame, window pixels are desktop pixels.
+    // A new viewport (desktop resize, smart sizing, drag preview) also
+    // re-reports the visible area.
+    void set_viewport(const Viewport& viewport);
+
+    // Window state from window events. While the window cannot be seen the
+    // session suppresses server output; see update_visibility().
+    bool window_visible() const { return !minimized_ && !hidden_; }
+    bool window_focused() const { return focused_; }
 
 private:
     void handle_key_event(const SDL_KeyboardEvent& key);
@@ -28,11 +45,22 @@ private:
     void handle_mouse_button(const SDL_MouseButtonEvent& button);
     void handle_mouse_wheel(const SDL_MouseWheelEvent& wheel);
     void handle_window_event(const SDL_WindowEvent& window);
+    // Sends held motion ahead of another event, unless that event moves
+    // the pointer to the same place (`next`) anyway
+    void send_held_motion(std::optional<PointerPosition> next = std::nullopt);
+    // Tells the session which part of the desktop is on screen: none while
+    // minimized or hidden, all of it when the whole client area is on the
+    // displays, otherwise the part that is
+    void update_visibility(uint32_t window_id);
+    PointerPosition to_desktop(int x, int y) const;
 
     RdpSession& session_;
-    uint32_t pending_width_ = 0;
-    uint32_t pending_height_ = 0;
-    bool has_pending_resize_ = false;
+    InputCoalescer motion_;
+    Viewport viewport_;
+    uint32_t window_id_ = 0;  // From the last window event; 0 = none yet
+    bool minimized_ = false;
+    bool hidden_ = false;
+    bool focused_ = true;
 };
 
 }  // namespace gvrdp
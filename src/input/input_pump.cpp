@@ -0,0 +1,58 @@
+#include "input/input_pump.hpp"
+
+#include "input/input_handler.hpp"
+
+#include <array>
+#include <utility>
+
+namespace gvrdp {
+
+namespace {
+
+bool is_ordered_input(Uint32 type) {
+    return type == SDL_KEYDOWN || type == SDL_KEYUP || type == SDL_MOUSEBUTTONDOWN ||
+           type == SDL_MOUSEBUTTONUP || type == SDL_MOUSEWHEEL;
+}
+
+}  // namespace
+
+InputPump::InputPump(Route route) : route_(std::move(route)) {
+    SDL_SetEventFilter(&InputPump::filter, this);
+}
+
+InputPump::~InputPump() {
+    SDL_SetEventFilter(nullptr, nullptr);
+}
+
+int SDLCALL InputPump::filter(void* userdata, SDL_Event* event) {
+    // Also called on the RDP thread for its SDL_PushEvent()s; input events
+    // only ever come from SDL_PumpEvents() on the main thread
+    if (!is_ordered_input(event->type)) return 1;
+    return static_cast<InputPump*>(userdata)->forward(*event) ? 0 : 1;
+}
+
+bool InputPump::forward(const SDL_Event& event) {
+    InputHandler* handler = route_(event);
+    if (!handler) return false;
+
+    // Input that must stay ahead of this event is still queued
+    if (SDL_PeepEvents(nullptr, 0, SDL_PEEKEVENT, SDL_KEYDOWN, SDL_KEYUP) > 0 ||
+        SDL_PeepEvents(nullptr, 0, SDL_PEEKEVENT, SDL_MOUSEBUTTONDOWN, SDL_MOUSEWHEEL) > 0) {
+        return false;
+    }
+
+    // Motion queued before this event goes first
+    std::array<SDL_Event, 64> motion;
+    int count;
+    while ((count = SDL_PeepEvents(motion.data(), static_cast<int>(motion.size()), SDL_GETEVENT,
+                                   SDL_MOUSEMOTION, SDL_MOUSEMOTION)) > 0) {
+        for (int i = 0; i < count; i++) {
+            handler->handle_event(motion[i]);
+        }
+    }
+
+    handler->handle_event(event);
+    return true;
+}
+
+}  // namespace gvrdp
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <functional>
+
+namespace gvrdp {
+
+class InputHandler;
+
+// Low-latency input path. Installs an SDL event filter that forwards
+// clicks, wheel and key events to the InputHandler the moment
+// SDL_PumpEvents() reads them from the OS, rather than after the main loop
+// has finished rendering and presenting. The filter drops the events it
+// forwards, so the main loop never sees them twice.
+//
+// Pointer motion stays in the queue and is coalesced by the main loop as
+// usual. Before an event is forwarded, the motion still queued ahead of it
+// is handed over first, so the server sees events in their original order.
+// If other input is already queued (it arrived while the UI had input), the
+// event is left in the queue behind it.
+class InputPump {
+public:
+    // The handler an event may go straight to, or nullptr to leave it in
+    // the queue (not connected, ImGui UI shown, a client hotkey)
+    using Route = std::function<InputHandler*(const SDL_Event&)>;
+
+    explicit InputPump(Route route);
+    ~InputPump();
+
+    InputPump(const InputPump&) = delete;
+    InputPump& operator=(const InputPump&) = delete;
+
+    // Reads pending OS input now, e.g. right before a present that may block
+    void pump() { SDL_PumpEvents(); }
+
+private:
+    static int SDLCALL filter(void* userdata, SDL_Event* event);
+    bool forward(const SDL_Event& event);
+
+    Route route_;
+};
+
+}  // namespace gvrdp
@@ -1,31 +1,140 @@
 #include "config/app_config.hpp"
 #include "config/connection_profile.hpp"
 #include "config/profile_store.hpp"
+#include "core/frame_stats.hpp"
 #include "core/rdp_session.hpp"
+#include "core/resize_controller.hpp"
 #include "input/input_handler.hpp"
+#include "input/input_pump.hpp"
+#include "render/sdl_cursor.hpp"
 #include "render/sdl_renderer.hpp"
 #include "ui/ui_manager.hpp"
-#include "util/debouncer.hpp"
+#include "util/flight_recorder.hpp"
 #include "util/logger.hpp"
+#include "util/metrics.hpp"
 #include "util/platform.hpp"
+#include "util/tracer.hpp"
 
 #include <SDL2/SDL.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
 #include <memory>
+#include <string>
 
 using namespace gvrdp;
 
-int main(int /*argc*/, char* /*argv*/[]) {
+// Wake-up interval while an ImGui dialog is visible (caret blink, hover state)
+static constexpr int kUiIdleTimeoutMs = 250;
+
+// Length of a trace started from the overlay, or by --trace without a value
+static constexpr int kDefaultTraceSeconds = 10;
+
+// Local time as YYYYmmdd-HHMMSS, for file names
+static std::string file_timestamp() {
+    std::time_t now = std::time(nullptr);
+    std::tm local{};
+#if GVRDP_WINDOWS
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &local);
+    return stamp;
+}
+
+// <config>/traces/gvrdp-<local time>.json
+static std::filesystem::path default_trace_path(const std::filesystem::path& config_dir) {
+    return config_dir / "traces" / ("gvrdp-" + file_timestamp() + ".json");
+}
+
+// Keeps the flight recorder's last events next to the live ring
+static void dump_flight_recorder(const std::filesystem::path& config_dir, DumpReason reason) {
+    auto path = config_dir / "flight" /
+                (file_timestamp() + (reason == DumpReason::Error ? "-error" : "-disconnect") +
+                 ".gfr");
+    if (FlightRecorder::dump(path, reason)) {
+        LOG_INFO("Flight recorder saved to {}", path.string());
+    }
+}
+
+// ConnectionProfile::scaling_filter as an SDL texture filter. "best" is
+// anisotropic where the backend has it (Direct3D) and linear elsewhere.
+static SDL_ScaleMode scaling_filter(const std::string& name) {
+    if (name == "nearest") return SDL_ScaleModeNearest;
+    if (name == "best") return SDL_ScaleModeBest;
+    if (name != "linear") LOG_WARN("Unknown scaling_filter '{}', using linear", name);
+    return SDL_ScaleModeLinear;
+}
+
+static void start_trace(const std::filesystem::path& path, int seconds) {
+    if (Tracer::start(path, std::chrono::seconds(seconds))) {
+        LOG_INFO("Tracing for {}s to {}", seconds, path.string());
+    }
+}
+
+static void stop_trace() {
+    if (Tracer::stop()) {
+        LOG_INFO("Trace written");
+    } else {
+        LOG_ERROR("Failed to write the trace");
+    }
+}
+
+int main(int argc, char* argv[]) {
     // Initialize logging
     Logger::init("debug");
     LOG_INFO("GVRDP starting");
+    Tracer::set_thread_name("main");
 
     // Load app config
     auto config_dir = get_config_dir();
     AppConfig app_config = AppConfig::load(config_dir);
     ProfileStore profile_store(config_dir);
 
+    // --trace[=seconds] records a timeline from startup, see Tracer;
+    // --trace-file=<path> overrides where it is written
+    int trace_seconds = 0;
+    std::filesystem::path trace_path;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--trace") {
+            trace_seconds = kDefaultTraceSeconds;
+        } else if (arg.rfind("--trace=", 0) == 0) {
+            trace_seconds = std::max(std::atoi(arg.c_str() + 8), 1);
+        } else if (arg.rfind("--trace-file=", 0) == 0) {
+            trace_path = arg.substr(13);
+        } else {
+            LOG_WARN("Ignoring unknown argument '{}'", arg);
+        }
+    }
+    if (trace_seconds > 0) {
+        start_trace(trace_path.empty() ? default_trace_path(config_dir) : trace_path,
+                    trace_seconds);
+    }
+
+    // Always-on flight recorder. A ring the last run never closed means it
+    // crashed: keep it for gvrdp_flight before starting a new one.
+    if (app_config.flight_recorder_events > 0) {
+        auto ring = config_dir / "flight" / "recorder.gfr";
+        if (FlightRecorder::left_open(ring)) {
+            auto kept = config_dir / "flight" / (file_timestamp() + "-crash.gfr");
+            std::error_code ec;
+            std::filesystem::rename(ring, kept, ec);
+            if (!ec) {
+                LOG_WARN("Previous run did not exit cleanly, flight recorder kept in {}",
+                         kept.string());
+            }
+        }
+        if (!FlightRecorder::open(ring, static_cast<size_t>(app_config.flight_recorder_events))) {
+            LOG_WARN("Could not open the flight recorder at {}", ring.string());
+        }
+    }
+
     // Initialize SDL
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_EVENTS) != 0) {
         LOG_CRITICAL("SDL_Init failed: {}", SDL_GetError());
@@ -34,13 +143,21 @@ int main(int /*argc*/, char* /*argv*/[]) {
 
     // Create renderer
     SdlRenderer renderer;
+    bool immediate_present = app_config.present_mode == "immediate";
+    bool low_latency_input = immediate_present || app_config.present_mode == "low_latency";
+    if (!immediate_present && !low_latency_input && app_config.present_mode != "vsync") {
+        LOG_WARN("Unknown present_mode '{}', using vsync", app_config.present_mode);
+    }
     if (!renderer.init("GVRDP - Remote Desktop", app_config.window_x, app_config.window_y,
-                       app_config.window_w, app_config.window_h)) {
+                       app_config.window_w, app_config.window_h, !immediate_present)) {
         LOG_CRITICAL("Failed to initialize renderer");
         SDL_Quit();
         return 1;
     }
 
+    // The server's pointer, once a session sends one
+    SdlCursor cursor;
+
     // Initialize UI
     UiManager ui;
     if (!ui.init(renderer)) {
@@ -52,7 +169,26 @@ int main(int /*argc*/, char* /*argv*/[]) {
     // RDP session and input handler (created on connect)
     std::unique_ptr<RdpSession> session;
     std::unique_ptr<InputHandler> input_handler;
-    std::unique_ptr<Debouncer> resize_debouncer;
+    std::unique_ptr<ResizeController> resize;
+    FrameStats frame_stats;  // Per-stage frame timing, shown by the HUD
+
+    // Session counters for fleet monitoring, see Metrics
+    Metrics& metrics = Metrics::global();
+    Counter& connects = metrics.counter("gvrdp_connects_total", "Connection attempts");
+    Counter& reconnects = metrics.counter(
+        "gvrdp_reconnects_total", "Connection attempts after a session was lost");
+    auto disconnects = [&metrics](const char* reason) -> Counter& {
+        return metrics.counter("gvrdp_disconnects_total", "Sessions ended", {{"reason", reason}});
+    };
+    Counter& dropped_frames =
+        metrics.counter("gvrdp_frames_dropped_total", "Frames replaced before being shown");
+    uint64_t dropped_reported = 0;  // frame_stats.dropped() already counted
+    bool session_lost = false;
+    std::unique_ptr<MetricsWriter> metrics_writer;
+    if (app_config.metrics_interval_s > 0) {
+        metrics_writer = std::make_unique<MetricsWriter>(
+            metrics, config_dir, std::chrono::seconds(app_config.metrics_interval_s));
+    }
 
     // Load profiles
     auto profiles = profile_store.load_all();
@@ -60,49 +196,166 @@ int main(int /*argc*/, char* /*argv*/[]) {
     // Set up UI callbacks
     ui.set_connect_callback([&](const ConnectionProfile& profile) {
         LOG_INFO("Connecting to {}:{}", profile.hostname, profile.port);
+        FlightRecorder::record(FlightEvent::SessionStart, profile.port);
+        connects.add();
+        if (session_lost) reconnects.add();
+        session_lost = false;
         ui.set_connecting();
 
         session = std::make_unique<RdpSession>();
-        input_handler = std::make_unique<InputHandler>(*session);
-
-        // Create debouncer for resize events (200ms quiet period)
-        resize_debouncer = std::make_unique<Debouncer>(
-            std::chrono::milliseconds(200), [&]() {
-                if (session && session->is_connected() && input_handler) {
-                    uint32_t w = input_handler->pending_width();
-                    uint32_t h = input_handler->pending_height();
-                    if (w > 0 && h > 0) {
-                        LOG_INFO("Debounced resize: {}x{}", w, h);
-                        session->request_resolution_change(w, h);
-                        input_handler->clear_pending_resize();
-                    }
-                }
+        session->set_decode_threads(static_cast<size_t>(std::max(app_config.decode_threads, 0)));
+        session->set_gfx_surface_limit(renderer.gfx().max_texture_size());
+        session->set_persistent_cache(
+            config_dir / "cache",
+            static_cast<uint64_t>(std::max(app_config.persistent_cache_mb, 0)) << 20);
+        session->set_update_profiling(app_config.profile_updates);
+        ui.set_codec_stats(&session->codec_stats());
+        frame_stats.reset();
+        dropped_reported = 0;
+        ui.set_frame_stats(&frame_stats);
+        auto motion_interval = app_config.mouse_motion_hz > 0
+                                   ? std::chrono::microseconds(1000000 / app_config.mouse_motion_hz)
+                                   : std::chrono::microseconds::zero();
+        input_handler = std::make_unique<InputHandler>(
+            *session, InputCoalescer(app_config.mouse_coalescing, motion_interval));
+
+        // Window sizes become display layouts, one in flight at a time.
+        // Smart sizing keeps the remote size and scales it instead.
+        renderer.set_smart_sizing(profile.smart_sizing, scaling_filter(profile.scaling_filter));
+        if (profile.dynamic_resolution && !profile.smart_sizing) {
+            resize = std::make_unique<ResizeController>([&](uint32_t w, uint32_t h) {
+                if (!session || !session->is_connected()) return false;
+                LOG_INFO("Requesting resize: {}x{} (debounce {} ms)", w, h,
+                         resize->debounce().count());
+                FlightRecorder::record(FlightEvent::ResizeRequest, w, h);
+                return session->request_resolution_change(w, h);
             });
+            resize->set_desktop_size(profile.width, profile.height);
+        }
 
-        if (!session->connect(profile, renderer.window_id())) {
+        // GFX surfaces are render-target textures; without them, let FreeRDP compose
+        ConnectionProfile effective = profile;
+        if (effective.enable_gfx_pipeline && !renderer.gfx().supported()) {
+            LOG_WARN("Renderer has no render targets, disabling the graphics pipeline");
+            effective.enable_gfx_pipeline = false;
+        }
+        renderer.gfx().reset();
+
+        if (!session->connect(effective, renderer.window_id(), renderer.pixel_format())) {
             ui.show_error("Failed to connect: " + rdp_error_to_string(session->last_error()));
+            ui.set_codec_stats(nullptr);
+            ui.set_frame_stats(nullptr);
             session.reset();
             input_handler.reset();
-            resize_debouncer.reset();
+            resize.reset();
         }
     });
 
     ui.set_disconnect_callback([&]() {
         LOG_INFO("Disconnecting");
         if (session) {
+            disconnects("local").add();
             session->disconnect();
+            ui.set_codec_stats(nullptr);
+            ui.set_frame_stats(nullptr);
             session.reset();
             input_handler.reset();
-            resize_debouncer.reset();
+            resize.reset();
+            cursor.reset();
         }
         ui.set_disconnected();
     });
 
-    // Main event loop
+    ui.set_trace_callback([&]() {
+        start_trace(default_trace_path(config_dir), kDefaultTraceSeconds);
+    });
+
+    // Low-latency modes: desktop clicks and keys skip the queue, see InputPump
+    std::unique_ptr<InputPump> input_pump;
+    if (low_latency_input) {
+        input_pump = std::make_unique<InputPump>([&](const SDL_Event& event) -> InputHandler* {
+            bool desktop_owns = session && session->is_connected() && input_handler &&
+                                !ui.captures_input() && !UiManager::is_overlay_toggle(event);
+            return desktop_owns ? input_handler.get() : nullptr;
+        });
+    }
+
+    // Main event loop. The loop blocks in SDL_WaitEventTimeout until there is
+    // something to do: input, a frame from the RDP thread, UI interaction or a
+    // pending resize layout. Rendering only happens when something changed.
     bool running = true;
+    bool frame_pending = true;   // New desktop damage to upload
+    int ui_frames_pending = 2;   // ImGui needs a couple of frames to settle layout
+    UiState last_ui_state = ui.state();
+    auto last_present = std::chrono::steady_clock::time_point{};
+
+    // Shortest time between presents: the profile's cap, and a lower one
+    // for unfocused windows
+    auto present_interval = [&]() {
+        int fps = session ? static_cast<int>(session->profile().max_fps) : 0;
+        if (input_handler && !input_handler->window_focused() && app_config.unfocused_fps > 0) {
+            fps = fps > 0 ? std::min(fps, app_config.unfocused_fps) : app_config.unfocused_fps;
+        }
+        return std::chrono::milliseconds(fps > 0 ? 1000 / fps : 0);
+    };
+
     while (running) {
+        // State transitions (often triggered from inside ImGui callbacks) need a redraw
+        if (ui.state() != last_ui_state) {
+            last_ui_state = ui.state();
+            ui_frames_pending = 2;
+            frame_pending = true;
+        }
+        bool ui_active = ui.needs_render();
+
+        // Work out how long we may sleep
+        auto next_present = last_present + present_interval();
+        auto now = std::chrono::steady_clock::now();
+        bool frame_due = frame_pending && now >= next_present;
+        int timeout_ms = -1;
+        auto wake_in = [&timeout_ms](int ms) {
+            timeout_ms = timeout_ms < 0 ? ms : std::min(timeout_ms, ms);
+        };
+        if (frame_due || (ui_active && ui_frames_pending > 0)) {
+            timeout_ms = 0;
+        } else {
+            if (frame_pending) {
+                wake_in(static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(
+                                             next_present - now)
+                                             .count()));
+            }
+            if (ui_active) {
+                wake_in(kUiIdleTimeoutMs);
+            }
+            if (resize) {
+                if (auto remaining = resize->time_until_deadline(now)) {
+                    wake_in(static_cast<int>(remaining->count()));
+                }
+            }
+            if (input_handler) {
+                if (auto remaining = input_handler->time_until_motion_due(now)) {
+                    wake_in(static_cast<int>(
+                        std::chrono::ceil<std::chrono::milliseconds>(*remaining).count()));
+                }
+            }
+            if (auto remaining = Tracer::time_until_deadline()) {
+                wake_in(static_cast<int>(remaining->count()));
+            }
+            if (metrics_writer) {
+                wake_in(static_cast<int>(metrics_writer->time_until_due(now).count()));
+            }
+        }
+
         SDL_Event event;
-        while (SDL_PollEvent(&event)) {
+        bool have_event;
+        {
+            TRACE_SCOPE("wait");
+            have_event = timeout_ms < 0 ? SDL_WaitEvent(&event) == 1
+                                        : SDL_WaitEventTimeout(&event, timeout_ms) == 1;
+        }
+        bool woke_idle = !have_event && ui_active;
+
+        for (; have_event; have_event = SDL_PollEvent(&event) == 1) {
             // Quit
             if (event.type == SDL_QUIT) {
                 running = false;
@@ -111,6 +364,8 @@ int main(int /*argc*/, char* /*argv*/[]) {
 
             // Check overlay toggle (Ctrl+Shift+S)
             if (ui.check_overlay_toggle(event)) {
+                ui_frames_pending = 2;
+                frame_pending = true;
                 continue;
             }
 
@@ -122,85 +377,248 @@ int main(int /*argc*/, char* /*argv*/[]) {
                 auto event_type = static_cast<GvrdpEvent>(event.user.code);
                 switch (event_type) {
                     case GVRDP_EVENT_FRAME_READY:
-                        // Frame data ready — will be copied below
-                        if (session && session->is_connected() &&
-                            ui.state() == UiState::Connecting) {
-                            ui.set_connected();
+                        // Frame events are coalesced by the session; re-arm it
+                        // before draining the damage below so nothing is lost.
+                        frame_pending = true;
+                        if (session) {
+                            session->acknowledge_frame_event();
+                            if (session->is_connected() && ui.state() == UiState::Connecting) {
+                                ui.set_connected();
+                                auto [width, height] = session->desktop_size();
+                                if (resize) resize->set_desktop_size(width, height);
+                            }
                         }
                         break;
 
                     case GVRDP_EVENT_DISCONNECT:
                         LOG_INFO("RDP session disconnected");
+                        // A local disconnect has already dropped the session
+                        if (session) {
+                            dump_flight_recorder(config_dir, DumpReason::Disconnect);
+                            disconnects("remote").add();
+                            session_lost = true;
+                        }
+                        ui.set_codec_stats(nullptr);
+                        ui.set_frame_stats(nullptr);
                         session.reset();
                         input_handler.reset();
-                        resize_debouncer.reset();
+                        resize.reset();
+                        cursor.reset();
                         ui.set_disconnected();
                         break;
 
                     case GVRDP_EVENT_RESIZE:
-                        // Server-side resize — recreate texture
-                        if (session) {
-                            renderer.resize_texture(session->gdi_width(), session->gdi_height());
+                        // Server-side resize — the texture is resized by
+                        // update_frame_region() once it sees the new GDI size,
+                        // together with the full-desktop damage queued by the
+                        // session. Resizing it here could discard that upload.
+                        if (session && resize) {
+                            auto [width, height] = session->desktop_size();
+                            resize->on_desktop_resize(width, height);
+                            if (auto rtt = resize->round_trip()) {
+                                LOG_DEBUG("Resize round trip {} ms", rtt->count());
+                            }
                         }
                         break;
 
                     case GVRDP_EVENT_ERROR:
+                        dump_flight_recorder(config_dir, DumpReason::Error);
                         if (session) {
+                            disconnects("error").add();
+                            session_lost = true;
                             ui.show_error(
                                 "Connection error: " +
                                 rdp_error_to_string(session->last_error()));
+                            ui.set_codec_stats(nullptr);
+                            ui.set_frame_stats(nullptr);
                             session.reset();
                             input_handler.reset();
-                            resize_debouncer.reset();
+                            resize.reset();
+                            cursor.reset();
                         }
                         break;
+
+                    case GVRDP_EVENT_INPUT_DRAINED:
+                        // Input held back while the ring was full
+                        if (session) session->flush_input();
+                        break;
+
+                    case GVRDP_EVENT_POINTER:
+                        // Re-arm before draining, as for frames
+                        if (session) {
+                            session->acknowledge_pointer_event();
+                            while (auto command = session->pop_pointer_command()) {
+                                cursor.apply(*command);
+                            }
+                        }
+                        break;
+                }
+                ui_frames_pending = 2;
+                continue;
+            }
+
+            // The GPU dropped render-target contents (e.g. D3D device loss):
+            // rebuild every texture from the CPU-side copies
+            if (event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET) {
+                LOG_WARN("Render targets lost, re-uploading the desktop");
+                renderer.reset_textures();
+                if (session && session->is_connected()) {
+                    if (session->gfx_active()) {
+                        session->resync_gfx();
+                    } else if (const DesktopFrame* frame = session->current_frame()) {
+                        renderer.update_frame_region(frame->pixels.data(), frame->width,
+                                                     frame->height, frame->stride, frame->damage);
+                    }
                 }
+                frame_pending = true;
                 continue;
             }
 
+            // Window exposure or size changes invalidate what is on screen
+            if (event.type == SDL_WINDOWEVENT) {
+                switch (event.window.event) {
+                    case SDL_WINDOWEVENT_EXPOSED:
+                    case SDL_WINDOWEVENT_SIZE_CHANGED:
+                    case SDL_WINDOWEVENT_RESTORED:
+                    case SDL_WINDOWEVENT_MAXIMIZED:
+                    case SDL_WINDOWEVENT_SHOWN:
+                        frame_pending = true;
+                        break;
+                    default:
+                        break;
+                }
+            }
+            if (ui_active) {
+                ui_frames_pending = 2;
+            }
+
             // Forward input events to RDP if not consumed by ImGui
             if (!imgui_consumed && input_handler && session && session->is_connected()) {
                 input_handler->handle_event(event);
+                if (event.type == SDL_WINDOWEVENT &&
+                    event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED && resize) {
+                    resize->request(static_cast<uint32_t>(event.window.data1),
+                                    static_cast<uint32_t>(event.window.data2));
+                }
             }
         }
 
-        // Poll resize debouncer
-        if (resize_debouncer) {
-            if (input_handler && input_handler->has_pending_resize()) {
-                resize_debouncer->trigger();
+        // Pointer motion collapsed during this pass
+        if (input_handler) {
+            input_handler->flush_motion(std::chrono::steady_clock::now());
+        }
+
+        // Send the newest window size once it is due
+        if (resize) {
+            resize->poll();
+        }
+
+        // Write the trace once its time is up
+        if (Tracer::due()) {
+            stop_trace();
+        }
+        if (metrics_writer && !metrics_writer->poll(std::chrono::steady_clock::now())) {
+            LOG_WARN("Could not write metrics to {}", config_dir.string());
+        }
+
+        // Minimized or hidden: output is suppressed, and whatever still
+        // arrives is only shown after restore. GFX batches cannot be
+        // skipped, so keep applying them.
+        if (running && input_handler && !input_handler->window_visible()) {
+            if (session && session->gfx_active()) {
+                while (auto batch = session->pop_gfx_batch()) {
+                    renderer.gfx().apply(*batch);
+                }
             }
-            resize_debouncer->poll();
+            frame_pending = false;
+            continue;
+        }
+
+        // Nothing visible changed, or the frame rate cap says wait
+        ui_active = ui.needs_render();
+        bool render_ui = ui_active && (ui_frames_pending > 0 || woke_idle);
+        frame_due = frame_pending &&
+                    std::chrono::steady_clock::now() >= last_present + present_interval();
+        if (!running || (!frame_due && !render_ui)) {
+            continue;
         }
 
         // Render frame
         renderer.clear();
 
-        // Copy RDP desktop frame to texture
         if (session && session->is_connected()) {
-            const uint8_t* buffer = session->gdi_buffer();
-            uint32_t w = session->gdi_width();
-            uint32_t h = session->gdi_height();
-            uint32_t stride = session->gdi_stride();
-            if (buffer && w > 0 && h > 0) {
-                renderer.update_frame(buffer, w, h, stride);
+            if (session->gfx_active()) {
+                // Replay every completed RDPGFX frame on the GPU surfaces
+                while (auto batch = session->pop_gfx_batch()) {
+                    renderer.gfx().apply(*batch);
+                    if (batch->frame) {
+                        frame_stats.record_uploaded(batch->frame->started, batch->frame->ended,
+                                                    std::chrono::steady_clock::now());
+                        frame_stats.record_dirty(
+                            changed_pixels(*batch),
+                            static_cast<uint64_t>(renderer.gfx().output_width()) *
+                                renderer.gfx().output_height());
+                    }
+                }
+                renderer.render_gfx();
+            } else {
+                // Upload the regions that changed in the newest complete frame
+                if (const DesktopFrame* frame = session->acquire_frame()) {
+                    renderer.update_frame_region(frame->pixels.data(), frame->width,
+                                                 frame->height, frame->stride, frame->damage);
+                    frame_stats.record_sequence(frame->sequence);
+                    dropped_frames.add(frame_stats.dropped() - dropped_reported);
+                    dropped_reported = frame_stats.dropped();
+                    frame_stats.record_uploaded(frame->received, frame->decoded,
+                                                std::chrono::steady_clock::now());
+                    frame_stats.record_dirty(frame->damage.area(),
+                                             static_cast<uint64_t>(frame->width) * frame->height);
+                }
+                renderer.render_desktop();
             }
-            renderer.render_desktop();
+            // Clicks go where this frame shows the desktop
+            if (input_handler) input_handler->set_viewport(renderer.viewport());
         }
 
-        // Render ImGui UI on top
-        ui.render(renderer);
+        // Render ImGui UI on top (skipped entirely while just showing the desktop)
+        if (ui_active) {
+            ui.render(renderer);
+            if (ui_frames_pending > 0) ui_frames_pending--;
+        }
 
-        // Present
+        // Present. It may wait for vsync, so hand over any input that
+        // arrived while rendering first.
+        if (input_pump) input_pump->pump();
+        auto present_started = std::chrono::steady_clock::now();
         renderer.present();
+        frame_pending = false;
+        auto previous_present = last_present;
+        last_present = std::chrono::steady_clock::now();
+        frame_stats.record_presented(last_present);
+        auto micros = [](std::chrono::steady_clock::duration d) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+        };
+        auto interval = previous_present == std::chrono::steady_clock::time_point{}
+                            ? 0
+                            : micros(last_present - previous_present);
+        FlightRecorder::record(FlightEvent::Present,
+                               static_cast<uint32_t>(micros(last_present - present_started)),
+                               static_cast<uint64_t>(interval));
+
+        // Only now do the server's frames count as displayed. Also after a
+        // fall back to GDI, for batches popped before it.
+        if (session) session->gfx_presented();
     }
 
     // Cleanup
     LOG_INFO("Shutting down");
 
+    input_pump.reset();
     if (session) {
         session->disconnect();
         session.reset();
     }
+    if (Tracer::enabled()) stop_trace();
 
     // Save window position/size
     SDL_GetWindowPosition(renderer.window(), &app_config.window_x, &app_config.window_y);
@@ -209,9 +627,11 @@ int main(int /*argc*/, char* /*argv*/[]) {
     app_config.save(config_dir);
 
     ui.shutdown();
+    cursor.reset();
     renderer.shutdown();
     SDL_Quit();
 
+    FlightRecorder::close();
     LOG_INFO("GVRDP exited cleanly");
     return 0;
 }
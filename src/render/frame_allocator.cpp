@@ -0,0 +1,70 @@
+#include "render/frame_allocator.hpp"
+
+#include "util/platform.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#if GVRDP_WINDOWS
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace gvrdp {
+
+static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+void* frame_alloc(size_t size) {
+    if (size == 0) return nullptr;
+
+#if GVRDP_WINDOWS
+    void* ptr = _aligned_malloc(size, 4096);
+    if (!ptr) return nullptr;
+#else
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t alignment = size >= kHugePageSize ? kHugePageSize : page;
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, size) != 0) return nullptr;
+#if GVRDP_LINUX
+    if (size >= kHugePageSize) {
+        // Best effort: fails harmlessly when THP is disabled
+        madvise(ptr, size & ~(kHugePageSize - 1), MADV_HUGEPAGE);
+    }
+#endif
+#endif
+
+    std::memset(ptr, 0, size);
+    return ptr;
+}
+
+void frame_free(void* ptr) {
+#if GVRDP_WINDOWS
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+FrameBuffer::FrameBuffer(size_t size)
+    : data_(static_cast<uint8_t*>(frame_alloc(size))), size_(data_ ? size : 0) {}
+
+FrameBuffer::~FrameBuffer() {
+    frame_free(data_);
+}
+
+FrameBuffer::FrameBuffer(FrameBuffer&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+FrameBuffer& FrameBuffer::operator=(FrameBuffer&& other) noexcept {
+    if (this != &other) {
+        frame_free(data_);
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+}  // namespace gvrdp
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "util/damage_region.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace gvrdp {
+
+// One RDPGFX surface operation, recorded on the channel thread and replayed
+// against GPU textures on the main thread. Only codec output carries pixels;
+// fills and copies are executed entirely on the GPU.
+struct GfxCommand {
+    enum class Type : uint8_t {
+        ResetGraphics,       // rect = new output size; drops all surfaces and caches
+        CreateSurface,       // surface_id, rect = surface size
+        DeleteSurface,       // surface_id
+        MapSurfaceToOutput,  // surface_id, rect.x/y = output origin
+        SolidFill,           // surface_id, color, rects = fill rects
+        SurfaceToSurface,    // src_surface_id, rect = source, surface_id, rects = destinations
+        SurfaceToCache,      // surface_id, rect = source, cache_slot
+        CacheToSurface,      // cache_slot, surface_id, rects = destinations
+        EvictCache,          // cache_slot
+        ImportCacheEntry,    // cache_slot, rect = entry size, pixels
+        Upload,              // surface_id, rect, pixels = rect.width * 4 bytes per row
+        UploadYuv,           // surface_id, yuv_format, rect = even-aligned plane area,
+                             // pixels = packed planes, rects = areas to convert
+    };
+
+    Type type = Type::Upload;
+    uint16_t surface_id = 0;
+    uint16_t src_surface_id = 0;
+    uint16_t cache_slot = 0;
+    uint32_t color = 0;       // SolidFill, 0xAARRGGBB
+    uint32_t yuv_format = 0;  // UploadYuv, SDL_PIXELFORMAT_IYUV or SDL_PIXELFORMAT_NV12
+    Rect rect;
+    std::vector<Rect> rects;
+    // Upload/ImportCacheEntry: BGRA in memory (SDL ARGB8888). UploadYuv: the
+    // Y plane (rect.width per row), then U and V (I420) or interleaved UV (NV12).
+    std::vector<uint8_t> pixels;
+};
+
+// Timing of an RDPGFX frame, kept until the frame has been presented and
+// acknowledged
+struct GfxFrameInfo {
+    std::chrono::steady_clock::time_point started;  // StartFrame received
+    std::chrono::steady_clock::time_point ended;    // EndFrame received
+    std::chrono::microseconds decode_time{0};       // StartFrame to EndFrame
+    bool acknowledged = false;                      // Acked on arrival (ack window)
+};
+
+// All commands of one RDPGFX frame (StartFrame..EndFrame), or of a run of
+// structural commands sent outside a frame.
+struct GfxBatch {
+    uint32_t frame_id = 0;
+    std::vector<GfxCommand> commands;
+    std::optional<GfxFrameInfo> frame;  // Set when the batch ends a frame
+};
+
+// Pixels a batch writes to surfaces (overlapping writes count twice)
+inline uint64_t changed_pixels(const GfxBatch& batch) {
+    uint64_t pixels = 0;
+    for (const auto& command : batch.commands) {
+        switch (command.type) {
+            case GfxCommand::Type::Upload:
+                pixels += command.rect.area();
+                break;
+            case GfxCommand::Type::UploadYuv:
+            case GfxCommand::Type::SolidFill:
+            case GfxCommand::Type::SurfaceToSurface:
+            case GfxCommand::Type::CacheToSurface:
+                for (const auto& rect : command.rects) pixels += rect.area();
+                break;
+            default:
+                break;
+        }
+    }
+    return pixels;
+}
+
+}  // namespace gvrdp
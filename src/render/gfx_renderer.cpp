@@ -0,0 +1,364 @@
+#include "render/gfx_renderer.hpp"
+
+#include "util/logger.hpp"
+#include "util/tracer.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace gvrdp {
+
+// FreeRDP's GFX surfaces are BGRA/BGRX in memory, i.e. SDL ARGB8888
+static constexpr uint32_t kSurfaceFormat = SDL_PIXELFORMAT_ARGB8888;
+
+static SDL_Rect to_sdl(const Rect& rect) {
+    return {static_cast<int>(rect.x), static_cast<int>(rect.y), static_cast<int>(rect.width),
+            static_cast<int>(rect.height)};
+}
+
+// Clips rect to a width x height texture; returns false if nothing is left
+static bool clip_to(Rect& rect, uint32_t width, uint32_t height) {
+    if (rect.x >= width || rect.y >= height) return false;
+    rect.width = std::min(rect.width, width - rect.x);
+    rect.height = std::min(rect.height, height - rect.y);
+    return !rect.empty();
+}
+
+GfxRenderer::GfxRenderer(SDL_Renderer* renderer) : renderer_(renderer) {
+    // MS-RDPEGFX specifies BT.709 for AVC420 colour conversion. This mode is
+    // limited range; H264Decoder rescales full-range pictures to match.
+    SDL_SetYUVConversionMode(SDL_YUV_CONVERSION_BT709);
+
+    SDL_RendererInfo info{};
+    if (renderer_ && SDL_GetRendererInfo(renderer_, &info) == 0) {
+        int size = std::min(info.max_texture_width, info.max_texture_height);
+        if (size > 0) max_texture_size_ = static_cast<uint32_t>(size);
+    }
+}
+
+GfxRenderer::~GfxRenderer() {
+    reset();
+}
+
+Counter& texture_upload_bytes() {
+    static Counter& bytes =
+        Metrics::global().counter("gvrdp_upload_bytes_total", "Pixel bytes uploaded to textures");
+    return bytes;
+}
+
+bool GfxRenderer::supported() const {
+    return renderer_ && SDL_RenderTargetSupported(renderer_);
+}
+
+SDL_Texture* GfxRenderer::create_texture(uint32_t width, uint32_t height) {
+    SDL_Texture* texture = SDL_CreateTexture(renderer_, kSurfaceFormat, SDL_TEXTUREACCESS_TARGET,
+                                             static_cast<int>(width), static_cast<int>(height));
+    if (!texture) {
+        LOG_ERROR("GFX texture {}x{} failed: {}", width, height, SDL_GetError());
+        return nullptr;
+    }
+    // Copies between surfaces replace pixels, as on the server
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+    return texture;
+}
+
+SDL_Texture* GfxRenderer::scratch_texture(uint32_t width, uint32_t height) {
+    if (!scratch_ || width > scratch_width_ || height > scratch_height_) {
+        if (scratch_) SDL_DestroyTexture(scratch_);
+        scratch_width_ = std::max(width, scratch_width_);
+        scratch_height_ = std::max(height, scratch_height_);
+        scratch_ = create_texture(scratch_width_, scratch_height_);
+        if (!scratch_) {
+            scratch_width_ = 0;
+            scratch_height_ = 0;
+        }
+    }
+    return scratch_;
+}
+
+void GfxRenderer::destroy_surface(uint16_t surface_id) {
+    auto it = surfaces_.find(surface_id);
+    if (it == surfaces_.end()) return;
+    if (it->second.texture) SDL_DestroyTexture(it->second.texture);
+    if (it->second.yuv) SDL_DestroyTexture(it->second.yuv);
+    surfaces_.erase(it);
+}
+
+void GfxRenderer::destroy_cache_entry(uint16_t cache_slot) {
+    auto it = cache_.find(cache_slot);
+    if (it == cache_.end()) return;
+    if (it->second.texture) SDL_DestroyTexture(it->second.texture);
+    cache_.erase(it);
+}
+
+void GfxRenderer::reset() {
+    for (auto& [id, surface] : surfaces_) {
+        if (surface.texture) SDL_DestroyTexture(surface.texture);
+        if (surface.yuv) SDL_DestroyTexture(surface.yuv);
+    }
+    surfaces_.clear();
+    for (auto& [slot, entry] : cache_) {
+        if (entry.texture) SDL_DestroyTexture(entry.texture);
+    }
+    cache_.clear();
+    if (scratch_) {
+        SDL_DestroyTexture(scratch_);
+        scratch_ = nullptr;
+    }
+    scratch_width_ = 0;
+    scratch_height_ = 0;
+}
+
+void GfxRenderer::apply(const GfxBatch& batch) {
+    TRACE_SCOPE("gfx_apply");
+    for (const auto& command : batch.commands) {
+        switch (command.type) {
+            case GfxCommand::Type::ResetGraphics:
+                reset();
+                output_width_ = command.rect.width;
+                output_height_ = command.rect.height;
+                break;
+
+            case GfxCommand::Type::CreateSurface: {
+                destroy_surface(command.surface_id);
+                Surface surface;
+                surface.width = command.rect.width;
+                surface.height = command.rect.height;
+                surface.texture = create_texture(surface.width, surface.height);
+                if (!surface.texture) break;
+                // New surfaces start out black, not with undefined VRAM
+                SDL_SetRenderTarget(renderer_, surface.texture);
+                SDL_SetRenderDrawColor(renderer_, 0, 0, 0, 255);
+                SDL_RenderClear(renderer_);
+                surfaces_[command.surface_id] = surface;
+                break;
+            }
+
+            case GfxCommand::Type::DeleteSurface:
+                destroy_surface(command.surface_id);
+                break;
+
+            case GfxCommand::Type::MapSurfaceToOutput: {
+                auto it = surfaces_.find(command.surface_id);
+                if (it == surfaces_.end()) break;
+                it->second.mapped = true;
+                it->second.output_x = command.rect.x;
+                it->second.output_y = command.rect.y;
+                break;
+            }
+
+            case GfxCommand::Type::SolidFill:
+                solid_fill(command);
+                break;
+            case GfxCommand::Type::SurfaceToSurface:
+                surface_to_surface(command);
+                break;
+            case GfxCommand::Type::SurfaceToCache:
+                surface_to_cache(command);
+                break;
+            case GfxCommand::Type::CacheToSurface:
+                cache_to_surface(command);
+                break;
+            case GfxCommand::Type::EvictCache:
+                destroy_cache_entry(command.cache_slot);
+                break;
+            case GfxCommand::Type::ImportCacheEntry:
+                import_cache_entry(command);
+                break;
+            case GfxCommand::Type::Upload:
+                upload(command);
+                break;
+            case GfxCommand::Type::UploadYuv:
+                upload_yuv(command);
+                break;
+        }
+    }
+    SDL_SetRenderTarget(renderer_, nullptr);
+}
+
+void GfxRenderer::solid_fill(const GfxCommand& command) {
+    auto it = surfaces_.find(command.surface_id);
+    if (it == surfaces_.end() || command.rects.empty()) return;
+
+    SDL_SetRenderTarget(renderer_, it->second.texture);
+    SDL_SetRenderDrawBlendMode(renderer_, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(renderer_, static_cast<Uint8>(command.color >> 16),
+                           static_cast<Uint8>(command.color >> 8),
+                           static_cast<Uint8>(command.color),
+                           static_cast<Uint8>(command.color >> 24));
+
+    std::vector<SDL_Rect> rects;
+    rects.reserve(command.rects.size());
+    for (const auto& rect : command.rects) {
+        rects.push_back(to_sdl(rect));
+    }
+    SDL_RenderFillRects(renderer_, rects.data(), static_cast<int>(rects.size()));
+}
+
+void GfxRenderer::surface_to_surface(const GfxCommand& command) {
+    auto src_it = surfaces_.find(command.src_surface_id);
+    auto dst_it = surfaces_.find(command.surface_id);
+    if (src_it == surfaces_.end() || dst_it == surfaces_.end()) return;
+
+    Rect src_rect = command.rect;
+    if (!clip_to(src_rect, src_it->second.width, src_it->second.height)) return;
+    SDL_Rect src = to_sdl(src_rect);
+
+    // A texture cannot be both source and target, so scrolls within one
+    // surface go through the scratch texture
+    SDL_Texture* source = src_it->second.texture;
+    if (command.src_surface_id == command.surface_id) {
+        SDL_Texture* scratch = scratch_texture(src_rect.width, src_rect.height);
+        if (!scratch) return;
+        SDL_Rect scratch_rect = {0, 0, src.w, src.h};
+        SDL_SetRenderTarget(renderer_, scratch);
+        SDL_RenderCopy(renderer_, source, &src, &scratch_rect);
+        source = scratch;
+        src = scratch_rect;
+    }
+
+    SDL_SetRenderTarget(renderer_, dst_it->second.texture);
+    for (const auto& dest : command.rects) {
+        SDL_Rect dst = {static_cast<int>(dest.x), static_cast<int>(dest.y), src.w, src.h};
+        SDL_RenderCopy(renderer_, source, &src, &dst);
+    }
+}
+
+void GfxRenderer::surface_to_cache(const GfxCommand& command) {
+    auto it = surfaces_.find(command.surface_id);
+    if (it == surfaces_.end()) return;
+
+    Rect src_rect = command.rect;
+    if (!clip_to(src_rect, it->second.width, it->second.height)) return;
+
+    destroy_cache_entry(command.cache_slot);
+    CacheEntry entry;
+    entry.width = src_rect.width;
+    entry.height = src_rect.height;
+    entry.texture = create_texture(entry.width, entry.height);
+    if (!entry.texture) return;
+
+    SDL_Rect src = to_sdl(src_rect);
+    SDL_SetRenderTarget(renderer_, entry.texture);
+    SDL_RenderCopy(renderer_, it->second.texture, &src, nullptr);
+    cache_[command.cache_slot] = entry;
+}
+
+void GfxRenderer::cache_to_surface(const GfxCommand& command) {
+    auto cache_it = cache_.find(command.cache_slot);
+    auto dst_it = surfaces_.find(command.surface_id);
+    if (cache_it == cache_.end() || dst_it == surfaces_.end()) return;
+
+    const CacheEntry& entry = cache_it->second;
+    SDL_SetRenderTarget(renderer_, dst_it->second.texture);
+    for (const auto& dest : command.rects) {
+        SDL_Rect dst = {static_cast<int>(dest.x), static_cast<int>(dest.y),
+                        static_cast<int>(entry.width), static_cast<int>(entry.height)};
+        SDL_RenderCopy(renderer_, entry.texture, nullptr, &dst);
+    }
+}
+
+void GfxRenderer::import_cache_entry(const GfxCommand& command) {
+    if (command.rect.empty() ||
+        command.pixels.size() < static_cast<size_t>(command.rect.width) * 4 * command.rect.height)
+        return;
+
+    destroy_cache_entry(command.cache_slot);
+    CacheEntry entry;
+    entry.width = command.rect.width;
+    entry.height = command.rect.height;
+    entry.texture = create_texture(entry.width, entry.height);
+    if (!entry.texture) return;
+
+    SDL_UpdateTexture(entry.texture, nullptr, command.pixels.data(),
+                      static_cast<int>(entry.width * 4));
+    texture_upload_bytes().add(static_cast<uint64_t>(entry.width) * entry.height * 4);
+    cache_[command.cache_slot] = entry;
+}
+
+void GfxRenderer::upload(const GfxCommand& command) {
+    auto it = surfaces_.find(command.surface_id);
+    if (it == surfaces_.end() || command.rect.empty()) return;
+    if (command.pixels.size() <
+        static_cast<size_t>(command.rect.width) * 4 * command.rect.height)
+        return;
+
+    Rect rect = command.rect;
+    if (!clip_to(rect, it->second.width, it->second.height)) return;
+
+    // Pixels are packed at the unclipped width
+    SDL_Rect dst = to_sdl(rect);
+    SDL_UpdateTexture(it->second.texture, &dst, command.pixels.data(),
+                      static_cast<int>(command.rect.width * 4));
+    texture_upload_bytes().add(rect.area() * 4);
+}
+
+void GfxRenderer::upload_yuv(const GfxCommand& command) {
+    auto it = surfaces_.find(command.surface_id);
+    if (it == surfaces_.end() || command.rect.empty()) return;
+    Surface& surface = it->second;
+
+    // 4:2:0 textures need even dimensions
+    uint32_t yuv_width = (surface.width + 1) & ~1u;
+    uint32_t yuv_height = (surface.height + 1) & ~1u;
+    const Rect& area = command.rect;
+    if (area.right() > yuv_width || area.bottom() > yuv_height) return;
+    size_t luma = static_cast<size_t>(area.width) * area.height;
+    if (command.pixels.size() < luma + luma / 2) return;
+
+    if (!surface.yuv || surface.yuv_format != command.yuv_format) {
+        if (surface.yuv) SDL_DestroyTexture(surface.yuv);
+        surface.yuv = SDL_CreateTexture(renderer_, command.yuv_format,
+                                        SDL_TEXTUREACCESS_STREAMING,
+                                        static_cast<int>(yuv_width), static_cast<int>(yuv_height));
+        surface.yuv_format = command.yuv_format;
+        if (!surface.yuv) {
+            LOG_ERROR("YUV texture {}x{} failed: {}", yuv_width, yuv_height, SDL_GetError());
+            return;
+        }
+        SDL_SetTextureBlendMode(surface.yuv, SDL_BLENDMODE_NONE);
+    }
+
+    SDL_Rect dst_area = to_sdl(area);
+    const uint8_t* y_plane = command.pixels.data();
+    if (command.yuv_format == SDL_PIXELFORMAT_NV12) {
+        SDL_UpdateNVTexture(surface.yuv, &dst_area, y_plane, static_cast<int>(area.width),
+                            y_plane + luma, static_cast<int>(area.width));
+    } else {
+        const uint8_t* u_plane = y_plane + luma;
+        const uint8_t* v_plane = u_plane + luma / 4;
+        SDL_UpdateYUVTexture(surface.yuv, &dst_area, y_plane, static_cast<int>(area.width),
+                             u_plane, static_cast<int>(area.width / 2), v_plane,
+                             static_cast<int>(area.width / 2));
+    }
+
+    texture_upload_bytes().add(luma + luma / 2);
+
+    // The GPU converts to RGB while copying the changed regions into the surface
+    SDL_SetRenderTarget(renderer_, surface.texture);
+    for (Rect rect : command.rects) {
+        if (!clip_to(rect, surface.width, surface.height)) continue;
+        SDL_Rect r = to_sdl(rect);
+        SDL_RenderCopy(renderer_, surface.yuv, &r, &r);
+    }
+}
+
+void GfxRenderer::render(const SDL_Rect& area, SDL_ScaleMode filter) {
+    TRACE_SCOPE("gfx_render");
+    if (output_width_ == 0 || output_height_ == 0) return;
+
+    double scale_x = static_cast<double>(area.w) / output_width_;
+    double scale_y = static_cast<double>(area.h) / output_height_;
+
+    for (const auto& [id, surface] : surfaces_) {
+        if (!surface.mapped || !surface.texture) continue;
+        SDL_Rect dst = {area.x + static_cast<int>(surface.output_x * scale_x),
+                        area.y + static_cast<int>(surface.output_y * scale_y),
+                        static_cast<int>(surface.width * scale_x + 0.5),
+                        static_cast<int>(surface.height * scale_y + 0.5)};
+        SDL_SetTextureScaleMode(surface.texture, filter);
+        SDL_RenderCopy(renderer_, surface.texture, nullptr, &dst);
+    }
+}
+
+}  // namespace gvrdp
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "render/gfx_command.hpp"
+#include "util/metrics.hpp"
+
+#include <SDL2/SDL.h>
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+
+namespace gvrdp {
+
+// Pixel bytes sent to textures, by SdlRenderer and GfxRenderer
+Counter& texture_upload_bytes();
+
+// Replays RDPGFX command batches against GPU textures: one render-target
+// texture per surface and per cache slot. Fills and copies never touch the
+// CPU; only Upload commands transfer pixels. H.264 output arrives as YUV
+// planes in a per-surface streaming texture and is converted while being
+// copied into the surface.
+class GfxRenderer {
+public:
+    explicit GfxRenderer(SDL_Renderer* renderer);
+    ~GfxRenderer();
+
+    GfxRenderer(const GfxRenderer&) = delete;
+    GfxRenderer& operator=(const GfxRenderer&) = delete;
+
+    // Whether the renderer can draw into textures at all
+    bool supported() const;
+    // Largest surface side a texture can hold (0 = unknown)
+    uint32_t max_texture_size() const { return max_texture_size_; }
+
+    // Executes one batch. Leaves the default render target bound.
+    void apply(const GfxBatch& batch);
+
+    // Draws every output-mapped surface, scaled from the output size to
+    // `area` of the current render target with `filter`.
+    void render(const SDL_Rect& area, SDL_ScaleMode filter);
+
+    // Drops all surfaces and cache entries
+    void reset();
+
+    uint32_t output_width() const { return output_width_; }
+    uint32_t output_height() const { return output_height_; }
+
+private:
+    struct Surface {
+        SDL_Texture* texture = nullptr;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        bool mapped = false;
+        uint32_t output_x = 0;
+        uint32_t output_y = 0;
+        SDL_Texture* yuv = nullptr;  // IYUV/NV12 staging for UploadYuv
+        uint32_t yuv_format = 0;
+    };
+
+    struct CacheEntry {
+        SDL_Texture* texture = nullptr;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    SDL_Texture* create_texture(uint32_t width, uint32_t height);
+    SDL_Texture* scratch_texture(uint32_t width, uint32_t height);
+    void destroy_surface(uint16_t surface_id);
+    void destroy_cache_entry(uint16_t cache_slot);
+
+    void solid_fill(const GfxCommand& command);
+    void surface_to_surface(const GfxCommand& command);
+    void surface_to_cache(const GfxCommand& command);
+    void cache_to_surface(const GfxCommand& command);
+    void import_cache_entry(const GfxCommand& command);
+    void upload(const GfxCommand& command);
+    void upload_yuv(const GfxCommand& command);
+
+    SDL_Renderer* renderer_;
+    std::map<uint16_t, Surface> surfaces_;  // Ordered: composition is by surface id
+    std::unordered_map<uint16_t, CacheEntry> cache_;
+    SDL_Texture* scratch_ = nullptr;  // For overlapping same-surface copies
+    uint32_t scratch_width_ = 0;
+    uint32_t scratch_height_ = 0;
+    uint32_t output_width_ = 0;
+    uint32_t output_height_ = 0;
+    uint32_t max_texture_size_ = 0;
+};
+
+}  // namespace gvrdp
@@ -0,0 +1,239 @@
+#include "render/pointer_shape.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GVRDP_POINTER_SSE2 1
+#include <emmintrin.h>
+#else
+#define GVRDP_POINTER_SSE2 0
+#endif
+
+#include <cstring>
+
+namespace gvrdp {
+
+namespace {
+
+constexpr uint32_t kOpaque = 0xFF000000;
+constexpr uint32_t kColor = 0x00FFFFFF;
+
+// Mask rows are padded to a multiple of 2 bytes
+size_t row_stride(uint32_t width, uint32_t bpp) {
+    return ((static_cast<size_t>(width) * bpp + 15) / 16) * 2;
+}
+
+bool bit(const uint8_t* row, uint32_t x) {
+    return (row[x >> 3] & (0x80 >> (x & 7))) != 0;
+}
+
+// AND 0 / XOR 0: black, 0 / 1: white, 1 / 0: transparent, 1 / 1: inverted
+uint32_t mono_pixel(bool and_bit, bool xor_bit) {
+    if (!and_bit) return xor_bit ? 0xFFFFFFFF : kOpaque;
+    return xor_bit ? kOpaque : 0;
+}
+
+// AND 0: the color; AND 1: transparent over black, inverted otherwise
+uint32_t masked_pixel(uint32_t color, bool and_bit) {
+    color &= kColor;
+    if (!and_bit) return color | kOpaque;
+    return color ? kOpaque : 0;
+}
+
+#if GVRDP_POINTER_SSE2
+
+// All-ones lanes where bits 7..4 (lo) or 3..0 (hi) of `byte` are set
+void expand_bits(uint8_t byte, __m128i& lo, __m128i& hi) {
+    const __m128i lo_bits = _mm_set_epi32(0x10, 0x20, 0x40, 0x80);
+    const __m128i hi_bits = _mm_set_epi32(0x01, 0x02, 0x04, 0x08);
+    __m128i v = _mm_set1_epi32(byte);
+    lo = _mm_cmpeq_epi32(_mm_and_si128(v, lo_bits), lo_bits);
+    hi = _mm_cmpeq_epi32(_mm_and_si128(v, hi_bits), hi_bits);
+}
+
+// masked_pixel() on 4 lanes
+__m128i masked_pixels(__m128i colors, __m128i and_set) {
+    const __m128i color_mask = _mm_set1_epi32(static_cast<int>(kColor));
+    const __m128i opaque = _mm_set1_epi32(static_cast<int>(kOpaque));
+    __m128i color = _mm_and_si128(colors, color_mask);
+    __m128i black = _mm_cmpeq_epi32(color, _mm_setzero_si128());
+    // Opaque unless AND is set over black
+    __m128i alpha = _mm_andnot_si128(_mm_and_si128(and_set, black), opaque);
+    return _mm_or_si128(_mm_andnot_si128(and_set, color), alpha);
+}
+
+// mono_pixel() on 4 lanes
+__m128i mono_pixels(__m128i and_set, __m128i xor_set) {
+    const __m128i color_mask = _mm_set1_epi32(static_cast<int>(kColor));
+    const __m128i opaque = _mm_set1_epi32(static_cast<int>(kOpaque));
+    __m128i white = _mm_andnot_si128(and_set, _mm_and_si128(xor_set, color_mask));
+    __m128i alpha = _mm_and_si128(_mm_or_si128(_mm_xor_si128(and_set, _mm_set1_epi32(-1)),
+                                               xor_set),
+                                  opaque);
+    return _mm_or_si128(white, alpha);
+}
+
+#endif
+
+void convert_mono_row(const uint8_t* xor_row, const uint8_t* and_row, uint32_t width,
+                      uint32_t* out) {
+    uint32_t x = 0;
+#if GVRDP_POINTER_SSE2
+    for (; x + 8 <= width; x += 8) {
+        __m128i and_lo, and_hi, xor_lo, xor_hi;
+        expand_bits(and_row[x >> 3], and_lo, and_hi);
+        expand_bits(xor_row[x >> 3], xor_lo, xor_hi);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), mono_pixels(and_lo, xor_lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x + 4), mono_pixels(and_hi, xor_hi));
+    }
+#endif
+    for (; x < width; x++) {
+        out[x] = mono_pixel(bit(and_row, x), bit(xor_row, x));
+    }
+}
+
+// RGB565 to 0x00RRGGBB
+void convert_rgb565_row(const uint8_t* row, uint32_t width, uint32_t* out) {
+    uint32_t x = 0;
+#if GVRDP_POINTER_SSE2
+    const __m128i five = _mm_set1_epi16(0x1F);
+    const __m128i six = _mm_set1_epi16(0x3F);
+    for (; x + 8 <= width; x += 8) {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 2));
+        __m128i r = _mm_and_si128(_mm_srli_epi16(p, 11), five);
+        __m128i g = _mm_and_si128(_mm_srli_epi16(p, 5), six);
+        __m128i b = _mm_and_si128(p, five);
+        // Widen to 8 bits by repeating the top bits
+        r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+        g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+        b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+        __m128i gb = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_unpacklo_epi16(gb, r));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x + 4), _mm_unpackhi_epi16(gb, r));
+    }
+#endif
+    for (; x < width; x++) {
+        uint32_t p = row[x * 2] | (static_cast<uint32_t>(row[x * 2 + 1]) << 8);
+        uint32_t r = (p >> 11) & 0x1F;
+        uint32_t g = (p >> 5) & 0x3F;
+        uint32_t b = p & 0x1F;
+        r = (r << 3) | (r >> 2);
+        g = (g << 2) | (g >> 4);
+        b = (b << 3) | (b >> 2);
+        out[x] = (r << 16) | (g << 8) | b;
+    }
+}
+
+// BGR to 0x00RRGGBB
+void convert_bgr24_row(const uint8_t* row, uint32_t width, uint32_t* out) {
+    for (uint32_t x = 0; x < width; x++) {
+        const uint8_t* p = row + x * 3;
+        out[x] = (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[1]) << 8) | p[0];
+    }
+}
+
+// Turns colors into ARGB using the AND mask, in place
+void apply_and_mask(const uint8_t* and_row, uint32_t width, uint32_t* pixels) {
+    uint32_t x = 0;
+#if GVRDP_POINTER_SSE2
+    for (; x + 8 <= width; x += 8) {
+        __m128i and_lo, and_hi;
+        expand_bits(and_row[x >> 3], and_lo, and_hi);
+        auto* lo = reinterpret_cast<__m128i*>(pixels + x);
+        auto* hi = reinterpret_cast<__m128i*>(pixels + x + 4);
+        _mm_storeu_si128(lo, masked_pixels(_mm_loadu_si128(lo), and_lo));
+        _mm_storeu_si128(hi, masked_pixels(_mm_loadu_si128(hi), and_hi));
+    }
+#endif
+    for (; x < width; x++) {
+        pixels[x] = masked_pixel(pixels[x], bit(and_row, x));
+    }
+}
+
+void make_opaque(uint32_t width, uint32_t* pixels) {
+    uint32_t x = 0;
+#if GVRDP_POINTER_SSE2
+    const __m128i opaque = _mm_set1_epi32(static_cast<int>(kOpaque));
+    for (; x + 4 <= width; x += 4) {
+        auto* p = reinterpret_cast<__m128i*>(pixels + x);
+        _mm_storeu_si128(p, _mm_or_si128(_mm_loadu_si128(p), opaque));
+    }
+#endif
+    for (; x < width; x++) {
+        pixels[x] |= kOpaque;
+    }
+}
+
+// Whether any pixel of a 32 bpp mask has alpha; if none does, the AND mask
+// carries the transparency
+bool has_alpha(const uint8_t* data, size_t length) {
+    size_t i = 0;
+#if GVRDP_POINTER_SSE2
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(kOpaque));
+    for (; i + 16 <= length; i += 16) {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i a = _mm_and_si128(p, alpha);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, _mm_setzero_si128())) != 0xFFFF) return true;
+    }
+#endif
+    for (i += 3; i < length; i += 4) {
+        if (data[i] != 0) return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+bool convert_pointer(const PointerMasks& masks, uint32_t* out) {
+    uint32_t width = masks.width;
+    uint32_t height = masks.height;
+    if (width == 0 || height == 0 || !masks.xor_mask || !out) return false;
+
+    size_t xor_stride = row_stride(width, masks.xor_bpp);
+    size_t and_stride = row_stride(width, 1);
+    if (masks.xor_length < xor_stride * height) return false;
+    bool has_and = masks.and_mask && masks.and_length >= and_stride * height;
+
+    bool alpha = false;
+    switch (masks.xor_bpp) {
+        case 1:
+        case 16:
+        case 24:
+            if (!has_and) return false;
+            break;
+        case 32:
+            alpha = has_alpha(masks.xor_mask, xor_stride * height);
+            break;
+        default:
+            return false;
+    }
+
+    for (uint32_t y = 0; y < height; y++) {
+        // Bottom-up in the update, top-down in the cursor
+        const uint8_t* xor_row = masks.xor_mask + (height - 1 - y) * xor_stride;
+        const uint8_t* and_row = has_and ? masks.and_mask + (height - 1 - y) * and_stride : nullptr;
+        uint32_t* row = out + static_cast<size_t>(y) * width;
+
+        switch (masks.xor_bpp) {
+            case 1:
+                convert_mono_row(xor_row, and_row, width, row);
+                continue;
+            case 16:
+                convert_rgb565_row(xor_row, width, row);
+                break;
+            case 24:
+                convert_bgr24_row(xor_row, width, row);
+                break;
+            case 32:
+                std::memcpy(row, xor_row, static_cast<size_t>(width) * 4);
+                if (alpha) continue;
+                break;
+        }
+        if (and_row) {
+            apply_and_mask(and_row, width, row);
+        } else {
+            make_opaque(width, row);
+        }
+    }
+    return true;
+}
+
+}  // namespace gvrdp
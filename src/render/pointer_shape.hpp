@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gvrdp {
+
+// A server pointer converted to straight-alpha ARGB8888, top row first
+struct PointerShape {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t hotspot_x = 0;
+    uint32_t hotspot_y = 0;
+    std::vector<uint32_t> argb;
+};
+
+// Pointer shape as it arrives in a Color, Large or New Pointer update: an
+// XOR mask of `xor_bpp` bits per pixel and a 1 bpp AND mask, both stored
+// bottom row first with rows padded to 2 bytes
+struct PointerMasks {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t xor_bpp = 0;
+    const uint8_t* xor_mask = nullptr;
+    size_t xor_length = 0;
+    const uint8_t* and_mask = nullptr;  // May be absent for 32 bpp
+    size_t and_length = 0;
+};
+
+// Pointer change sent from the RDP thread to the cursor on the main thread.
+// `id` names one shape from Define until Release; the server's pointer
+// cache refers back to a shape by Set, without sending it again.
+struct PointerCommand {
+    enum class Type : uint8_t { Define, Set, Release, Hide, Default };
+    Type type = Type::Default;
+    uint32_t id = 0;
+    PointerShape shape;  // Define
+};
+
+// Converts masks to ARGB (`width * height` pixels into `out`). Handles 1, 16,
+// 24 and 32 bpp; palette formats (4 and 8 bpp) and truncated masks return
+// false. Where the AND mask is set over a non-black pixel Windows inverts
+// the screen; that becomes opaque black, as SDL cursors cannot invert.
+//
+// The mono, RGB565, mask and alpha kernels use SSE2 where the target has it.
+bool convert_pointer(const PointerMasks& masks, uint32_t* out);
+
+}  // namespace gvrdp
@@ -2,6 +2,8 @@
 
 #include "util/logger.hpp"
 
+#include <utility>
+
 namespace gvrdp {
 
 SdlCursor::SdlCursor() = default;
@@ -10,41 +12,123 @@ SdlCursor::~SdlCursor() {
     reset();
 }
 
-void SdlCursor::update(const uint8_t* data, uint32_t width, uint32_t height, uint32_t hotspot_x,
-                        uint32_t hotspot_y) {
-    reset();
+void SdlCursor::apply(PointerCommand& command) {
+    switch (command.type) {
+        case PointerCommand::Type::Define:
+            define(command.id, std::move(command.shape));
+            break;
+        case PointerCommand::Type::Set:
+            set(command.id);
+            break;
+        case PointerCommand::Type::Release:
+            release(command.id);
+            break;
+        case PointerCommand::Type::Hide:
+            set_visible(false);
+            break;
+        case PointerCommand::Type::Default:
+            SDL_SetCursor(SDL_GetDefaultCursor());
+            active_ = 0;
+            free_retired();
+            set_visible(true);
+            break;
+    }
+}
 
-    if (!data || width == 0 || height == 0) return;
+void SdlCursor::define(uint32_t id, PointerShape shape) {
+    release(id);
+    entries_[id].shape = std::move(shape);
+    changed_ = true;
+}
 
-    surface_ = SDL_CreateRGBSurfaceFrom(const_cast<uint8_t*>(data), static_cast<int>(width),
-                                         static_cast<int>(height), 32,
-                                         static_cast<int>(width * 4), 0x00FF0000, 0x0000FF00,
-                                         0x000000FF, 0xFF000000);
-    if (!surface_) {
-        LOG_WARN("Failed to create cursor surface: {}", SDL_GetError());
-        return;
+void SdlCursor::set(uint32_t id) {
+    auto it = entries_.find(id);
+    if (it == entries_.end()) return;
+    Entry& entry = it->second;
+
+    if (entry.cursor) {
+        lru_.splice(lru_.begin(), lru_, entry.lru);
+    } else {
+        entry.cursor = build(entry.shape);
+        if (!entry.cursor) return;
+        lru_.push_front(id);
+        entry.lru = lru_.begin();
+        // The active cursor is at the front, so it is never the one evicted
+        if (lru_.size() > kMaxCursors) evict(entries_.at(lru_.back()));
     }
 
-    cursor_ = SDL_CreateColorCursor(surface_, static_cast<int>(hotspot_x),
-                                     static_cast<int>(hotspot_y));
-    if (cursor_) {
-        SDL_SetCursor(cursor_);
+    SDL_SetCursor(entry.cursor);
+    active_ = id;
+    free_retired();
+    set_visible(true);
+}
+
+void SdlCursor::release(uint32_t id) {
+    auto it = entries_.find(id);
+    if (it == entries_.end()) return;
+    Entry& entry = it->second;
+    if (entry.cursor) {
+        lru_.erase(entry.lru);
+        if (id == active_) {
+            free_retired();
+            retired_ = entry.cursor;
+            active_ = 0;
+        } else {
+            SDL_FreeCursor(entry.cursor);
+        }
     }
+    entries_.erase(it);
 }
 
 void SdlCursor::set_visible(bool visible) {
+    changed_ = true;
     SDL_ShowCursor(visible ? SDL_ENABLE : SDL_DISABLE);
 }
 
 void SdlCursor::reset() {
-    if (cursor_) {
-        SDL_SetCursor(SDL_GetDefaultCursor());
-        SDL_FreeCursor(cursor_);
-        cursor_ = nullptr;
+    // Nothing to undo; also keeps the destructor away from a shut down SDL
+    if (!changed_) return;
+    changed_ = false;
+    SDL_SetCursor(SDL_GetDefaultCursor());
+    SDL_ShowCursor(SDL_ENABLE);
+    for (auto& [id, entry] : entries_) {
+        if (entry.cursor) SDL_FreeCursor(entry.cursor);
     }
-    if (surface_) {
-        SDL_FreeSurface(surface_);
-        surface_ = nullptr;
+    entries_.clear();
+    lru_.clear();
+    active_ = 0;
+    free_retired();
+}
+
+SDL_Cursor* SdlCursor::build(const PointerShape& shape) {
+    if (shape.width == 0 || shape.height == 0) return nullptr;
+
+    // SDL copies the pixels into the cursor; the surface is only a view
+    SDL_Surface* surface = SDL_CreateRGBSurfaceFrom(
+        const_cast<uint32_t*>(shape.argb.data()), static_cast<int>(shape.width),
+        static_cast<int>(shape.height), 32, static_cast<int>(shape.width * 4), 0x00FF0000,
+        0x0000FF00, 0x000000FF, 0xFF000000);
+    if (!surface) {
+        LOG_WARN("Failed to create cursor surface: {}", SDL_GetError());
+        return nullptr;
+    }
+    SDL_Cursor* cursor = SDL_CreateColorCursor(surface, static_cast<int>(shape.hotspot_x),
+                                               static_cast<int>(shape.hotspot_y));
+    SDL_FreeSurface(surface);
+    if (!cursor) LOG_WARN("Failed to create cursor: {}", SDL_GetError());
+    return cursor;
+}
+
+void SdlCursor::evict(Entry& entry) {
+    lru_.erase(entry.lru);
+    SDL_FreeCursor(entry.cursor);
+    entry.cursor = nullptr;
+}
+
+void SdlCursor::free_retired() {
+    if (retired_) {
+        SDL_FreeCursor(retired_);
+        retired_ = nullptr;
     }
 }
 
@@ -1,12 +1,22 @@
 #pragma once
 
+#include "render/pointer_shape.hpp"
+
 #include <SDL2/SDL.h>
 
+#include <cstddef>
 #include <cstdint>
+#include <list>
+#include <unordered_map>
 
 namespace gvrdp {
 
-// Manages custom cursor rendering for the remote desktop pointer.
+// The remote desktop pointer as the local hardware cursor.
+//
+// Shapes are kept by id for as long as the server's pointer cache holds
+// them. The SDL_Cursor for a shape is built the first time it is shown and
+// kept in a small LRU, so switching back to a cached pointer (the common
+// case over busy UIs) is a single SDL_SetCursor().
 class SdlCursor {
 public:
     SdlCursor();
@@ -15,19 +25,40 @@ public:
     SdlCursor(const SdlCursor&) = delete;
     SdlCursor& operator=(const SdlCursor&) = delete;
 
-    // Update cursor image from RDP pointer data
-    void update(const uint8_t* data, uint32_t width, uint32_t height, uint32_t hotspot_x,
-                uint32_t hotspot_y);
+    // Main thread, for each command drained from the session
+    void apply(PointerCommand& command);
+
+    void define(uint32_t id, PointerShape shape);
+    void set(uint32_t id);
+    void release(uint32_t id);
 
     // Show/hide the custom cursor
     void set_visible(bool visible);
 
-    // Reset to default system cursor
+    // Forget every shape and go back to the default system cursor
     void reset();
 
+    // Built SDL cursors kept at most
+    static constexpr size_t kMaxCursors = 16;
+
 private:
-    SDL_Cursor* cursor_ = nullptr;
-    SDL_Surface* surface_ = nullptr;
+    struct Entry {
+        PointerShape shape;
+        SDL_Cursor* cursor = nullptr;
+        std::list<uint32_t>::iterator lru;  // Valid while cursor is set
+    };
+
+    SDL_Cursor* build(const PointerShape& shape);
+    void evict(Entry& entry);
+    void free_retired();
+
+    std::unordered_map<uint32_t, Entry> entries_;
+    std::list<uint32_t> lru_;  // Ids with a built cursor, most recent first
+    uint32_t active_ = 0;      // 0 = none of ours
+    // The active cursor after its shape was released; SDL needs it alive
+    // until another cursor replaces it
+    SDL_Cursor* retired_ = nullptr;
+    bool changed_ = false;  // Since the last reset()
 };
 
 }  // namespace gvrdp
@@ -1,16 +1,39 @@
 #include "render/sdl_renderer.hpp"
 
 #include "util/logger.hpp"
+#include "util/metrics.hpp"
+#include "util/tracer.hpp"
+
+#include <algorithm>
+#include <chrono>
 
 namespace gvrdp {
 
+// Picks the first 32bpp format the renderer supports natively, so textures
+// are uploaded without a driver-side conversion. Alpha-less formats come
+// first: the desktop is opaque.
+static uint32_t choose_pixel_format(const SDL_RendererInfo& info) {
+    static constexpr uint32_t kPreferred[] = {
+        SDL_PIXELFORMAT_RGB888,
+        SDL_PIXELFORMAT_ARGB8888,
+        SDL_PIXELFORMAT_BGR888,
+        SDL_PIXELFORMAT_ABGR8888,
+    };
+    for (uint32_t format : kPreferred) {
+        for (uint32_t i = 0; i < info.num_texture_formats; i++) {
+            if (info.texture_formats[i] == format) return format;
+        }
+    }
+    return SDL_PIXELFORMAT_ARGB8888;
+}
+
 SdlRenderer::SdlRenderer() = default;
 
 SdlRenderer::~SdlRenderer() {
     shutdown();
 }
 
-bool SdlRenderer::init(const std::string& title, int x, int y, int w, int h) {
+bool SdlRenderer::init(const std::string& title, int x, int y, int w, int h, bool vsync) {
     int pos_x = (x >= 0) ? x : static_cast<int>(SDL_WINDOWPOS_CENTERED);
     int pos_y = (y >= 0) ? y : static_cast<int>(SDL_WINDOWPOS_CENTERED);
 
@@ -22,8 +45,9 @@ bool SdlRenderer::init(const std::string& title, int x, int y, int w, int h) {
         return false;
     }
 
-    renderer_ = SDL_CreateRenderer(window_, -1,
-                                   SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    Uint32 flags = SDL_RENDERER_ACCELERATED;
+    if (vsync) flags |= SDL_RENDERER_PRESENTVSYNC;
+    renderer_ = SDL_CreateRenderer(window_, -1, flags);
     if (!renderer_) {
         LOG_ERROR("SDL_CreateRenderer failed: {}", SDL_GetError());
         SDL_DestroyWindow(window_);
@@ -31,15 +55,28 @@ bool SdlRenderer::init(const std::string& title, int x, int y, int w, int h) {
         return false;
     }
 
-    LOG_INFO("SDL renderer initialized: {}x{}", w, h);
+    // Tiles keep desktops of any size within the renderer's texture limit
+    SDL_RendererInfo info;
+    uint32_t tile_size = TiledTexture::kTileSize;
+    if (SDL_GetRendererInfo(renderer_, &info) == 0) {
+        pixel_format_ = choose_pixel_format(info);
+        int max_size = std::min(info.max_texture_width, info.max_texture_height);
+        if (max_size > 0) {
+            int usable = max_size - static_cast<int>(2 * TileGrid::kGutter);
+            tile_size = static_cast<uint32_t>(std::clamp(usable, 1, static_cast<int>(tile_size)));
+        }
+    }
+    desktop_ = std::make_unique<TiledTexture>(renderer_, pixel_format_, tile_size);
+    gfx_ = std::make_unique<GfxRenderer>(renderer_);
+
+    LOG_INFO("SDL renderer initialized: {}x{} ({}, vsync {})", w, h,
+             SDL_GetPixelFormatName(pixel_format_), vsync ? "on" : "off");
     return true;
 }
 
 void SdlRenderer::shutdown() {
-    if (texture_) {
-        SDL_DestroyTexture(texture_);
-        texture_ = nullptr;
-    }
+    gfx_.reset();
+    desktop_.reset();
     if (renderer_) {
         SDL_DestroyRenderer(renderer_);
         renderer_ = nullptr;
@@ -51,45 +88,102 @@ void SdlRenderer::shutdown() {
 }
 
 bool SdlRenderer::resize_texture(uint32_t width, uint32_t height) {
-    if (texture_) {
-        SDL_DestroyTexture(texture_);
-        texture_ = nullptr;
+    if (!desktop_) return false;
+    // GDI paints in the FreeRDP equivalent of pixel_format_
+    if (!desktop_->resize(width, height)) return false;
+    LOG_INFO("Texture resized to {}x{} ({} tiles)", width, height, desktop_->tile_count());
+    return true;
+}
+
+void SdlRenderer::update_frame_region(const uint8_t* buffer, uint32_t width, uint32_t height,
+                                      uint32_t stride, const DamageRegion& damage) {
+    TRACE_SCOPE("update_frame");
+    if (!buffer || !desktop_) return;
+
+    // New tiles have undefined contents and kept ones show the old layout,
+    // so upload everything once
+    if (desktop_->empty() || width != desktop_->width() || height != desktop_->height()) {
+        if (!resize_texture(width, height)) return;
+        desktop_->upload(buffer, stride, Rect{0, 0, width, height});
+        texture_upload_bytes().add(static_cast<uint64_t>(width) * height * 4);
+        return;
     }
 
-    // BGRA32 from FreeRDP maps to SDL ARGB8888
-    texture_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_ARGB8888,
-                                 SDL_TEXTUREACCESS_STREAMING,
-                                 static_cast<int>(width), static_cast<int>(height));
-    if (!texture_) {
-        LOG_ERROR("SDL_CreateTexture failed: {}", SDL_GetError());
-        return false;
+    DamageRegion clipped = damage;
+    clipped.clip(width, height);
+    for (const auto& rect : clipped.rects()) {
+        desktop_->upload(buffer, stride, rect);
     }
+    texture_upload_bytes().add(clipped.area() * 4);
+}
 
-    tex_width_ = width;
-    tex_height_ = height;
-    LOG_INFO("Texture resized to {}x{}", width, height);
-    return true;
+void SdlRenderer::render_desktop() {
+    if (!desktop_ || desktop_->empty()) return;
+    update_viewport(desktop_->width(), desktop_->height());
+    desktop_->render(output_rect(), filter());
 }
 
-void SdlRenderer::update_frame(const uint8_t* buffer, uint32_t width, uint32_t height,
-                                uint32_t stride) {
-    if (!texture_ || !buffer) return;
+void SdlRenderer::render_gfx() {
+    if (!gfx_ || gfx_->output_width() == 0 || gfx_->output_height() == 0) return;
+    update_viewport(gfx_->output_width(), gfx_->output_height());
+    gfx_->render(output_rect(), filter());
+}
 
-    // Recreate texture if dimensions changed
-    if (width != tex_width_ || height != tex_height_) {
-        if (!resize_texture(width, height)) return;
+void SdlRenderer::set_smart_sizing(bool enabled, SDL_ScaleMode filter) {
+    smart_sizing_ = enabled;
+    smart_sizing_filter_ = filter;
+}
+
+void SdlRenderer::update_viewport(uint32_t desktop_width, uint32_t desktop_height) {
+    Viewport viewport =
+        smart_sizing_
+            ? Viewport::letterboxed(desktop_width, desktop_height, window_width(), window_height())
+            : Viewport::fit(desktop_width, desktop_height, window_width(), window_height());
+    if (viewport.scaled() != viewport_.scaled()) {
+        LOG_DEBUG("Desktop {}x{} drawn {}", desktop_width, desktop_height,
+                  viewport.scaled() ? "scaled" : "1:1");
     }
+    viewport_ = viewport;
+}
 
-    SDL_UpdateTexture(texture_, nullptr, buffer, static_cast<int>(stride));
+SDL_ScaleMode SdlRenderer::filter() const {
+    if (!viewport_.scaled()) return SDL_ScaleModeNearest;
+    return smart_sizing_ ? smart_sizing_filter_ : SDL_ScaleModeLinear;
 }
 
-void SdlRenderer::render_desktop() {
-    if (!texture_) return;
-    SDL_RenderCopy(renderer_, texture_, nullptr, nullptr);
+SDL_Rect SdlRenderer::output_rect() const {
+    SDL_Rect rect = {viewport_.x, viewport_.y, viewport_.width, viewport_.height};
+    int window_w = window_width();
+    int window_h = window_height();
+    int output_w = 0;
+    int output_h = 0;
+    SDL_GetRendererOutputSize(renderer_, &output_w, &output_h);
+    if (window_w <= 0 || window_h <= 0 || (output_w == window_w && output_h == window_h)) {
+        return rect;
+    }
+    auto scale = [](int value, int output, int window) {
+        return static_cast<int>(static_cast<int64_t>(value) * output / window);
+    };
+    return {scale(rect.x, output_w, window_w), scale(rect.y, output_h, window_h),
+            scale(rect.w, output_w, window_w), scale(rect.h, output_h, window_h)};
+}
+
+void SdlRenderer::reset_textures() {
+    if (desktop_) desktop_->clear();
+    if (gfx_) gfx_->reset();
 }
 
 void SdlRenderer::present() {
+    TRACE_SCOPE("present");
+    static Counter& presents =
+        Metrics::global().counter("gvrdp_frames_presented_total", "Frames presented");
+    static Histogram& present_time =
+        Metrics::global().histogram("gvrdp_present_seconds", "Time spent in present()");
+
+    auto started = std::chrono::steady_clock::now();
     SDL_RenderPresent(renderer_);
+    present_time.observe(std::chrono::steady_clock::now() - started);
+    presents.add();
 }
 
 void SdlRenderer::clear() {
@@ -1,13 +1,20 @@
 #pragma once
 
+#include "render/gfx_renderer.hpp"
+#include "render/tiled_texture.hpp"
+#include "render/viewport.hpp"
+#include "util/damage_region.hpp"
+
 #include <SDL2/SDL.h>
 
 #include <cstdint>
+#include <memory>
 #include <string>
 
 namespace gvrdp {
 
-// Manages the SDL2 window, renderer, and texture for displaying the remote desktop.
+// Manages the SDL2 window, renderer, and the tiled texture displaying the
+// remote desktop.
 class SdlRenderer {
 public:
     SdlRenderer();
@@ -16,25 +23,52 @@ public:
     SdlRenderer(const SdlRenderer&) = delete;
     SdlRenderer& operator=(const SdlRenderer&) = delete;
 
-    // Create window and renderer
-    bool init(const std::string& title, int x, int y, int w, int h);
+    // Create window and renderer. Without vsync, present() never waits for
+    // the display and frames may tear.
+    bool init(const std::string& title, int x, int y, int w, int h, bool vsync = true);
     void shutdown();
 
-    // Recreate texture at new dimensions (called on desktop resize)
+    // Resize the desktop texture (called on desktop resize). Only tiles at
+    // the grid's edge are created or destroyed; see TiledTexture.
     bool resize_texture(uint32_t width, uint32_t height);
 
-    // Copy GDI buffer data into the texture
-    void update_frame(const uint8_t* buffer, uint32_t width, uint32_t height, uint32_t stride);
+    // Copy only the damaged rectangles of the GDI buffer into the texture.
+    // Falls back to a full upload when the texture has to be (re)created.
+    void update_frame_region(const uint8_t* buffer, uint32_t width, uint32_t height,
+                             uint32_t stride, const DamageRegion& damage);
 
-    // Render the desktop texture to the window
+    // Render the desktop texture to the window, 1:1 when it has the
+    // window's size and filtered to the window's size otherwise (a preview
+    // until the server's resize lands), or letterboxed with smart sizing.
     void render_desktop();
 
+    // GPU composition of RDPGFX surfaces (used instead of the desktop
+    // texture while the graphics pipeline is active)
+    GfxRenderer& gfx() { return *gfx_; }
+    // Composes the GFX output into the window like render_desktop()
+    void render_gfx();
+
+    // Smart sizing: the desktop keeps its size and is letterboxed into the
+    // window with `filter`, instead of following the window (the default)
+    void set_smart_sizing(bool enabled, SDL_ScaleMode filter = SDL_ScaleModeLinear);
+
+    // Where the last render_*() call put the desktop; pointer input is
+    // mapped through it
+    const Viewport& viewport() const { return viewport_; }
+
+    // Drops every texture after SDL reports lost render targets or a lost
+    // device; callers must re-send their content.
+    void reset_textures();
+
     // Present the final frame (call after ImGui render)
     void present();
 
     // Clear the renderer
     void clear();
 
+    // Native 32bpp texture format picked from SDL_RendererInfo at init()
+    uint32_t pixel_format() const { return pixel_format_; }
+
     SDL_Window* window() const { return window_; }
     SDL_Renderer* renderer() const { return renderer_; }
     uint32_t window_id() const;
@@ -43,11 +77,21 @@ public:
     int window_height() const;
 
 private:
+    // Viewport::fit() for this desktop size and the current window
+    void update_viewport(uint32_t desktop_width, uint32_t desktop_height);
+    // The viewport in renderer output pixels (differs on high-DPI displays)
+    SDL_Rect output_rect() const;
+    // Filtering a 1:1 copy would only blur it
+    SDL_ScaleMode filter() const;
+
     SDL_Window* window_ = nullptr;
     SDL_Renderer* renderer_ = nullptr;
-    SDL_Texture* texture_ = nullptr;
-    uint32_t tex_width_ = 0;
-    uint32_t tex_height_ = 0;
+    std::unique_ptr<TiledTexture> desktop_;
+    std::unique_ptr<GfxRenderer> gfx_;
+    uint32_t pixel_format_ = SDL_PIXELFORMAT_ARGB8888;
+    Viewport viewport_;
+    bool smart_sizing_ = false;
+    SDL_ScaleMode smart_sizing_filter_ = SDL_ScaleModeLinear;
 };
 
 }  // namespace gvrdp
@@ -0,0 +1,28 @@
+#include "render/tile_grid.hpp"
+
+namespace gvrdp {
+
+void TileGrid::resize(uint32_t width, uint32_t height) {
+    width_ = width;
+    height_ = height;
+    columns_ = (width + tile_size_ - 1) / tile_size_;
+    rows_ = (height + tile_size_ - 1) / tile_size_;
+    if (columns_ == 0 || rows_ == 0) columns_ = rows_ = 0;
+}
+
+Rect TileGrid::tile_rect(uint32_t column, uint32_t row) const {
+    Rect tile{column * tile_size_, row * tile_size_, tile_size_, tile_size_};
+    return tile.intersected({0, 0, width_, height_});
+}
+
+Rect TileGrid::stored_rect(uint32_t column, uint32_t row) const {
+    Rect tile = tile_rect(column, row);
+    if (tile.empty()) return {};
+    uint32_t left = tile.x >= kGutter ? tile.x - kGutter : 0;
+    uint32_t top = tile.y >= kGutter ? tile.y - kGutter : 0;
+    uint32_t right = std::min(tile.right() + kGutter, width_);
+    uint32_t bottom = std::min(tile.bottom() + kGutter, height_);
+    return {left, top, right - left, bottom - top};
+}
+
+}  // namespace gvrdp
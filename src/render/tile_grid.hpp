@@ -0,0 +1,77 @@
+#pragma once
+
+#include "util/damage_region.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace gvrdp {
+
+// Splits a desktop into square tiles of `tile_size` pixels, the last column
+// and row cut short. Each tile is stored with a gutter: a copy of the
+// neighbouring pixels one pixel wide around it, so a filtered, scaled draw
+// samples across tile edges as if the desktop were one texture.
+//
+// Tile storage is (tile_size + 2 * kGutter) square. In a tile's storage,
+// desktop pixel (x, y) is at (x - origin_x, y - origin_y), see origin().
+class TileGrid {
+public:
+    static constexpr uint32_t kGutter = 1;
+
+    explicit TileGrid(uint32_t tile_size = 512) : tile_size_(tile_size ? tile_size : 1) {}
+
+    void resize(uint32_t width, uint32_t height);
+
+    uint32_t width() const { return width_; }
+    uint32_t height() const { return height_; }
+    uint32_t tile_size() const { return tile_size_; }
+    uint32_t storage_size() const { return tile_size_ + 2 * kGutter; }
+    uint32_t columns() const { return columns_; }
+    uint32_t rows() const { return rows_; }
+    size_t count() const { return static_cast<size_t>(columns_) * rows_; }
+    size_t index(uint32_t column, uint32_t row) const {
+        return static_cast<size_t>(row) * columns_ + column;
+    }
+
+    // The desktop pixels a tile shows
+    Rect tile_rect(uint32_t column, uint32_t row) const;
+    // The desktop pixels a tile stores: its rect and the gutter, clipped
+    Rect stored_rect(uint32_t column, uint32_t row) const;
+    // Desktop position of the tile storage's top-left pixel (may be -1)
+    int64_t origin_x(uint32_t column) const {
+        return static_cast<int64_t>(column) * tile_size_ - kGutter;
+    }
+    int64_t origin_y(uint32_t row) const {
+        return static_cast<int64_t>(row) * tile_size_ - kGutter;
+    }
+
+    // Calls fn(column, row, part) for every tile storing part of `rect`,
+    // with `part` the desktop pixels of `rect` that tile stores. Pixels on
+    // a tile edge are stored twice (tile and neighbour's gutter).
+    template <typename Fn>
+    void for_each_stored(const Rect& rect, Fn&& fn) const {
+        Rect clipped = rect.intersected({0, 0, width_, height_});
+        if (clipped.empty()) return;
+        // Tiles whose stored rect reaches into `clipped`, gutters included
+        uint32_t first_column = clipped.x > kGutter ? (clipped.x - kGutter) / tile_size_ : 0;
+        uint32_t first_row = clipped.y > kGutter ? (clipped.y - kGutter) / tile_size_ : 0;
+        uint32_t last_column = std::min((clipped.right() - 1 + kGutter) / tile_size_, columns_ - 1);
+        uint32_t last_row = std::min((clipped.bottom() - 1 + kGutter) / tile_size_, rows_ - 1);
+        for (uint32_t row = first_row; row <= last_row; row++) {
+            for (uint32_t column = first_column; column <= last_column; column++) {
+                Rect part = clipped.intersected(stored_rect(column, row));
+                if (!part.empty()) fn(column, row, part);
+            }
+        }
+    }
+
+private:
+    uint32_t tile_size_;
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    uint32_t columns_ = 0;
+    uint32_t rows_ = 0;
+};
+
+}  // namespace gvrdp
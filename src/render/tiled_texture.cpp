@@ -0,0 +1,145 @@
+#include "render/tiled_texture.hpp"
+
+#include "util/logger.hpp"
+
+namespace gvrdp {
+
+TiledTexture::TiledTexture(SDL_Renderer* renderer, uint32_t pixel_format, uint32_t tile_size)
+    : renderer_(renderer), pixel_format_(pixel_format), grid_(tile_size) {}
+
+TiledTexture::~TiledTexture() {
+    clear();
+}
+
+SDL_Texture* TiledTexture::create_tile() {
+    int size = static_cast<int>(grid_.storage_size());
+    SDL_Texture* tile =
+        SDL_CreateTexture(renderer_, pixel_format_, SDL_TEXTUREACCESS_STREAMING, size, size);
+    if (!tile) {
+        LOG_ERROR("SDL_CreateTexture failed for a {}x{} tile: {}", size, size, SDL_GetError());
+        return nullptr;
+    }
+    // The desktop is opaque; skip blending even for formats with alpha
+    SDL_SetTextureBlendMode(tile, SDL_BLENDMODE_NONE);
+    return tile;
+}
+
+bool TiledTexture::resize(uint32_t width, uint32_t height) {
+    TileGrid old_grid = grid_;
+    grid_.resize(width, height);
+
+    std::vector<SDL_Texture*> tiles(grid_.count(), nullptr);
+    for (uint32_t row = 0; row < old_grid.rows(); row++) {
+        for (uint32_t column = 0; column < old_grid.columns(); column++) {
+            SDL_Texture*& tile = tiles_[old_grid.index(column, row)];
+            if (row < grid_.rows() && column < grid_.columns()) {
+                tiles[grid_.index(column, row)] = tile;
+            } else {
+                SDL_DestroyTexture(tile);
+            }
+            tile = nullptr;
+        }
+    }
+    tiles_ = std::move(tiles);
+
+    for (SDL_Texture*& tile : tiles_) {
+        if (tile) continue;
+        tile = create_tile();
+        if (!tile) {
+            clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+void TiledTexture::upload(const uint8_t* buffer, uint32_t stride, const Rect& rect) {
+    if (!buffer || tiles_.empty()) return;
+    grid_.for_each_stored(rect, [&](uint32_t column, uint32_t row, const Rect& part) {
+        upload_part(column, row, buffer, stride, part);
+    });
+}
+
+void TiledTexture::upload_part(uint32_t column, uint32_t row, const uint8_t* buffer,
+                               uint32_t stride, const Rect& part) {
+    SDL_Texture* tile = tiles_[grid_.index(column, row)];
+    int64_t origin_x = grid_.origin_x(column);
+    int64_t origin_y = grid_.origin_y(row);
+
+    // Desktop pixels (x, y, w, h) to the tile pixels of desktop (to_x, to_y)
+    auto copy = [&](uint32_t x, uint32_t y, uint32_t w, uint32_t h, int64_t to_x, int64_t to_y) {
+        SDL_Rect dst = {static_cast<int>(to_x - origin_x), static_cast<int>(to_y - origin_y),
+                        static_cast<int>(w), static_cast<int>(h)};
+        SDL_UpdateTexture(tile, &dst, buffer + static_cast<size_t>(y) * stride +
+                                          static_cast<size_t>(x) * 4,
+                          static_cast<int>(stride));
+    };
+    copy(part.x, part.y, part.width, part.height, part.x, part.y);
+
+    // The desktop's own edges have no neighbour to fill the gutter: repeat
+    // the edge pixels, so filtering clamps there as on a single texture
+    uint32_t right = grid_.width() - 1;
+    uint32_t bottom = grid_.height() - 1;
+    bool left_edge = column == 0 && part.x == 0;
+    bool right_edge = column == grid_.columns() - 1 && part.right() == grid_.width();
+    bool top_edge = row == 0 && part.y == 0;
+    bool bottom_edge = row == grid_.rows() - 1 && part.bottom() == grid_.height();
+    if (left_edge) copy(0, part.y, 1, part.height, -1, part.y);
+    if (right_edge) copy(right, part.y, 1, part.height, right + 1, part.y);
+    if (top_edge) copy(part.x, 0, part.width, 1, part.x, -1);
+    if (bottom_edge) copy(part.x, bottom, part.width, 1, part.x, bottom + 1);
+    if (left_edge && top_edge) copy(0, 0, 1, 1, -1, -1);
+    if (right_edge && top_edge) copy(right, 0, 1, 1, right + 1, -1);
+    if (left_edge && bottom_edge) copy(0, bottom, 1, 1, -1, bottom + 1);
+    if (right_edge && bottom_edge) copy(right, bottom, 1, 1, right + 1, bottom + 1);
+}
+
+void TiledTexture::render(const SDL_Rect& area, SDL_ScaleMode filter) {
+    tiles_drawn_ = 0;
+    if (tiles_.empty() || area.w <= 0 || area.h <= 0) return;
+
+    int output_w = 0;
+    int output_h = 0;
+    SDL_GetRendererOutputSize(renderer_, &output_w, &output_h);
+
+    // Tile edges are computed from desktop edges, so neighbours meet exactly
+    auto edge_x = [&](uint32_t x) {
+        return area.x + static_cast<int>(static_cast<int64_t>(x) * area.w / grid_.width());
+    };
+    auto edge_y = [&](uint32_t y) {
+        return area.y + static_cast<int>(static_cast<int64_t>(y) * area.h / grid_.height());
+    };
+
+    for (uint32_t row = 0; row < grid_.rows(); row++) {
+        for (uint32_t column = 0; column < grid_.columns(); column++) {
+            Rect tile = grid_.tile_rect(column, row);
+            SDL_Rect dst = {edge_x(tile.x), edge_y(tile.y), 0, 0};
+            dst.w = edge_x(tile.right()) - dst.x;
+            dst.h = edge_y(tile.bottom()) - dst.y;
+            if (dst.w <= 0 || dst.h <= 0) continue;
+            if (dst.x >= output_w || dst.y >= output_h || dst.x + dst.w <= 0 ||
+                dst.y + dst.h <= 0) {
+                continue;
+            }
+
+            SDL_Rect src = {static_cast<int>(tile.x - grid_.origin_x(column)),
+                            static_cast<int>(tile.y - grid_.origin_y(row)),
+                            static_cast<int>(tile.width), static_cast<int>(tile.height)};
+            SDL_Texture* texture = tiles_[grid_.index(column, row)];
+            SDL_SetTextureScaleMode(texture, filter);
+            SDL_RenderCopy(renderer_, texture, &src, &dst);
+            tiles_drawn_++;
+        }
+    }
+}
+
+void TiledTexture::clear() {
+    for (SDL_Texture* tile : tiles_) {
+        if (tile) SDL_DestroyTexture(tile);
+    }
+    tiles_.clear();
+    grid_.resize(0, 0);
+    tiles_drawn_ = 0;
+}
+
+}  // namespace gvrdp
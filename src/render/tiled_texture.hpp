@@ -0,0 +1,62 @@
+#pragma once
+
+#include "render/tile_grid.hpp"
+#include "util/damage_region.hpp"
+
+#include <SDL2/SDL.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gvrdp {
+
+// The desktop as a grid of fixed-size streaming textures (see TileGrid)
+// instead of one texture of the desktop's size. Desktops larger than the
+// renderer's maximum texture size still display, damage is uploaded to the
+// tiles it touches, a resize only creates or destroys the tiles at the
+// grid's edge, and render() skips tiles that fall outside the output.
+class TiledTexture {
+public:
+    static constexpr uint32_t kTileSize = 512;
+
+    TiledTexture(SDL_Renderer* renderer, uint32_t pixel_format, uint32_t tile_size = kTileSize);
+    ~TiledTexture();
+
+    TiledTexture(const TiledTexture&) = delete;
+    TiledTexture& operator=(const TiledTexture&) = delete;
+
+    // Tiles that exist at both sizes are kept, with their contents; the
+    // caller uploads whatever the new size changed. False if a tile could
+    // not be created, leaving the texture empty.
+    bool resize(uint32_t width, uint32_t height);
+
+    // Copies `rect` of a desktop-sized 32bpp buffer into the tiles
+    void upload(const uint8_t* buffer, uint32_t stride, const Rect& rect);
+
+    // Draws the desktop scaled to `area` of the current render target
+    void render(const SDL_Rect& area, SDL_ScaleMode filter);
+
+    // Destroys every tile
+    void clear();
+
+    bool empty() const { return tiles_.empty(); }
+    uint32_t width() const { return grid_.width(); }
+    uint32_t height() const { return grid_.height(); }
+    size_t tile_count() const { return tiles_.size(); }
+    // Tiles the last render() drew
+    size_t tiles_drawn() const { return tiles_drawn_; }
+
+private:
+    SDL_Texture* create_tile();
+    void upload_part(uint32_t column, uint32_t row, const uint8_t* buffer, uint32_t stride,
+                     const Rect& part);
+
+    SDL_Renderer* renderer_;
+    uint32_t pixel_format_;
+    TileGrid grid_;
+    std::vector<SDL_Texture*> tiles_;  // Row-major, TileGrid::index()
+    size_t tiles_drawn_ = 0;
+};
+
+}  // namespace gvrdp
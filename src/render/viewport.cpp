@@ -0,0 +1,89 @@
+#include "render/viewport.hpp"
+
+#include <algorithm>
+
+namespace gvrdp {
+
+namespace {
+
+// Window offset `offset` within a span of `window` pixels, mapped onto
+// `desktop` pixels: rounded down, or up for the far edge of a rectangle
+int64_t scale(int64_t offset, int window, uint32_t desktop, bool round_up) {
+    int64_t scaled = offset * desktop;
+    if (round_up) scaled += window - 1;
+    return std::clamp<int64_t>(scaled / window, 0, desktop);
+}
+
+}  // namespace
+
+Viewport Viewport::native(uint32_t desktop_width, uint32_t desktop_height) {
+    return {desktop_width, desktop_height, 0, 0, static_cast<int>(desktop_width),
+            static_cast<int>(desktop_height)};
+}
+
+Viewport Viewport::stretched(uint32_t desktop_width, uint32_t desktop_height, int window_width,
+                             int window_height) {
+    return {desktop_width, desktop_height, 0, 0, window_width, window_height};
+}
+
+Viewport Viewport::letterboxed(uint32_t desktop_width, uint32_t desktop_height,
+                               int window_width, int window_height) {
+    if (desktop_width == 0 || desktop_height == 0 || window_width <= 0 || window_height <= 0) {
+        return {desktop_width, desktop_height, 0, 0, 0, 0};
+    }
+    int64_t width = window_width;
+    int64_t height = window_height;
+    // Compare window_width / desktop_width with window_height / desktop_height
+    if (width * desktop_height <= height * desktop_width) {
+        height = (width * desktop_height + desktop_width / 2) / desktop_width;
+    } else {
+        width = (height * desktop_width + desktop_height / 2) / desktop_height;
+    }
+    return {desktop_width, desktop_height, static_cast<int>((window_width - width) / 2),
+            static_cast<int>((window_height - height) / 2), static_cast<int>(width),
+            static_cast<int>(height)};
+}
+
+Viewport Viewport::fit(uint32_t desktop_width, uint32_t desktop_height, int window_width,
+                       int window_height) {
+    auto matches = [](uint32_t desktop, int window) {
+        return window >= 0 && (static_cast<uint32_t>(window) & ~1u) == desktop;
+    };
+    if (matches(desktop_width, window_width) && matches(desktop_height, window_height)) {
+        return native(desktop_width, desktop_height);
+    }
+    return stretched(desktop_width, desktop_height, window_width, window_height);
+}
+
+bool Viewport::scaled() const {
+    return static_cast<int64_t>(width) != desktop_width ||
+           static_cast<int64_t>(height) != desktop_height;
+}
+
+void Viewport::to_desktop(int window_x, int window_y, uint16_t& desktop_x,
+                          uint16_t& desktop_y) const {
+    if (empty()) {
+        desktop_x = static_cast<uint16_t>(std::max(window_x, 0));
+        desktop_y = static_cast<uint16_t>(std::max(window_y, 0));
+        return;
+    }
+    int64_t dx = scale(window_x - x, width, desktop_width, false);
+    int64_t dy = scale(window_y - y, height, desktop_height, false);
+    // Positions right of or below the desktop stay on its last pixel
+    desktop_x = static_cast<uint16_t>(std::min<int64_t>(dx, desktop_width - 1));
+    desktop_y = static_cast<uint16_t>(std::min<int64_t>(dy, desktop_height - 1));
+}
+
+Rect Viewport::to_desktop(int window_x, int window_y, int window_width,
+                          int window_height) const {
+    if (empty() || window_width <= 0 || window_height <= 0) return {};
+    int64_t left = scale(window_x - x, width, desktop_width, false);
+    int64_t top = scale(window_y - y, height, desktop_height, false);
+    int64_t right = scale(window_x + window_width - x, width, desktop_width, true);
+    int64_t bottom = scale(window_y + window_height - y, height, desktop_height, true);
+    if (right <= left || bottom <= top) return {};
+    return {static_cast<uint32_t>(left), static_cast<uint32_t>(top),
+            static_cast<uint32_t>(right - left), static_cast<uint32_t>(bottom - top)};
+}
+
+}  // namespace gvrdp
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "util/damage_region.hpp"
+
+#include <cstdint>
+
+namespace gvrdp {
+
+// Where the remote desktop is drawn in the window, in window coordinates
+// (the units of SDL mouse events and window sizes), and the inverse mapping
+// for pointer input. Renderer and InputHandler share one, so a click lands
+// on the desktop pixel shown under it.
+struct Viewport {
+    uint32_t desktop_width = 0;
+    uint32_t desktop_height = 0;
+    int x = 0;  // Desktop's top-left corner and size in the window
+    int y = 0;
+    int width = 0;
+    int height = 0;
+
+    // Drawn 1:1 at the window's origin
+    static Viewport native(uint32_t desktop_width, uint32_t desktop_height);
+    // Scaled to cover the whole window, aspect ratio ignored. While a
+    // window drag waits for the server's resize this previews the last frame
+    // at the size the desktop is about to have.
+    static Viewport stretched(uint32_t desktop_width, uint32_t desktop_height, int window_width,
+                              int window_height);
+    // Scaled as large as fits in the window, aspect ratio kept, centred
+    // with bars on two sides. Smart sizing: the desktop size never changes.
+    static Viewport letterboxed(uint32_t desktop_width, uint32_t desktop_height,
+                                int window_width, int window_height);
+    // Native when the desktop already has the window's size (layouts are
+    // even, so an odd window is one pixel larger), stretched otherwise
+    static Viewport fit(uint32_t desktop_width, uint32_t desktop_height, int window_width,
+                        int window_height);
+
+    bool empty() const {
+        return width <= 0 || height <= 0 || desktop_width == 0 || desktop_height == 0;
+    }
+    // Whether drawing needs a filter: any size other than 1:1
+    bool scaled() const;
+
+    // The desktop pixel under a window position, clamped to the desktop
+    void to_desktop(int window_x, int window_y, uint16_t& desktop_x, uint16_t& desktop_y) const;
+    // The desktop pixels covered by a window rectangle
+    Rect to_desktop(int window_x, int window_y, int window_width, int window_height) const;
+
+    bool operator==(const Viewport&) const = default;
+};
+
+}  // namespace gvrdp
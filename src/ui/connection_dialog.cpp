@@ -2,6 +2,7 @@
 
 #include <imgui.h>
 
+#include <algorithm>
 #include <array>
 
 namespace gvrdp {
@@ -63,6 +64,23 @@ void draw_connection_dialog(ConnectionProfile& profile,
         if (height > 0) profile.height = static_cast<uint32_t>(height);
 
         ImGui::Checkbox("Dynamic Resolution", &profile.dynamic_resolution);
+        ImGui::Checkbox("Smart Sizing (scale locally)", &profile.smart_sizing);
+
+        // Stored by name, see ConnectionProfile::scaling_filter
+        static constexpr std::array<const char*, 3> kFilters = {"nearest", "linear", "best"};
+        static constexpr std::array<const char*, 3> kFilterLabels = {"Nearest", "Linear",
+                                                                     "High Quality"};
+        int filter = static_cast<int>(
+            std::find(kFilters.begin(), kFilters.end(), profile.scaling_filter) -
+            kFilters.begin());
+        if (filter >= static_cast<int>(kFilters.size())) filter = 1;
+        if (!profile.smart_sizing) ImGui::BeginDisabled();
+        if (ImGui::Combo("Scaling Filter", &filter, kFilterLabels.data(),
+                         static_cast<int>(kFilterLabels.size()))) {
+            profile.scaling_filter = kFilters[static_cast<size_t>(filter)];
+        }
+        if (!profile.smart_sizing) ImGui::EndDisabled();
+
         ImGui::Checkbox("Fullscreen", &profile.fullscreen);
     }
 
@@ -79,6 +97,30 @@ void draw_connection_dialog(ConnectionProfile& profile,
         ImGui::Checkbox("Font Smoothing", &profile.enable_font_smoothing);
         ImGui::Checkbox("Desktop Composition", &profile.enable_desktop_composition);
         ImGui::Checkbox("Themes", &profile.enable_themes);
+        ImGui::Checkbox("Graphics Pipeline (GPU)", &profile.enable_gfx_pipeline);
+
+        int max_fps = static_cast<int>(profile.max_fps);
+        ImGui::InputInt("Max FPS (0 = display)", &max_fps);
+        profile.max_fps = static_cast<uint32_t>(std::clamp(max_fps, 0, 240));
+
+        int ack_window = static_cast<int>(profile.gfx_ack_window);
+        if (!profile.enable_gfx_pipeline) ImGui::BeginDisabled();
+        ImGui::InputInt("Frames Acked Ahead", &ack_window);
+        if (!profile.enable_gfx_pipeline) ImGui::EndDisabled();
+        profile.gfx_ack_window = static_cast<uint32_t>(std::clamp(ack_window, 0, 16));
+    }
+
+    // Codecs section
+    if (ImGui::CollapsingHeader("Codecs")) {
+        ImGui::Checkbox("Auto (best for this client)", &profile.codec_auto);
+        if (profile.codec_auto) ImGui::BeginDisabled();
+        ImGui::Checkbox("RemoteFX", &profile.codec_remotefx);
+        ImGui::Checkbox("GFX Progressive", &profile.codec_progressive);
+        ImGui::Checkbox("H.264 AVC420", &profile.codec_avc420);
+        ImGui::Checkbox("H.264 AVC444", &profile.codec_avc444);
+        ImGui::Checkbox("Planar", &profile.codec_planar);
+        ImGui::Checkbox("NSCodec", &profile.codec_nscodec);
+        if (profile.codec_auto) ImGui::EndDisabled();
     }
 
     // Security section
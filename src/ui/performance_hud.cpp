@@ -0,0 +1,99 @@
+#include "ui/performance_hud.hpp"
+
+#include <imgui.h>
+
+#include <algorithm>
+
+namespace gvrdp {
+
+static uint64_t total_bytes(const CodecStats* codec_stats) {
+    if (!codec_stats) return 0;
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < static_cast<size_t>(Codec::Count); i++) {
+        bytes += codec_stats->totals(static_cast<Codec>(i)).bytes;
+    }
+    return bytes;
+}
+
+void PerformanceHud::roll(const FrameStats& stats, const CodecStats* codec_stats,
+                          Clock::time_point now) {
+    Snapshot current;
+    current.time = now;
+    for (size_t i = 0; i < kStages; i++) {
+        current.stages[i] = stats.stage(static_cast<FrameStage>(i));
+    }
+    current.frames = stats.frames();
+    current.dropped = stats.dropped();
+    current.dirty_pixels = stats.dirty_pixels();
+    current.desktop_pixels = stats.desktop_pixels();
+    current.bytes = total_bytes(codec_stats);
+
+    if (has_last_) {
+        double seconds = std::chrono::duration<double>(now - last_.time).count();
+        for (size_t i = 0; i < kStages; i++) {
+            window_[i] = current.stages[i].since(last_.stages[i]);
+        }
+        fps_ = static_cast<double>(current.frames - last_.frames) / seconds;
+        kib_per_second_ =
+            static_cast<double>(current.bytes - std::min(current.bytes, last_.bytes)) / 1024.0 /
+            seconds;
+        uint64_t desktop = current.desktop_pixels - last_.desktop_pixels;
+        dirty_ratio_ = desktop > 0 ? static_cast<double>(current.dirty_pixels -
+                                                         last_.dirty_pixels) /
+                                         static_cast<double>(desktop)
+                                   : 0.0;
+        dropped_ = current.dropped - last_.dropped;
+    }
+    last_ = current;
+    has_last_ = true;
+}
+
+void PerformanceHud::reset() {
+    has_last_ = false;
+    for (auto& histogram : window_) histogram.reset();
+    fps_ = 0.0;
+    kib_per_second_ = 0.0;
+    dirty_ratio_ = 0.0;
+    dropped_ = 0;
+}
+
+void PerformanceHud::draw(const FrameStats& stats, const CodecStats* codec_stats) {
+    auto now = Clock::now();
+    if (!has_last_ || now - last_.time >= kWindow) {
+        roll(stats, codec_stats, now);
+    }
+
+    ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_Always);
+    ImGui::SetNextWindowBgAlpha(0.6f);
+    ImGui::Begin("Performance", nullptr,
+                 ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+                     ImGuiWindowFlags_NoInputs | ImGuiWindowFlags_NoSavedSettings |
+                     ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav);
+
+    ImGui::Text("%.1f fps   %.0f KiB/s   %.1f%% dirty", fps_, kib_per_second_,
+                dirty_ratio_ * 100.0);
+    ImGui::Text("Dropped: %llu/s (%llu total)", static_cast<unsigned long long>(dropped_),
+                static_cast<unsigned long long>(stats.dropped()));
+
+    if (ImGui::BeginTable("stages", 3, ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Stage");
+        ImGui::TableSetupColumn("p50 ms");
+        ImGui::TableSetupColumn("p99 ms");
+        ImGui::TableHeadersRow();
+        for (size_t i = 0; i < kStages; i++) {
+            const LatencyHistogram& histogram = window_[i];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(frame_stage_name(static_cast<FrameStage>(i)));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", histogram.percentile(0.5).count() / 1000.0);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", histogram.percentile(0.99).count() / 1000.0);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+}  // namespace gvrdp
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "core/codec_stats.hpp"
+#include "core/frame_stats.hpp"
+#include "util/histogram.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace gvrdp {
+
+// Corner panel with the session's frame rate, per-stage latency (p50/p99),
+// bitmap bandwidth, dirty-pixel ratio and dropped frames. Figures cover the
+// last second, so they follow what the user is looking at right now.
+// Drawn over the desktop and never takes input.
+class PerformanceHud {
+public:
+    // codec_stats may be null (no bandwidth then)
+    void draw(const FrameStats& stats, const CodecStats* codec_stats);
+
+    // Forget the previous session's figures
+    void reset();
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr auto kWindow = std::chrono::seconds(1);
+    static constexpr size_t kStages = static_cast<size_t>(FrameStage::Count);
+
+    struct Snapshot {
+        Clock::time_point time;
+        std::array<LatencyHistogram, kStages> stages;
+        uint64_t frames = 0;
+        uint64_t dropped = 0;
+        uint64_t dirty_pixels = 0;
+        uint64_t desktop_pixels = 0;
+        uint64_t bytes = 0;
+    };
+
+    void roll(const FrameStats& stats, const CodecStats* codec_stats, Clock::time_point now);
+
+    Snapshot last_;  // Counters at the start of the current window
+    bool has_last_ = false;
+
+    // Figures of the last completed window
+    std::array<LatencyHistogram, kStages> window_;
+    double fps_ = 0.0;
+    double kib_per_second_ = 0.0;
+    double dirty_ratio_ = 0.0;
+    uint64_t dropped_ = 0;
+};
+
+}  // namespace gvrdp
@@ -1,10 +1,49 @@
 #include "ui/settings_dialog.hpp"
 
+#include "util/tracer.hpp"
+
 #include <imgui.h>
 
+#include <chrono>
+
 namespace gvrdp {
 
-void draw_settings_dialog(ConnectionProfile& profile,
+static void draw_codec_stats(const CodecStats& stats) {
+    if (!ImGui::BeginTable("codec_stats", 5,
+                           ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+        return;
+    }
+    ImGui::TableSetupColumn("Codec");
+    ImGui::TableSetupColumn("Commands");
+    ImGui::TableSetupColumn("KiB");
+    ImGui::TableSetupColumn("Decode ms");
+    ImGui::TableSetupColumn("us/KiB");
+    ImGui::TableHeadersRow();
+
+    for (size_t i = 0; i < static_cast<size_t>(Codec::Count); i++) {
+        auto codec = static_cast<Codec>(i);
+        CodecTotals totals = stats.totals(codec);
+        if (totals.commands == 0) continue;
+
+        double kib = static_cast<double>(totals.bytes) / 1024.0;
+        double ms = std::chrono::duration<double, std::milli>(totals.decode_time).count();
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(codec_name(codec));
+        ImGui::TableNextColumn();
+        ImGui::Text("%llu", static_cast<unsigned long long>(totals.commands));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.0f", kib);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", ms);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", kib > 0.0 ? ms * 1000.0 / kib : 0.0);
+    }
+    ImGui::EndTable();
+}
+
+void draw_settings_dialog(ConnectionProfile& profile, const CodecStats* codec_stats,
+                          bool* show_hud, const std::function<void()>& on_record_trace,
                           const std::function<void()>& on_disconnect) {
     ImGuiIO& io = ImGui::GetIO();
 
@@ -30,6 +69,25 @@ void draw_settings_dialog(ConnectionProfile& profile,
         ImGui::Checkbox("Desktop Composition", &profile.enable_desktop_composition);
     }
 
+    // Frame timing panel over the desktop
+    if (show_hud) {
+        ImGui::Checkbox("Performance HUD", show_hud);
+    }
+
+    // Timeline of every thread for chrome://tracing or Perfetto
+    if (on_record_trace) {
+        if (Tracer::enabled()) {
+            ImGui::TextDisabled("Recording trace...");
+        } else if (ImGui::Button("Record trace")) {
+            on_record_trace();
+        }
+    }
+
+    // Decode cost per codec since connect
+    if (codec_stats && ImGui::CollapsingHeader("Codec Statistics")) {
+        draw_codec_stats(*codec_stats);
+    }
+
     ImGui::Spacing();
     ImGui::Separator();
     ImGui::Spacing();
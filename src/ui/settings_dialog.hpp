@@ -1,13 +1,17 @@
 #pragma once
 
 #include "config/connection_profile.hpp"
+#include "core/codec_stats.hpp"
 
 #include <functional>
 
 namespace gvrdp {
 
 // Draw the in-session settings overlay (toggled by Ctrl+Shift+S).
-void draw_settings_dialog(ConnectionProfile& profile,
+// codec_stats and show_hud may be null when no session is running;
+// on_record_trace may be empty.
+void draw_settings_dialog(ConnectionProfile& profile, const CodecStats* codec_stats,
+                          bool* show_hud, const std::function<void()>& on_record_trace,
                           const std::function<void()>& on_disconnect);
 
 }  // namespace gvrdp
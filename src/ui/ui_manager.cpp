@@ -5,6 +5,7 @@
 #include "ui/profile_manager_dialog.hpp"
 #include "ui/settings_dialog.hpp"
 #include "util/logger.hpp"
+#include "util/tracer.hpp"
 
 #include <imgui.h>
 #include <imgui_impl_sdl2.h>
@@ -61,6 +62,10 @@ void UiManager::shutdown() {
 
 bool UiManager::process_event(const SDL_Event& event) {
     if (!imgui_initialized_) return false;
+
+    // No ImGui frames run while only the desktop is shown, so don't let
+    // events pile up in ImGui's input queue
+    if (!needs_render()) return false;
     ImGui_ImplSDL2_ProcessEvent(&event);
 
     ImGuiIO& io = ImGui::GetIO();
@@ -79,6 +84,7 @@ bool UiManager::process_event(const SDL_Event& event) {
 
 void UiManager::render(SdlRenderer& renderer) {
     if (!imgui_initialized_) return;
+    TRACE_SCOPE("ui_render");
 
     ImGui_ImplSDLRenderer2_NewFrame();
     ImGui_ImplSDL2_NewFrame();
@@ -108,11 +114,13 @@ void UiManager::render(SdlRenderer& renderer) {
         }
 
         case UiState::Connected:
-            // No UI overlay — desktop only
+            // No UI overlay — desktop only, plus the HUD if enabled
             break;
 
         case UiState::OverlayVisible:
-            draw_settings_dialog(current_profile_, on_disconnect_);
+            draw_settings_dialog(current_profile_, codec_stats_,
+                                 frame_stats_ ? &hud_visible_ : nullptr, on_trace_,
+                                 on_disconnect_);
             break;
 
         case UiState::ErrorDialog: {
@@ -133,6 +141,10 @@ void UiManager::render(SdlRenderer& renderer) {
         }
     }
 
+    if (hud_shown()) {
+        hud_.draw(*frame_stats_, codec_stats_);
+    }
+
     ImGui::Render();
     ImGui_ImplSDLRenderer2_RenderDrawData(ImGui::GetDrawData(), renderer.renderer());
 }
@@ -148,6 +160,7 @@ void UiManager::show_error(const std::string& message) {
 
 void UiManager::set_connecting() {
     state_ = UiState::Connecting;
+    hud_.reset();
 }
 
 void UiManager::set_connected() {
@@ -158,10 +171,16 @@ void UiManager::set_disconnected() {
     state_ = UiState::ConnectionDialog;
 }
 
+bool UiManager::is_overlay_toggle(const SDL_Event& event) {
+    return event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_s &&
+           (event.key.keysym.mod & KMOD_CTRL) && (event.key.keysym.mod & KMOD_SHIFT);
+}
+
 bool UiManager::check_overlay_toggle(const SDL_Event& event) {
-    if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_s &&
-        (event.key.keysym.mod & KMOD_CTRL) && (event.key.keysym.mod & KMOD_SHIFT)) {
+    if (is_overlay_toggle(event)) {
         if (state_ == UiState::Connected) {
+            // ImGui saw no input while hidden; drop any stale key state
+            if (imgui_initialized_) ImGui::GetIO().ClearInputKeys();
             state_ = UiState::OverlayVisible;
             return true;
         } else if (state_ == UiState::OverlayVisible) {
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "config/connection_profile.hpp"
+#include "core/codec_stats.hpp"
+#include "core/frame_stats.hpp"
 #include "core/rdp_error.hpp"
+#include "ui/performance_hud.hpp"
 
 #include <SDL2/SDL.h>
 
@@ -25,6 +28,7 @@ class UiManager {
 public:
     using ConnectCallback = std::function<void(const ConnectionProfile&)>;
     using DisconnectCallback = std::function<void()>;
+    using TraceCallback = std::function<void()>;
 
     UiManager();
     ~UiManager();
@@ -38,6 +42,14 @@ public:
     // Render the current UI state
     void render(SdlRenderer& renderer);
 
+    // Whether the current state draws any ImGui content. When false the main
+    // loop skips ImGui frames entirely and only presents the desktop.
+    bool needs_render() const { return state_ != UiState::Connected || hud_shown(); }
+
+    // Whether ImGui may take keyboard and mouse input. The performance HUD
+    // is drawn over the desktop but never does.
+    bool captures_input() const { return state_ != UiState::Connected; }
+
     // State transitions
     void set_state(UiState state);
     UiState state() const { return state_; }
@@ -48,21 +60,41 @@ public:
 
     // Hotkey check (Ctrl+Shift+S for overlay toggle)
     bool check_overlay_toggle(const SDL_Event& event);
+    static bool is_overlay_toggle(const SDL_Event& event);
 
     // Callbacks
     void set_connect_callback(ConnectCallback cb) { on_connect_ = std::move(cb); }
     void set_disconnect_callback(DisconnectCallback cb) { on_disconnect_ = std::move(cb); }
+    // Offered in the overlay as "Record trace"; see Tracer
+    void set_trace_callback(TraceCallback cb) { on_trace_ = std::move(cb); }
+
+    // Decode statistics shown in the overlay (owned by the session; null when none)
+    void set_codec_stats(const CodecStats* stats) { codec_stats_ = stats; }
+
+    // Frame timing for the performance HUD (owned by the main loop; null when
+    // no session is running). The HUD is toggled in the overlay.
+    void set_frame_stats(const FrameStats* stats) { frame_stats_ = stats; }
 
     // Profile access
     ConnectionProfile& current_profile() { return current_profile_; }
     const ConnectionProfile& current_profile() const { return current_profile_; }
 
 private:
+    bool hud_shown() const {
+        return hud_visible_ && frame_stats_ &&
+               (state_ == UiState::Connected || state_ == UiState::OverlayVisible);
+    }
+
     UiState state_ = UiState::ConnectionDialog;
     ConnectionProfile current_profile_;
     std::string error_message_;
     ConnectCallback on_connect_;
     DisconnectCallback on_disconnect_;
+    TraceCallback on_trace_;
+    const CodecStats* codec_stats_ = nullptr;
+    const FrameStats* frame_stats_ = nullptr;
+    PerformanceHud hud_;
+    bool hud_visible_ = false;
     bool imgui_initialized_ = false;
 };
 
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "util/spsc_ring.hpp"
+
+#include <cstddef>
+#include <deque>
+#include <optional>
+
+namespace gvrdp {
+
+// An SpscRing whose producer never waits. Items that find the ring full
+// are kept in a backlog owned by the producer thread, in order, and move
+// into the ring on the next push() or flush() once the consumer has made
+// room. While a backlog exists every new item joins it, so the consumer
+// sees items in the order they were pushed. Past MaxBacklog items the
+// backlog is full and push() drops the item.
+//
+// push_latest() is for items a newer one supersedes (pointer moves): while
+// they cannot go straight into the ring, only the newest is kept, at the
+// backlog's tail, and it is still delivered once there is room.
+template <typename T, size_t Capacity, size_t MaxBacklog = Capacity * 4>
+class BacklogRing {
+public:
+    enum class Push { Queued, Backlogged, Dropped };
+
+    // Producer
+    Push push(const T& item) {
+        flush();
+        if (backlog_.empty() && ring_.push(item)) return Push::Queued;
+        if (backlog_.size() >= MaxBacklog) return Push::Dropped;
+        backlog_.push_back(item);
+        latest_at_tail_ = false;
+        return Push::Backlogged;
+    }
+
+    // Producer: like push(), but an item that has to wait replaces the
+    // previous push_latest() item if that is still the backlog's last one
+    Push push_latest(const T& item) {
+        flush();
+        if (backlog_.empty() && ring_.push(item)) return Push::Queued;
+        if (latest_at_tail_) {
+            backlog_.back() = item;
+            return Push::Backlogged;
+        }
+        if (backlog_.size() >= MaxBacklog) return Push::Dropped;
+        backlog_.push_back(item);
+        latest_at_tail_ = true;
+        return Push::Backlogged;
+    }
+
+    // Producer: moves what fits from the backlog into the ring; true if
+    // the backlog is now empty
+    bool flush() {
+        while (!backlog_.empty() && ring_.push(backlog_.front())) {
+            backlog_.pop_front();
+        }
+        if (backlog_.empty()) latest_at_tail_ = false;
+        return backlog_.empty();
+    }
+
+    // Producer
+    size_t backlog() const { return backlog_.size(); }
+
+    // Consumer: next item, or nullopt if the ring is empty
+    std::optional<T> pop() { return ring_.pop(); }
+
+    // Empties ring and backlog; only while the consumer is not running
+    void clear() {
+        while (ring_.pop()) {
+        }
+        backlog_.clear();
+        latest_at_tail_ = false;
+    }
+
+private:
+    SpscRing<T, Capacity> ring_;
+    std::deque<T> backlog_;
+    bool latest_at_tail_ = false;  // backlog_.back() came from push_latest()
+};
+
+}  // namespace gvrdp
@@ -0,0 +1,122 @@
+#include "util/damage_region.hpp"
+
+#include <algorithm>
+
+namespace gvrdp {
+
+bool Rect::contains(const Rect& other) const {
+    return other.x >= x && other.y >= y && other.right() <= right() &&
+           other.bottom() <= bottom();
+}
+
+bool Rect::intersects(const Rect& other) const {
+    return x < other.right() && other.x < right() && y < other.bottom() && other.y < bottom();
+}
+
+Rect Rect::united(const Rect& other) const {
+    if (empty()) return other;
+    if (other.empty()) return *this;
+    uint32_t left = std::min(x, other.x);
+    uint32_t top = std::min(y, other.y);
+    return {left, top, std::max(right(), other.right()) - left,
+            std::max(bottom(), other.bottom()) - top};
+}
+
+Rect Rect::intersected(const Rect& other) const {
+    if (!intersects(other)) return {};
+    uint32_t left = std::max(x, other.x);
+    uint32_t top = std::max(y, other.y);
+    return {left, top, std::min(right(), other.right()) - left,
+            std::min(bottom(), other.bottom()) - top};
+}
+
+std::vector<Rect> Rect::subtracted(const Rect& other) const {
+    if (empty()) return {};
+    Rect overlap = intersected(other);
+    if (overlap.empty()) return {*this};
+
+    // Full-width bands above and below, then the sides of the overlap row
+    std::vector<Rect> parts;
+    if (overlap.y > y) parts.push_back({x, y, width, overlap.y - y});
+    if (overlap.bottom() < bottom()) {
+        parts.push_back({x, overlap.bottom(), width, bottom() - overlap.bottom()});
+    }
+    if (overlap.x > x) parts.push_back({x, overlap.y, overlap.x - x, overlap.height});
+    if (overlap.right() < right()) {
+        parts.push_back({overlap.right(), overlap.y, right() - overlap.right(), overlap.height});
+    }
+    return parts;
+}
+
+// Overlapping or sharing an edge: merging these never adds uncovered area
+// beyond the gap-free bounding box of the pair.
+static bool should_merge(const Rect& a, const Rect& b) {
+    bool h_overlap = a.x < b.right() && b.x < a.right();
+    bool v_overlap = a.y < b.bottom() && b.y < a.bottom();
+    bool h_touch = a.x <= b.right() && b.x <= a.right();
+    bool v_touch = a.y <= b.bottom() && b.y <= a.bottom();
+    return (h_overlap && v_touch) || (v_overlap && h_touch);
+}
+
+void DamageRegion::add(const Rect& rect) {
+    if (rect.empty()) return;
+
+    Rect merged = rect;
+    // Absorb every rectangle the new one touches; repeat because the grown
+    // rectangle may now reach rectangles it did not touch before.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto it = rects_.begin(); it != rects_.end(); ++it) {
+            if (should_merge(*it, merged)) {
+                merged = merged.united(*it);
+                rects_.erase(it);
+                changed = true;
+                break;
+            }
+        }
+    }
+    rects_.push_back(merged);
+
+    if (rects_.size() > kMaxRects) {
+        Rect all = bounds();
+        rects_.clear();
+        rects_.push_back(all);
+    }
+}
+
+void DamageRegion::add(const DamageRegion& other) {
+    for (const auto& rect : other.rects_) {
+        add(rect);
+    }
+}
+
+void DamageRegion::clip(uint32_t width, uint32_t height) {
+    for (auto& rect : rects_) {
+        if (rect.x >= width || rect.y >= height) {
+            rect.width = 0;
+            continue;
+        }
+        rect.width = std::min(rect.width, width - rect.x);
+        rect.height = std::min(rect.height, height - rect.y);
+    }
+    std::erase_if(rects_, [](const Rect& rect) { return rect.empty(); });
+}
+
+Rect DamageRegion::bounds() const {
+    Rect result;
+    for (const auto& rect : rects_) {
+        result = result.united(rect);
+    }
+    return result;
+}
+
+uint64_t DamageRegion::area() const {
+    uint64_t total = 0;
+    for (const auto& rect : rects_) {
+        total += rect.area();
+    }
+    return total;
+}
+
+}  // namespace gvrdp
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gvrdp {
+
+// Axis-aligned rectangle in desktop pixel coordinates.
+struct Rect {
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    bool empty() const { return width == 0 || height == 0; }
+    uint64_t area() const { return static_cast<uint64_t>(width) * height; }
+    uint32_t right() const { return x + width; }
+    uint32_t bottom() const { return y + height; }
+
+    bool contains(const Rect& other) const;
+    bool intersects(const Rect& other) const;
+    Rect united(const Rect& other) const;
+    Rect intersected(const Rect& other) const;
+    // The parts of this rectangle outside `other`: at most four disjoint bands
+    std::vector<Rect> subtracted(const Rect& other) const;
+
+    bool operator==(const Rect& other) const = default;
+};
+
+// Accumulates damaged (invalidated) rectangles between texture uploads.
+// Rectangles that overlap or touch are merged. Once the list grows past
+// kMaxRects it collapses into the bounding box, so the upload cost stays
+// bounded even for pathological invalidation patterns.
+class DamageRegion {
+public:
+    static constexpr size_t kMaxRects = 32;
+
+    void add(const Rect& rect);
+    void add(const DamageRegion& other);
+    void clear() { rects_.clear(); }
+
+    // Clip all rectangles to a width x height surface, dropping empty results.
+    void clip(uint32_t width, uint32_t height);
+
+    bool empty() const { return rects_.empty(); }
+    const std::vector<Rect>& rects() const { return rects_; }
+    Rect bounds() const;
+
+    // Sum of rectangle areas (rectangles never overlap after merging).
+    uint64_t area() const;
+
+private:
+    std::vector<Rect> rects_;
+};
+
+}  // namespace gvrdp
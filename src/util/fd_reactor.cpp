@@ -0,0 +1,65 @@
+#include "util/fd_reactor.hpp"
+
+#if GVRDP_LINUX
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+
+namespace gvrdp {
+
+FdReactor::FdReactor() : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)) {}
+
+FdReactor::~FdReactor() {
+    if (epoll_fd_ >= 0) ::close(epoll_fd_);
+}
+
+bool FdReactor::set_fds(const std::vector<int>& fds) {
+    if (epoll_fd_ < 0) return false;
+
+    for (int fd : fds_) {
+        if (std::find(fds.begin(), fds.end(), fd) != fds.end()) continue;
+        // Fails harmlessly if the descriptor was closed, which removes it
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        rearm_count_++;
+    }
+    fds_.clear();
+    for (int fd : fds) {
+        if (std::find(fds_.begin(), fds_.end(), fd) != fds_.end()) continue;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        // A registered descriptor is left as it is. ENOENT means it is new,
+        // or was closed and its number reused since the last call.
+        int result = epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event);
+        if (result != 0 && errno == ENOENT) {
+            result = epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+            rearm_count_++;
+        }
+        if (result != 0) {
+            // Start over with an empty set
+            ::close(epoll_fd_);
+            epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+            fds_.clear();
+            return false;
+        }
+        fds_.push_back(fd);
+    }
+    return true;
+}
+
+int FdReactor::wait(int timeout_ms) {
+    if (epoll_fd_ < 0) return -1;
+    // Only readiness matters; the caller services every source afterwards
+    std::array<epoll_event, 16> events;
+    int ready = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), timeout_ms);
+    if (ready < 0) return errno == EINTR ? 0 : -1;
+    return ready;
+}
+
+}  // namespace gvrdp
+
+#endif  // GVRDP_LINUX
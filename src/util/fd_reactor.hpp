@@ -0,0 +1,49 @@
+#pragma once
+
+#include "util/platform.hpp"
+
+#if GVRDP_LINUX
+
+#include <cstddef>
+#include <vector>
+
+namespace gvrdp {
+
+// Level-triggered epoll set for a thread that waits on a slowly changing
+// group of file descriptors. set_fds() is cheap when the group is the same
+// as last time: descriptors are only added to or removed from epoll when
+// it changes. Linux only; other platforms wait with WinPR.
+class FdReactor {
+public:
+    FdReactor();
+    ~FdReactor();
+
+    FdReactor(const FdReactor&) = delete;
+    FdReactor& operator=(const FdReactor&) = delete;
+
+    bool valid() const { return epoll_fd_ >= 0; }
+
+    // Makes `fds` the watched set (readable). Every descriptor is checked
+    // with EPOLL_CTL_MOD and re-added if epoll no longer knows it: closing
+    // a descriptor unregisters it, and its number may come back as a new
+    // one. Returns false if epoll refused a descriptor; the set is then
+    // left empty.
+    bool set_fds(const std::vector<int>& fds);
+
+    // Blocks until a watched descriptor is readable or timeout_ms passes
+    // (-1 = no timeout). Returns the number of ready descriptors, 0 on
+    // timeout or signal, -1 on error.
+    int wait(int timeout_ms);
+
+    // Descriptors added to or removed from epoll by set_fds() so far
+    size_t rearm_count() const { return rearm_count_; }
+
+private:
+    int epoll_fd_ = -1;
+    std::vector<int> fds_;
+    size_t rearm_count_ = 0;
+};
+
+}  // namespace gvrdp
+
+#endif  // GVRDP_LINUX
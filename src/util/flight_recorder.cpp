@@ -0,0 +1,294 @@
+#include "util/flight_recorder.hpp"
+
+#include "util/platform.hpp"
+
+#if GVRDP_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace gvrdp {
+
+// ── File format ───────────────────────────────────────────────────────
+//
+//   FileHeader | FlightRecord[capacity]
+//
+// Record i lives in slot (sequence - 1) % capacity. Native byte order: the
+// decoder runs on the machine (or architecture) that wrote the file.
+
+namespace {
+
+constexpr char kMagic[8] = {'G', 'V', 'R', 'D', 'P', 'F', 'R', '\0'};
+constexpr uint32_t kVersion = 1;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;
+    int64_t started_unix_ns;
+    uint32_t closed;
+    uint32_t reserved;
+    uint64_t write_index;  // Records ever claimed; updated atomically
+    uint8_t padding[16];
+};
+static_assert(sizeof(FileHeader) == 64);
+
+thread_local uint16_t t_thread = 0;
+std::atomic<uint16_t> g_next_thread{0};
+
+uint16_t thread_number() {
+    if (t_thread == 0) t_thread = ++g_next_thread;
+    return t_thread;
+}
+
+FILE* open_file(const std::filesystem::path& path, bool write) {
+#if GVRDP_WINDOWS
+    return _wfopen(path.c_str(), write ? L"wb" : L"rb");
+#else
+    return std::fopen(path.c_str(), write ? "wb" : "rb");
+#endif
+}
+
+}  // namespace
+
+const char* flight_event_name(FlightEvent event) {
+    switch (event) {
+        case FlightEvent::None: return "none";
+        case FlightEvent::SessionStart: return "session_start";
+        case FlightEvent::Connected: return "connected";
+        case FlightEvent::Disconnected: return "disconnected";
+        case FlightEvent::Error: return "error";
+        case FlightEvent::RdpWake: return "rdp_wake";
+        case FlightEvent::FrameReady: return "frame_ready";
+        case FlightEvent::GfxFrame: return "gfx_frame";
+        case FlightEvent::Present: return "present";
+        case FlightEvent::InputSent: return "input_sent";
+        case FlightEvent::ChannelConnected: return "channel_connected";
+        case FlightEvent::ChannelDisconnected: return "channel_disconnected";
+        case FlightEvent::ResizeRequest: return "resize_request";
+        case FlightEvent::Dump: return "dump";
+        case FlightEvent::Count: break;
+    }
+    return "unknown";
+}
+
+// ── Shared mapping ────────────────────────────────────────────────────
+
+struct FlightRecorder::State {
+    FileHeader* header = nullptr;
+    FlightRecord* records = nullptr;
+    uint64_t mask = 0;
+    std::chrono::steady_clock::time_point opened;
+    size_t size = 0;
+#if GVRDP_WINDOWS
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+};
+
+std::atomic<FlightRecorder::State*> FlightRecorder::state_{nullptr};
+
+bool FlightRecorder::open(const std::filesystem::path& path, size_t capacity) {
+    close();
+    if (capacity == 0) return false;
+    capacity = std::bit_ceil(capacity);
+
+    std::error_code ec;
+    if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path(), ec);
+
+    auto state = std::make_unique<State>();
+    state->size = sizeof(FileHeader) + capacity * sizeof(FlightRecord);
+    void* view = nullptr;
+#if GVRDP_WINDOWS
+    state->file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                              nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (state->file == INVALID_HANDLE_VALUE) return false;
+    ULARGE_INTEGER size{};
+    size.QuadPart = state->size;
+    state->mapping = CreateFileMappingW(state->file, nullptr, PAGE_READWRITE, size.HighPart,
+                                        size.LowPart, nullptr);
+    if (state->mapping) view = MapViewOfFile(state->mapping, FILE_MAP_WRITE, 0, 0, 0);
+    if (!view) {
+        if (state->mapping) CloseHandle(state->mapping);
+        CloseHandle(state->file);
+        return false;
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    if (ftruncate(fd, static_cast<off_t>(state->size)) != 0) {
+        ::close(fd);
+        return false;
+    }
+    view = mmap(nullptr, state->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) return false;
+#endif
+
+    // A fresh file reads as zeros: every slot is empty
+    state->header = static_cast<FileHeader*>(view);
+    state->records = reinterpret_cast<FlightRecord*>(state->header + 1);
+    state->mask = capacity - 1;
+    state->opened = std::chrono::steady_clock::now();
+
+    FileHeader& header = *state->header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.record_size = sizeof(FlightRecord);
+    header.capacity = capacity;
+    header.started_unix_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::system_clock::now().time_since_epoch())
+                                 .count();
+    header.closed = 0;
+
+    state_.store(state.release(), std::memory_order_release);
+    return true;
+}
+
+void FlightRecorder::close() {
+    State* state = state_.exchange(nullptr, std::memory_order_acq_rel);
+    if (!state) return;
+
+    state->header->closed = 1;
+#if GVRDP_WINDOWS
+    FlushViewOfFile(state->header, 0);
+    UnmapViewOfFile(state->header);
+    CloseHandle(state->mapping);
+    CloseHandle(state->file);
+#else
+    munmap(state->header, state->size);
+#endif
+    delete state;
+}
+
+void FlightRecorder::record(FlightEvent type, uint32_t a, uint64_t b) {
+    State* state = state_.load(std::memory_order_acquire);
+    if (!state) return;
+
+    uint64_t index =
+        std::atomic_ref(state->header->write_index).fetch_add(1, std::memory_order_relaxed);
+    FlightRecord& slot = state->records[index & state->mask];
+
+    // Sequence last: a reader that sees it sees the fields it covers.
+    // Clearing it first marks the slot as being rewritten.
+    std::atomic_ref sequence(slot.sequence);
+    sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - state->opened)
+                       .count();
+    slot.type = static_cast<uint16_t>(type);
+    slot.thread = thread_number();
+    slot.a = a;
+    slot.b = b;
+    sequence.store(index + 1, std::memory_order_release);
+}
+
+bool FlightRecorder::dump(const std::filesystem::path& path, DumpReason reason) {
+    State* state = state_.load(std::memory_order_acquire);
+    if (!state) return false;
+    record(FlightEvent::Dump, static_cast<uint32_t>(reason));
+
+    // Copy slot by slot, dropping any that changed while being copied
+    uint64_t capacity = state->mask + 1;
+    std::vector<FlightRecord> records(capacity);
+    for (uint64_t i = 0; i < capacity; i++) {
+        FlightRecord& slot = state->records[i];
+        std::atomic_ref sequence(slot.sequence);
+        uint64_t before = sequence.load(std::memory_order_acquire);
+        if (before == 0) continue;
+        FlightRecord copy = slot;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) != before) continue;
+        copy.sequence = before;
+        records[i] = copy;
+    }
+
+    FileHeader header = *state->header;
+    header.write_index =
+        std::atomic_ref(state->header->write_index).load(std::memory_order_relaxed);
+    header.closed = 1;
+
+    std::error_code ec;
+    if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path(), ec);
+    FILE* file = open_file(path, true);
+    if (!file) return false;
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(records.data(), sizeof(FlightRecord), records.size(), file) ==
+                  records.size();
+    ok = std::fclose(file) == 0 && ok;
+    return ok;
+}
+
+bool FlightRecorder::left_open(const std::filesystem::path& path) {
+    FILE* file = open_file(path, false);
+    if (!file) return false;
+    FileHeader header{};
+    bool read = std::fread(&header, sizeof(header), 1, file) == 1;
+    std::fclose(file);
+    return read && std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && !header.closed;
+}
+
+std::optional<FlightRecorder::Recording> FlightRecorder::read(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return std::nullopt;
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), {});
+
+    FileHeader header{};
+    if (data.size() < sizeof(header)) return std::nullopt;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+        header.record_size != sizeof(FlightRecord) || header.capacity == 0 ||
+        (header.capacity & (header.capacity - 1)) != 0 ||
+        header.capacity > (data.size() - sizeof(header)) / sizeof(FlightRecord)) {
+        return std::nullopt;
+    }
+
+    Recording recording;
+    recording.started_unix_ns = header.started_unix_ns;
+    recording.closed = header.closed != 0;
+    recording.capacity = header.capacity;
+    for (uint64_t i = 0; i < header.capacity; i++) {
+        FlightRecord record;
+        std::memcpy(&record, data.data() + sizeof(header) + i * sizeof(FlightRecord),
+                    sizeof(record));
+        // Empty, or torn by a crash mid-write
+        if (record.sequence == 0 || ((record.sequence - 1) & (header.capacity - 1)) != i) {
+            continue;
+        }
+        recording.records.push_back(record);
+    }
+    std::sort(recording.records.begin(), recording.records.end(),
+              [](const FlightRecord& x, const FlightRecord& y) { return x.sequence < y.sequence; });
+    return recording;
+}
+
+uint64_t FlightRecorder::pack_name(const char* name) {
+    uint64_t packed = 0;
+    for (int i = 0; name && i < 8 && name[i]; i++) {
+        packed |= static_cast<uint64_t>(static_cast<unsigned char>(name[i])) << (8 * i);
+    }
+    return packed;
+}
+
+std::string FlightRecorder::unpack_name(uint64_t packed) {
+    std::string name;
+    for (; packed != 0; packed >>= 8) {
+        name += static_cast<char>(packed & 0xFF);
+    }
+    return name;
+}
+
+}  // namespace gvrdp
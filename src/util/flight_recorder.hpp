@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace gvrdp {
+
+enum class FlightEvent : uint16_t {
+    None = 0,
+    SessionStart,         // a = port
+    Connected,
+    Disconnected,         // a = 1 if requested locally, b = FreeRDP error code
+    Error,                // a = RdpError, b = FreeRDP error code
+    RdpWake,              // a = time the RDP thread waited, µs
+    FrameReady,           // b = damaged pixels
+    GfxFrame,             // a = frame id, b = decode time, µs
+    Present,              // a = time present() took, µs; b = µs since the previous one
+    InputSent,            // a = InputEvent::Type, b = code << 32 | flags
+    ChannelConnected,     // b = channel name, see pack_name()
+    ChannelDisconnected,  // b = channel name
+    ResizeRequest,        // a = width, b = height
+    Dump,                 // Written just before a dump; a = DumpReason
+    Count
+};
+
+const char* flight_event_name(FlightEvent event);
+
+enum class DumpReason : uint32_t { Error = 1, Disconnect };
+
+// One fixed-size entry in the ring (and in the file)
+struct FlightRecord {
+    uint64_t sequence = 0;  // 1-based position in the stream; 0 = never written
+    int64_t time_ns = 0;    // Since the recorder was opened
+    uint16_t type = 0;      // FlightEvent
+    uint16_t thread = 0;    // Small per-thread number, in order of first use
+    uint32_t a = 0;
+    uint64_t b = 0;
+};
+static_assert(sizeof(FlightRecord) == 32);
+
+// Always-on black box: the most recent events of every thread, kept in a
+// memory-mapped file so they outlive the process.
+//
+// record() claims a slot with one atomic increment and fills it in place:
+// no lock, no allocation, no system call. The ring wraps, so it holds the
+// last `capacity` events. The mapping is shared with the file, so after a
+// crash the kernel still has the pages; the next start finds the file not
+// marked closed and keeps it (see left_open()). dump() copies the live ring
+// to its own file for errors the process survives.
+//
+// Decode a file with the gvrdp_flight tool, or read().
+class FlightRecorder {
+public:
+    // Creates (replacing) the ring file. `capacity` is rounded up to a power
+    // of two. record() is a no-op until this succeeds.
+    static bool open(const std::filesystem::path& path, size_t capacity);
+
+    // Marks the file closed and unmaps it. No other thread may still record.
+    static void close();
+
+    static bool active() { return state_.load(std::memory_order_acquire) != nullptr; }
+
+    static void record(FlightEvent type, uint32_t a = 0, uint64_t b = 0);
+
+    // Writes the events currently in the ring to `path`, in the same format
+    static bool dump(const std::filesystem::path& path, DumpReason reason);
+
+    // Whether `path` is a ring file that was never closed, i.e. its
+    // process crashed or was killed
+    static bool left_open(const std::filesystem::path& path);
+
+    struct Recording {
+        int64_t started_unix_ns = 0;  // Wall clock at open(), for time_ns
+        bool closed = false;
+        uint64_t capacity = 0;
+        std::vector<FlightRecord> records;  // Oldest first
+    };
+
+    // Reads a ring or dump file; nullopt if it is not one
+    static std::optional<Recording> read(const std::filesystem::path& path);
+
+    // Up to 8 characters of a name in one record field
+    static uint64_t pack_name(const char* name);
+    static std::string unpack_name(uint64_t packed);
+
+private:
+    struct State;
+
+    static std::atomic<State*> state_;
+};
+
+}  // namespace gvrdp
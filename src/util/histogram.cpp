@@ -0,0 +1,63 @@
+#include "util/histogram.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace gvrdp {
+
+size_t LatencyHistogram::bucket_of(uint64_t us) {
+    if (us < kSubBuckets) return static_cast<size_t>(us);
+    // Top four significant bits: the power of two, then which eighth of it
+    int shift = static_cast<int>(std::bit_width(us)) - 4;
+    size_t sub = static_cast<size_t>(us >> shift) - kSubBuckets;
+    size_t bucket = static_cast<size_t>(shift + 1) * kSubBuckets + sub;
+    return std::min(bucket, kBuckets - 1);
+}
+
+uint64_t LatencyHistogram::bucket_upper(size_t bucket) {
+    if (bucket < kSubBuckets) return bucket;
+    int shift = static_cast<int>(bucket / kSubBuckets) - 1;
+    uint64_t sub = bucket % kSubBuckets;
+    return ((kSubBuckets + sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::chrono::microseconds value) {
+    auto us = static_cast<uint64_t>(std::max<int64_t>(value.count(), 0));
+    buckets_[bucket_of(us)]++;
+    count_++;
+    max_ = std::max(max_, us);
+}
+
+void LatencyHistogram::reset() {
+    buckets_.fill(0);
+    count_ = 0;
+    max_ = 0;
+}
+
+std::chrono::microseconds LatencyHistogram::percentile(double q) const {
+    if (count_ == 0) return std::chrono::microseconds(0);
+    // Rank of the sample, 1-based
+    auto rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(count_)));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            return std::chrono::microseconds(std::min(bucket_upper(i), max_));
+        }
+    }
+    return std::chrono::microseconds(max_);
+}
+
+LatencyHistogram LatencyHistogram::since(const LatencyHistogram& earlier) const {
+    LatencyHistogram delta;
+    for (size_t i = 0; i < kBuckets; i++) {
+        delta.buckets_[i] = buckets_[i] - std::min(buckets_[i], earlier.buckets_[i]);
+    }
+    delta.count_ = count_ - std::min(count_, earlier.count_);
+    delta.max_ = max_;
+    return delta;
+}
+
+}  // namespace gvrdp
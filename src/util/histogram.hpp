@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace gvrdp {
+
+// Fixed-bucket latency histogram in microseconds. record() is O(1) and
+// nothing allocates, so it can sit on a per-frame path.
+//
+// Buckets are log-linear: exact below 8 us, then 8 buckets per power of two,
+// so a percentile is within 12.5% of the true value. Values above ~2 minutes
+// land in the last bucket. Not thread-safe.
+class LatencyHistogram {
+public:
+    static constexpr size_t kSubBuckets = 8;
+    static constexpr size_t kBuckets = kSubBuckets * 25;
+
+    void record(std::chrono::microseconds value);
+    void reset();
+
+    uint64_t count() const { return count_; }
+    std::chrono::microseconds max() const { return std::chrono::microseconds(max_); }
+
+    // Upper bound of the bucket holding the q-th sample (q in [0, 1]),
+    // or zero when empty
+    std::chrono::microseconds percentile(double q) const;
+
+    // The samples recorded after `earlier`, an older copy of this histogram.
+    // max() of the result is the overall max.
+    LatencyHistogram since(const LatencyHistogram& earlier) const;
+
+    // Bucket mapping, exposed for tests
+    static size_t bucket_of(uint64_t us);
+    static uint64_t bucket_upper(size_t bucket);
+
+private:
+    std::array<uint64_t, kBuckets> buckets_{};
+    uint64_t count_ = 0;
+    uint64_t max_ = 0;
+};
+
+}  // namespace gvrdp
@@ -0,0 +1,303 @@
+#include "util/metrics.hpp"
+
+#include "util/platform.hpp"
+
+#if GVRDP_WINDOWS
+#include <windows.h>
+#include <psapi.h>
+#elif GVRDP_MACOS
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <system_error>
+
+namespace gvrdp {
+
+namespace {
+
+// Label values and help text: Prometheus and JSON escape the same three
+std::string escape(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (char c : text) {
+        if (c == '\\' || c == '"') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+// {k="v",...}, with an optional extra label (histogram buckets' le)
+std::string prometheus_labels(const Metrics::Labels& labels, const std::string& extra = {}) {
+    if (labels.empty() && extra.empty()) return {};
+    std::string out = "{";
+    for (const auto& [key, value] : labels) {
+        if (out.size() > 1) out += ',';
+        out += key + "=\"" + escape(value) + "\"";
+    }
+    if (!extra.empty()) {
+        if (out.size() > 1) out += ',';
+        out += extra;
+    }
+    return out + "}";
+}
+
+// Bucket bounds: shortest form ("0.0005", "1")
+std::string format_bound(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%g", value);
+    return buffer;
+}
+
+// Sums, in seconds with microsecond resolution
+std::string format_seconds(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.6f", value);
+    return buffer;
+}
+
+double seconds(std::chrono::nanoseconds duration) {
+    return std::chrono::duration<double>(duration).count();
+}
+
+// Replaces `path` with `text` via a temporary file, so collectors never
+// read half a file
+bool write_atomically(const std::filesystem::path& path, const std::string& text) {
+    std::filesystem::path tmp = path;
+    tmp += ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        file << text;
+        if (!file.flush()) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+// ── Histogram ─────────────────────────────────────────────────────────
+
+void Histogram::observe(std::chrono::nanoseconds duration) {
+    auto us = static_cast<uint64_t>(
+        std::max<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count(),
+                          0));
+    size_t i = static_cast<size_t>(
+        std::lower_bound(kBoundsUs.begin(), kBoundsUs.end(), us) - kBoundsUs.begin());
+    buckets_[i].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_ns_.fetch_add(duration.count(), std::memory_order_relaxed);
+}
+
+// ── Metrics ───────────────────────────────────────────────────────────
+
+Metrics& Metrics::global() {
+    static Metrics instance;
+    return instance;
+}
+
+Metrics::Entry& Metrics::find_or_add(const std::string& name, const std::string& help,
+                                     const Labels& labels, Type type) {
+    std::lock_guard lock(mutex_);
+    for (Entry& entry : entries_) {
+        if (entry.name == name && entry.labels == labels && entry.type == type) return entry;
+    }
+    Entry& entry = entries_.emplace_back();
+    entry.name = name;
+    entry.help = help;
+    entry.labels = labels;
+    entry.type = type;
+    return entry;
+}
+
+Counter& Metrics::counter(const std::string& name, const std::string& help,
+                          const Labels& labels) {
+    return find_or_add(name, help, labels, Type::Counter).counter;
+}
+
+Gauge& Metrics::gauge(const std::string& name, const std::string& help, const Labels& labels) {
+    return find_or_add(name, help, labels, Type::Gauge).gauge;
+}
+
+Histogram& Metrics::histogram(const std::string& name, const std::string& help,
+                              const Labels& labels) {
+    return find_or_add(name, help, labels, Type::Histogram).histogram;
+}
+
+std::string Metrics::prometheus() const {
+    std::lock_guard lock(mutex_);
+    std::string out;
+    std::vector<const std::string*> families;
+    for (const Entry& entry : entries_) {
+        bool seen = std::any_of(families.begin(), families.end(),
+                                [&](const std::string* name) { return *name == entry.name; });
+        if (!seen) families.push_back(&entry.name);
+    }
+
+    for (const std::string* family : families) {
+        bool header = false;
+        for (const Entry& entry : entries_) {
+            if (entry.name != *family) continue;
+            if (!header) {
+                const char* type = entry.type == Type::Counter ? "counter"
+                                   : entry.type == Type::Gauge ? "gauge"
+                                                               : "histogram";
+                out += "# HELP " + entry.name + " " + escape(entry.help) + "\n";
+                out += "# TYPE " + entry.name + " " + type + "\n";
+                header = true;
+            }
+            switch (entry.type) {
+                case Type::Counter:
+                    out += entry.name + prometheus_labels(entry.labels) + " " +
+                           std::to_string(entry.counter.value()) + "\n";
+                    break;
+                case Type::Gauge:
+                    out += entry.name + prometheus_labels(entry.labels) + " " +
+                           std::to_string(entry.gauge.value()) + "\n";
+                    break;
+                case Type::Histogram: {
+                    const Histogram& h = entry.histogram;
+                    uint64_t cumulative = 0;
+                    for (size_t i = 0; i <= Histogram::kBoundsUs.size(); i++) {
+                        cumulative += h.bucket(i);
+                        std::string le =
+                            i < Histogram::kBoundsUs.size()
+                                ? format_bound(static_cast<double>(Histogram::kBoundsUs[i]) / 1e6)
+                                : "+Inf";
+                        out += entry.name + "_bucket" +
+                               prometheus_labels(entry.labels, "le=\"" + le + "\"") + " " +
+                               std::to_string(cumulative) + "\n";
+                    }
+                    out += entry.name + "_sum" + prometheus_labels(entry.labels) + " " +
+                           format_seconds(seconds(h.sum())) + "\n";
+                    out += entry.name + "_count" + prometheus_labels(entry.labels) + " " +
+                           std::to_string(h.count()) + "\n";
+                    break;
+                }
+            }
+        }
+    }
+    return out;
+}
+
+std::string Metrics::json() const {
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch());
+    std::string out = "{\"timestamp_ms\":" + std::to_string(now.count()) + ",\"metrics\":[";
+
+    std::lock_guard lock(mutex_);
+    bool first = true;
+    for (const Entry& entry : entries_) {
+        if (!first) out += ',';
+        first = false;
+        out += "\n{\"name\":\"" + entry.name + "\",\"labels\":{";
+        for (size_t i = 0; i < entry.labels.size(); i++) {
+            if (i > 0) out += ',';
+            out += "\"" + escape(entry.labels[i].first) + "\":\"" +
+                   escape(entry.labels[i].second) + "\"";
+        }
+        out += "},";
+        switch (entry.type) {
+            case Type::Counter:
+                out += "\"type\":\"counter\",\"value\":" + std::to_string(entry.counter.value());
+                break;
+            case Type::Gauge:
+                out += "\"type\":\"gauge\",\"value\":" + std::to_string(entry.gauge.value());
+                break;
+            case Type::Histogram: {
+                const Histogram& h = entry.histogram;
+                out += "\"type\":\"histogram\",\"count\":" + std::to_string(h.count()) +
+                       ",\"sum_seconds\":" + format_seconds(seconds(h.sum())) +
+                       ",\"buckets_us\":[";
+                for (size_t i = 0; i <= Histogram::kBoundsUs.size(); i++) {
+                    if (i > 0) out += ',';
+                    std::string le = i < Histogram::kBoundsUs.size()
+                                         ? std::to_string(Histogram::kBoundsUs[i])
+                                         : "null";
+                    out += "[" + le + "," + std::to_string(h.bucket(i)) + "]";
+                }
+                out += "]";
+                break;
+            }
+        }
+        out += "}";
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+// ── MetricsWriter ─────────────────────────────────────────────────────
+
+MetricsWriter::MetricsWriter(Metrics& metrics, std::filesystem::path dir,
+                             std::chrono::milliseconds interval)
+    : metrics_(metrics),
+      dir_(std::move(dir)),
+      interval_(std::max(interval, std::chrono::milliseconds(1))),
+      next_(Clock::now() + interval_) {}
+
+bool MetricsWriter::poll(Clock::time_point now) {
+    if (now < next_) return true;
+    next_ = now + interval_;
+    return write();
+}
+
+std::chrono::milliseconds MetricsWriter::time_until_due(Clock::time_point now) const {
+    if (now >= next_) return std::chrono::milliseconds(0);
+    return std::chrono::ceil<std::chrono::milliseconds>(next_ - now);
+}
+
+bool MetricsWriter::write() {
+    metrics_.gauge("gvrdp_resident_memory_bytes", "Resident set size of the process")
+        .set(static_cast<int64_t>(resident_memory_bytes()));
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    bool ok = write_atomically(dir_ / "metrics.json", metrics_.json());
+    return write_atomically(dir_ / "metrics.prom", metrics_.prometheus()) && ok;
+}
+
+// ── Process memory ────────────────────────────────────────────────────
+
+uint64_t resident_memory_bytes() {
+#if GVRDP_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.WorkingSetSize;
+#elif GVRDP_MACOS
+    mach_task_basic_info_data_t info{};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info),
+                  &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.resident_size;
+#else
+    // statm: total and resident size, in pages
+    std::FILE* file = std::fopen("/proc/self/statm", "r");
+    if (!file) return 0;
+    unsigned long long total = 0;
+    unsigned long long resident = 0;
+    int fields = std::fscanf(file, "%llu %llu", &total, &resident);
+    std::fclose(file);
+    if (fields != 2) return 0;
+    return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+}  // namespace gvrdp
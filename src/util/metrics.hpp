@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gvrdp {
+
+// Monotonic count. add() is one relaxed atomic increment.
+class Counter {
+public:
+    void add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+// Current level (bytes in use, RTT, ...)
+class Gauge {
+public:
+    void set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    void add(int64_t delta) { value_.fetch_add(delta, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+// Durations in fixed buckets from 100 µs to 1 s, as Prometheus expects
+// them. observe() is a handful of relaxed atomic increments.
+class Histogram {
+public:
+    static constexpr std::array<uint64_t, 12> kBoundsUs = {
+        100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 1000000};
+
+    void observe(std::chrono::nanoseconds duration);
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    std::chrono::nanoseconds sum() const {
+        return std::chrono::nanoseconds(sum_ns_.load(std::memory_order_relaxed));
+    }
+    // Observations in bucket i (not cumulative); the last one is above 1 s
+    uint64_t bucket(size_t i) const { return buckets_[i].load(std::memory_order_relaxed); }
+
+private:
+    std::array<std::atomic<uint64_t>, kBoundsUs.size() + 1> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<int64_t> sum_ns_{0};
+};
+
+// Named metrics for fleet monitoring. Registration takes a lock and is meant
+// to happen once per call site (keep the returned reference, e.g. in a
+// function-local static); updates through the reference never lock. Metrics
+// live as long as the registry and are never removed.
+class Metrics {
+public:
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    // The process-wide registry the application reports to
+    static Metrics& global();
+
+    // Returns the existing metric if name and labels were registered before
+    Counter& counter(const std::string& name, const std::string& help, const Labels& labels = {});
+    Gauge& gauge(const std::string& name, const std::string& help, const Labels& labels = {});
+    Histogram& histogram(const std::string& name, const std::string& help,
+                         const Labels& labels = {});
+
+    // Prometheus text exposition format (histograms in seconds)
+    std::string prometheus() const;
+    // {"timestamp_ms": ..., "metrics": [{"name", "labels", "type", ...}]}
+    std::string json() const;
+
+private:
+    enum class Type { Counter, Gauge, Histogram };
+
+    struct Entry {
+        std::string name;
+        std::string help;
+        Labels labels;
+        Type type;
+        Counter counter;
+        Gauge gauge;
+        Histogram histogram;
+    };
+
+    Entry& find_or_add(const std::string& name, const std::string& help, const Labels& labels,
+                       Type type);
+
+    mutable std::mutex mutex_;
+    std::deque<Entry> entries_;  // Stable addresses
+};
+
+// Writes metrics.json and metrics.prom (for node_exporter's textfile
+// collector) into a directory every `interval`, replacing the previous pair
+// atomically. Driven by the main loop like ResizeController.
+class MetricsWriter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    MetricsWriter(Metrics& metrics, std::filesystem::path dir, std::chrono::milliseconds interval);
+
+    // Writes if the interval has passed; returns false only on a failed write
+    bool poll(Clock::time_point now);
+    std::chrono::milliseconds time_until_due(Clock::time_point now) const;
+    bool write();
+
+private:
+    Metrics& metrics_;
+    std::filesystem::path dir_;
+    std::chrono::milliseconds interval_;
+    Clock::time_point next_;
+};
+
+// Resident set size of this process, or 0 if unknown
+uint64_t resident_memory_bytes();
+
+}  // namespace gvrdp
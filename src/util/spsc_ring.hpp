@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+
+namespace gvrdp {
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. push() and pop() never block and never allocate. Capacity must be
+// a power of two; one slot is not wasted (indices run freely and wrap).
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>, "Elements are copied between threads");
+
+public:
+    static constexpr size_t capacity() { return Capacity; }
+
+    // Producer: false if the ring is full
+    bool push(const T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ == Capacity) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ == Capacity) return false;
+        }
+        slots_[tail & (Capacity - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: next item, or nullopt if empty
+    std::optional<T> pop() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) return std::nullopt;
+        }
+        T item = slots_[head & (Capacity - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return item;
+    }
+
+    // Approximate when called concurrently with push()/pop()
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+private:
+    // Producer and consumer state on separate cache lines, so the two
+    // threads don't invalidate each other's line on every operation
+    static constexpr size_t kLine = 64;
+
+    alignas(kLine) std::atomic<size_t> tail_{0};
+    size_t head_cache_ = 0;  // Producer's last view of head_
+
+    alignas(kLine) std::atomic<size_t> head_{0};
+    size_t tail_cache_ = 0;  // Consumer's last view of tail_
+
+    alignas(kLine) std::array<T, Capacity> slots_{};
+};
+
+}  // namespace gvrdp
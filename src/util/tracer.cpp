@@ -0,0 +1,208 @@
+#include "util/tracer.hpp"
+
+#include "util/platform.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace gvrdp {
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    Tracer::Clock::time_point start;
+    Tracer::Clock::time_point end;
+};
+
+// One per thread that ever recorded, kept for the life of the process so a
+// thread that exits mid-trace still has its events written
+struct ThreadBuffer {
+    static constexpr size_t kCapacity = 1 << 16;
+
+    uint32_t id = 0;
+    std::atomic<const char*> name{nullptr};
+    // Trace the events belong to. A buffer from an older trace is cleared by
+    // its owner when it next records, so every buffer has a single writer.
+    std::atomic<uint64_t> epoch{0};
+    std::atomic<size_t> count{0};
+    std::atomic<uint64_t> dropped{0};
+    std::array<TraceEvent, kCapacity> events;
+};
+
+struct TraceState {
+    std::mutex mutex;  // Registration, start and stop; never taken per event
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::atomic<uint64_t> epoch{0};
+    std::filesystem::path path;
+    Tracer::Clock::time_point started;
+    Tracer::Clock::time_point deadline;
+    bool running = false;
+};
+
+TraceState& state() {
+    static TraceState instance;
+    return instance;
+}
+
+thread_local const char* t_thread_name = nullptr;
+thread_local ThreadBuffer* t_buffer = nullptr;
+
+// Created on the first event, so threads that never record cost nothing
+ThreadBuffer& thread_buffer() {
+    if (!t_buffer) {
+        TraceState& s = state();
+        std::lock_guard lock(s.mutex);
+        s.buffers.push_back(std::make_unique<ThreadBuffer>());
+        t_buffer = s.buffers.back().get();
+        t_buffer->id = static_cast<uint32_t>(s.buffers.size());
+        t_buffer->name.store(t_thread_name, std::memory_order_release);
+    }
+    return *t_buffer;
+}
+
+// Names are literals, but keep the JSON valid whatever they contain
+void write_escaped(std::FILE* file, const char* text) {
+    for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            std::fputc('\\', file);
+            std::fputc(*c, file);
+        } else if (static_cast<unsigned char>(*c) >= 0x20) {
+            std::fputc(*c, file);
+        }
+    }
+}
+
+double micros_since(Tracer::Clock::time_point origin, Tracer::Clock::time_point t) {
+    return std::chrono::duration<double, std::micro>(t - origin).count();
+}
+
+bool write_trace(TraceState& s, uint64_t epoch) {
+#if GVRDP_WINDOWS
+    std::FILE* file = _wfopen(s.path.c_str(), L"wb");
+#else
+    std::FILE* file = std::fopen(s.path.c_str(), "wb");
+#endif
+    if (!file) return false;
+
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    bool first = true;
+    auto separator = [&] {
+        if (!first) std::fputs(",\n", file);
+        first = false;
+    };
+    for (const auto& buffer : s.buffers) {
+        if (buffer->epoch.load(std::memory_order_acquire) != epoch) continue;
+
+        separator();
+        std::fprintf(file, "{\"ph\":\"M\",\"pid\":1,\"tid\":%" PRIu32
+                           ",\"name\":\"thread_name\",\"args\":{\"name\":\"",
+                     buffer->id);
+        const char* name = buffer->name.load(std::memory_order_acquire);
+        if (name) {
+            write_escaped(file, name);
+        } else {
+            std::fprintf(file, "thread %" PRIu32, buffer->id);
+        }
+        std::fputs("\"}}", file);
+
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; i++) {
+            const TraceEvent& event = buffer->events[i];
+            separator();
+            std::fputs("{\"ph\":\"X\",\"pid\":1,\"tid\":", file);
+            std::fprintf(file, "%" PRIu32 ",\"name\":\"", buffer->id);
+            write_escaped(file, event.name);
+            std::fprintf(file, "\",\"ts\":%.3f,\"dur\":%.3f}", micros_since(s.started, event.start),
+                         micros_since(event.start, event.end));
+        }
+
+        uint64_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+        if (dropped > 0) {
+            separator();
+            std::fprintf(file, "{\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%" PRIu32
+                               ",\"name\":\"%" PRIu64 " events dropped\",\"ts\":%.3f}",
+                         buffer->id, dropped, micros_since(s.started, s.deadline));
+        }
+    }
+    std::fputs("\n]}\n", file);
+    return std::fclose(file) == 0;
+}
+
+}  // namespace
+
+std::atomic<bool> Tracer::enabled_{false};
+
+bool Tracer::start(const std::filesystem::path& path, std::chrono::milliseconds duration) {
+    TraceState& s = state();
+    std::lock_guard lock(s.mutex);
+    if (s.running) return false;
+
+    std::error_code ec;
+    if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path(), ec);
+    s.path = path;
+    s.started = Clock::now();
+    s.deadline = s.started + duration;
+    s.running = true;
+    s.epoch.fetch_add(1, std::memory_order_release);
+    enabled_.store(true, std::memory_order_release);
+    return true;
+}
+
+bool Tracer::stop() {
+    TraceState& s = state();
+    std::lock_guard lock(s.mutex);
+    if (!s.running) return false;
+    enabled_.store(false, std::memory_order_release);
+    s.running = false;
+    return write_trace(s, s.epoch.load(std::memory_order_relaxed));
+}
+
+bool Tracer::due() {
+    if (!enabled()) return false;
+    TraceState& s = state();
+    std::lock_guard lock(s.mutex);
+    return s.running && Clock::now() >= s.deadline;
+}
+
+std::optional<std::chrono::milliseconds> Tracer::time_until_deadline() {
+    if (!enabled()) return std::nullopt;
+    TraceState& s = state();
+    std::lock_guard lock(s.mutex);
+    if (!s.running) return std::nullopt;
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(s.deadline - Clock::now());
+    return std::max(remaining, std::chrono::milliseconds(0));
+}
+
+void Tracer::set_thread_name(const char* name) {
+    t_thread_name = name;
+    if (t_buffer) t_buffer->name.store(name, std::memory_order_release);
+}
+
+void Tracer::record(const char* name, Clock::time_point start, Clock::time_point end) {
+    if (!enabled()) return;
+    ThreadBuffer& buffer = thread_buffer();
+
+    uint64_t epoch = state().epoch.load(std::memory_order_acquire);
+    if (buffer.epoch.load(std::memory_order_relaxed) != epoch) {
+        buffer.count.store(0, std::memory_order_relaxed);
+        buffer.dropped.store(0, std::memory_order_relaxed);
+        buffer.epoch.store(epoch, std::memory_order_release);
+    }
+
+    size_t index = buffer.count.load(std::memory_order_relaxed);
+    if (index >= ThreadBuffer::kCapacity) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer.events[index] = {name, start, end};
+    buffer.count.store(index + 1, std::memory_order_release);
+}
+
+}  // namespace gvrdp
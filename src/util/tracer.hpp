@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <optional>
+
+namespace gvrdp {
+
+// Timeline tracing across threads, written as Chrome Trace Event JSON
+// (load it in chrome://tracing or ui.perfetto.dev).
+//
+// Each thread appends to its own fixed-size buffer, created on its first
+// event; after that recording takes no lock and never allocates, and a full
+// buffer drops further events. While no trace is running a TRACE_SCOPE costs
+// one relaxed load and a branch.
+//
+// Event names must be string literals (only the pointer is stored).
+class Tracer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Starts a trace that is written to `path` after `duration`, or by
+    // stop(). Returns false if one is already running.
+    static bool start(const std::filesystem::path& path, std::chrono::milliseconds duration);
+
+    // Stops a running trace and writes it. Returns false if nothing was
+    // running or the file could not be written.
+    static bool stop();
+
+    // Whether a running trace has reached its duration and should be stopped
+    static bool due();
+    static std::optional<std::chrono::milliseconds> time_until_deadline();
+
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    // Name shown for the calling thread's track
+    static void set_thread_name(const char* name);
+
+    // A complete event on the calling thread's track
+    static void record(const char* name, Clock::time_point start, Clock::time_point end);
+
+private:
+    static std::atomic<bool> enabled_;
+};
+
+// Records the enclosing scope as one event while tracing is on
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) {
+        if (Tracer::enabled()) {
+            name_ = name;
+            start_ = Tracer::Clock::now();
+        }
+    }
+    ~TraceScope() {
+        if (name_) Tracer::record(name_, start_, Tracer::Clock::now());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_ = nullptr;
+    Tracer::Clock::time_point start_;
+};
+
+}  // namespace gvrdp
+
+#define GVRDP_TRACE_CONCAT_(a, b) a##b
+#define GVRDP_TRACE_CONCAT(a, b) GVRDP_TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) ::gvrdp::TraceScope GVRDP_TRACE_CONCAT(trace_scope_, __LINE__)(name)
@@ -0,0 +1,70 @@
+#include "util/worker_pool.hpp"
+
+#include <algorithm>
+
+namespace gvrdp {
+
+WorkerPool::WorkerPool(size_t threads, size_t max_queued)
+    : max_queued_(std::max<size_t>(max_queued, 1)) {
+    if (threads == 0) {
+        size_t cores = std::thread::hardware_concurrency();
+        threads = cores > 1 ? cores - 1 : 1;
+    }
+    threads_.reserve(threads);
+    for (size_t i = 0; i < threads; i++) {
+        threads_.emplace_back(&WorkerPool::worker, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkerPool::submit(Job job) {
+    {
+        std::unique_lock lock(mutex_);
+        space_cv_.wait(lock, [this] { return queue_.size() < max_queued_; });
+        queue_.push_back(std::move(job));
+    }
+    work_cv_.notify_one();
+}
+
+void WorkerPool::wait_idle() {
+    std::unique_lock lock(mutex_);
+    idle_cv_.wait(lock, [this] { return queue_.empty() && running_ == 0; });
+}
+
+void WorkerPool::worker() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock lock(mutex_);
+            work_cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            // Finish queued work before stopping
+            if (queue_.empty()) return;
+            job = std::move(queue_.front());
+            queue_.pop_front();
+            running_++;
+        }
+        space_cv_.notify_one();
+
+        job();
+
+        bool idle;
+        {
+            std::lock_guard lock(mutex_);
+            running_--;
+            idle = queue_.empty() && running_ == 0;
+        }
+        if (idle) idle_cv_.notify_all();
+    }
+}
+
+}  // namespace gvrdp
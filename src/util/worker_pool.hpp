@@ -0,0 +1,50 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gvrdp {
+
+// Fixed-size thread pool with a bounded queue. submit() blocks once
+// max_queued jobs are waiting, so a fast producer is slowed down instead of
+// buffering without limit. Jobs may finish in any order; callers that need
+// ordered results keep their own submission-ordered list and commit it after
+// wait_idle().
+class WorkerPool {
+public:
+    using Job = std::function<void()>;
+
+    // threads == 0 picks cores - 1 (at least 1), leaving a core for the caller
+    explicit WorkerPool(size_t threads, size_t max_queued = 64);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void submit(Job job);
+
+    // Blocks until every submitted job has finished
+    void wait_idle();
+
+    size_t size() const { return threads_.size(); }
+
+private:
+    void worker();
+
+    std::mutex mutex_;
+    std::condition_variable work_cv_;   // Workers: a job arrived or stopping
+    std::condition_variable space_cv_;  // submit(): queue has room
+    std::condition_variable idle_cv_;   // wait_idle(): everything finished
+    std::deque<Job> queue_;
+    size_t max_queued_;
+    size_t running_ = 0;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+};
+
+}  // namespace gvrdp
@@ -0,0 +1,138 @@
+#include "util/backlog_ring.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace gvrdp;
+
+using Ring = BacklogRing<int, 4, 8>;
+
+TEST(BacklogRingTest, PushReturnsWhenTheRingIsFull) {
+    Ring ring;
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(ring.push(i), Ring::Push::Queued);
+    }
+    // No consumer is running: a blocking push would never return
+    EXPECT_EQ(ring.push(4), Ring::Push::Backlogged);
+    EXPECT_EQ(ring.push(5), Ring::Push::Backlogged);
+    EXPECT_EQ(ring.backlog(), 2u);
+}
+
+TEST(BacklogRingTest, BacklogKeepsOrder) {
+    Ring ring;
+    for (int i = 0; i < 6; i++) {
+        ring.push(i);
+    }
+    EXPECT_EQ(ring.pop(), 0);
+    EXPECT_EQ(ring.pop(), 1);
+
+    // Room for two: both backlogged items move in, still behind 2 and 3
+    EXPECT_TRUE(ring.flush());
+    EXPECT_EQ(ring.push(6), Ring::Push::Backlogged);
+    std::vector<int> seen;
+    while (auto value = ring.pop()) {
+        seen.push_back(*value);
+    }
+    EXPECT_EQ(seen, (std::vector<int>{2, 3, 4, 5}));
+
+    // The next push flushes first
+    EXPECT_EQ(ring.push(7), Ring::Push::Queued);
+    EXPECT_EQ(ring.pop(), 6);
+    EXPECT_EQ(ring.pop(), 7);
+}
+
+TEST(BacklogRingTest, PushLatestKeepsOnlyTheNewestWaitingItem) {
+    Ring ring;
+    EXPECT_EQ(ring.push_latest(0), Ring::Push::Queued);
+    for (int i = 1; i < 4; i++) {
+        ring.push(i);
+    }
+    // The consumer is behind: moves 10 and 11 wait, and 11 supersedes 10
+    EXPECT_EQ(ring.push_latest(10), Ring::Push::Backlogged);
+    EXPECT_EQ(ring.push_latest(11), Ring::Push::Backlogged);
+    EXPECT_EQ(ring.backlog(), 1u);
+
+    // Once there is room the newest one is still delivered
+    EXPECT_EQ(ring.pop(), 0);
+    EXPECT_TRUE(ring.flush());
+    std::vector<int> seen;
+    while (auto value = ring.pop()) {
+        seen.push_back(*value);
+    }
+    EXPECT_EQ(seen, (std::vector<int>{1, 2, 3, 11}));
+}
+
+TEST(BacklogRingTest, PushLatestNeverOvertakesOtherItems) {
+    Ring ring;
+    for (int i = 0; i < 4; i++) {
+        ring.push(i);
+    }
+    ring.push_latest(10);
+    ring.push(20);
+    // 10 is no longer the tail: 12 waits behind 20 instead of replacing it
+    ring.push_latest(12);
+    ring.push_latest(13);
+    EXPECT_EQ(ring.backlog(), 3u);
+
+    std::vector<int> seen;
+    while (seen.size() < 7) {
+        ring.flush();
+        while (auto value = ring.pop()) {
+            seen.push_back(*value);
+        }
+    }
+    EXPECT_EQ(seen, (std::vector<int>{0, 1, 2, 3, 10, 20, 13}));
+}
+
+TEST(BacklogRingTest, DropsOnceTheBacklogIsFull) {
+    Ring ring;
+    for (int i = 0; i < 4 + 8; i++) {
+        EXPECT_NE(ring.push(i), Ring::Push::Dropped);
+    }
+    EXPECT_EQ(ring.push(99), Ring::Push::Dropped);
+    EXPECT_EQ(ring.backlog(), 8u);
+}
+
+TEST(BacklogRingTest, ClearEmptiesRingAndBacklog) {
+    Ring ring;
+    for (int i = 0; i < 6; i++) {
+        ring.push(i);
+    }
+    ring.clear();
+    EXPECT_EQ(ring.backlog(), 0u);
+    EXPECT_FALSE(ring.pop().has_value());
+}
+
+TEST(BacklogRingTest, SlowConsumerSeesEveryItemInOrder) {
+    BacklogRing<int, 16, 100000> ring;
+    constexpr int kItems = 20000;
+    std::atomic<bool> done{false};
+    std::vector<int> seen;
+    seen.reserve(kItems);
+    std::thread consumer([&] {
+        while (true) {
+            bool finished = done.load(std::memory_order_acquire);
+            while (auto value = ring.pop()) {
+                seen.push_back(*value);
+            }
+            if (finished) break;
+            std::this_thread::yield();
+        }
+    });
+    for (int i = 0; i < kItems; i++) {
+        ASSERT_NE(ring.push(i), decltype(ring)::Push::Dropped);
+    }
+    while (!ring.flush()) {
+        std::this_thread::yield();
+    }
+    done.store(true, std::memory_order_release);
+    consumer.join();
+
+    ASSERT_EQ(seen.size(), static_cast<size_t>(kItems));
+    for (int i = 0; i < kItems; i++) {
+        ASSERT_EQ(seen[static_cast<size_t>(i)], i);
+    }
+}
@@ -0,0 +1,80 @@
+#include "core/codec_stats.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gvrdp;
+using namespace std::chrono_literals;
+
+TEST(CodecStats, StartsEmpty) {
+    CodecStats stats;
+    for (size_t i = 0; i < static_cast<size_t>(Codec::Count); i++) {
+        CodecTotals totals = stats.totals(static_cast<Codec>(i));
+        EXPECT_EQ(totals.commands, 0u);
+        EXPECT_EQ(totals.bytes, 0u);
+        EXPECT_EQ(totals.decode_time.count(), 0);
+    }
+}
+
+TEST(CodecStats, AccumulatesPerCodec) {
+    CodecStats stats;
+    stats.record(Codec::Planar, 100, 2ms);
+    stats.record(Codec::Planar, 50, 1ms);
+    stats.record(Codec::Avc420, 4000, 3ms);
+
+    CodecTotals planar = stats.totals(Codec::Planar);
+    EXPECT_EQ(planar.commands, 2u);
+    EXPECT_EQ(planar.bytes, 150u);
+    EXPECT_EQ(planar.decode_time, 3ms);
+
+    CodecTotals avc = stats.totals(Codec::Avc420);
+    EXPECT_EQ(avc.commands, 1u);
+    EXPECT_EQ(avc.bytes, 4000u);
+    EXPECT_EQ(stats.totals(Codec::RemoteFx).commands, 0u);
+}
+
+TEST(CodecStats, ResetClearsEverything) {
+    CodecStats stats;
+    stats.record(Codec::RemoteFx, 10, 1ms);
+    stats.reset();
+    EXPECT_EQ(stats.totals(Codec::RemoteFx).commands, 0u);
+    EXPECT_EQ(stats.totals(Codec::RemoteFx).bytes, 0u);
+}
+
+TEST(CodecStats, ScopeRecordsOnExit) {
+    CodecStats stats;
+    {
+        CodecStats::Scope scope(&stats, Codec::Progressive, 64);
+        EXPECT_EQ(stats.totals(Codec::Progressive).commands, 0u);
+    }
+    CodecTotals totals = stats.totals(Codec::Progressive);
+    EXPECT_EQ(totals.commands, 1u);
+    EXPECT_EQ(totals.bytes, 64u);
+    EXPECT_GE(totals.decode_time.count(), 0);
+
+    // Unknown codecs and null stats are ignored
+    { CodecStats::Scope ignored(nullptr, Codec::Planar, 1); }
+    stats.record(Codec::Count, 1, 1ms);
+}
+
+TEST(CodecStats, ConcurrentWritersLoseNothing) {
+    CodecStats stats;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 10000; i++) stats.record(Codec::ClearCodec, 2, 1ns);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(stats.totals(Codec::ClearCodec).commands, 40000u);
+    EXPECT_EQ(stats.totals(Codec::ClearCodec).bytes, 80000u);
+}
+
+TEST(CodecStats, Names) {
+    EXPECT_EQ(std::string(codec_name(Codec::RemoteFx)), "RemoteFX");
+    EXPECT_EQ(std::string(codec_name(Codec::Avc444)), "AVC444");
+    EXPECT_EQ(std::string(codec_name(Codec::Count)), "Unknown");
+}
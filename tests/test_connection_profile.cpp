@@ -12,10 +12,15 @@ TEST(ConnectionProfile, DefaultValues) {
     EXPECT_EQ(p.height, 1080u);
     EXPECT_EQ(p.color_depth, 32u);
     EXPECT_TRUE(p.dynamic_resolution);
+    EXPECT_FALSE(p.smart_sizing);
+    EXPECT_EQ(p.scaling_filter, "linear");
     EXPECT_TRUE(p.enable_clipboard);
     EXPECT_TRUE(p.enable_audio);
     EXPECT_FALSE(p.enable_drive_redirect);
     EXPECT_FALSE(p.fullscreen);
+    EXPECT_TRUE(p.enable_gfx_pipeline);
+    EXPECT_EQ(p.max_fps, 0u);
+    EXPECT_EQ(p.gfx_ack_window, 0u);
 }
 
 TEST(ConnectionProfile, JsonRoundTrip) {
@@ -28,7 +33,12 @@ TEST(ConnectionProfile, JsonRoundTrip) {
     original.width = 2560;
     original.height = 1440;
     original.dynamic_resolution = false;
+    original.smart_sizing = true;
+    original.scaling_filter = "nearest";
     original.enable_clipboard = false;
+    original.enable_gfx_pipeline = false;
+    original.max_fps = 30;
+    original.gfx_ack_window = 2;
 
     nlohmann::json j = original;
     auto restored = j.get<ConnectionProfile>();
@@ -41,7 +51,12 @@ TEST(ConnectionProfile, JsonRoundTrip) {
     EXPECT_EQ(restored.width, 2560u);
     EXPECT_EQ(restored.height, 1440u);
     EXPECT_FALSE(restored.dynamic_resolution);
+    EXPECT_TRUE(restored.smart_sizing);
+    EXPECT_EQ(restored.scaling_filter, "nearest");
     EXPECT_FALSE(restored.enable_clipboard);
+    EXPECT_FALSE(restored.enable_gfx_pipeline);
+    EXPECT_EQ(restored.max_fps, 30u);
+    EXPECT_EQ(restored.gfx_ack_window, 2u);
 }
 
 TEST(ConnectionProfile, PartialJsonDeserialization) {
@@ -69,3 +84,44 @@ TEST(ConnectionProfile, PasswordNotSerialized) {
     auto restored = j.get<ConnectionProfile>();
     EXPECT_TRUE(restored.password.empty());
 }
+
+TEST(ConnectionProfile, AutoCodecsPreferGpuH264) {
+    ConnectionProfile p;
+    CodecSelection with_gpu = resolve_codecs(p, true);
+    EXPECT_TRUE(with_gpu.avc420);
+    EXPECT_FALSE(with_gpu.avc444);
+    EXPECT_TRUE(with_gpu.gpu_h264);
+    EXPECT_TRUE(with_gpu.remotefx);
+    EXPECT_TRUE(with_gpu.progressive);
+
+    CodecSelection without_gpu = resolve_codecs(p, false);
+    EXPECT_FALSE(without_gpu.avc420);
+    EXPECT_FALSE(without_gpu.gpu_h264);
+    EXPECT_TRUE(without_gpu.planar);
+
+    p.enable_gfx_pipeline = false;
+    EXPECT_FALSE(resolve_codecs(p, true).gpu_h264);
+}
+
+TEST(ConnectionProfile, ExplicitCodecsAreHonoured) {
+    ConnectionProfile p;
+    p.codec_auto = false;
+    p.codec_remotefx = false;
+    p.codec_nscodec = false;
+    p.codec_avc420 = true;
+    p.codec_avc444 = true;
+
+    CodecSelection codecs = resolve_codecs(p, true);
+    EXPECT_FALSE(codecs.remotefx);
+    EXPECT_FALSE(codecs.nscodec);
+    EXPECT_TRUE(codecs.avc420);
+    EXPECT_TRUE(codecs.avc444);
+    // AVC444 stays on FreeRDP's decoder
+    EXPECT_FALSE(codecs.gpu_h264);
+
+    nlohmann::json j = p;
+    auto restored = j.get<ConnectionProfile>();
+    EXPECT_FALSE(restored.codec_auto);
+    EXPECT_FALSE(restored.codec_remotefx);
+    EXPECT_TRUE(restored.codec_avc444);
+}
@@ -0,0 +1,126 @@
+#include "util/damage_region.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace gvrdp;
+
+TEST(DamageRegion, EmptyByDefault) {
+    DamageRegion d;
+    EXPECT_TRUE(d.empty());
+    EXPECT_EQ(d.area(), 0u);
+    EXPECT_TRUE(d.bounds().empty());
+}
+
+TEST(DamageRegion, IgnoresEmptyRects) {
+    DamageRegion d;
+    d.add(Rect{10, 10, 0, 5});
+    d.add(Rect{10, 10, 5, 0});
+    EXPECT_TRUE(d.empty());
+}
+
+TEST(DamageRegion, KeepsDisjointRectsSeparate) {
+    DamageRegion d;
+    d.add(Rect{0, 0, 10, 10});
+    d.add(Rect{100, 100, 10, 10});
+    EXPECT_EQ(d.rects().size(), 2u);
+    EXPECT_EQ(d.area(), 200u);
+}
+
+TEST(DamageRegion, MergesOverlappingRects) {
+    DamageRegion d;
+    d.add(Rect{0, 0, 10, 10});
+    d.add(Rect{5, 5, 10, 10});
+    ASSERT_EQ(d.rects().size(), 1u);
+    EXPECT_EQ(d.rects()[0], (Rect{0, 0, 15, 15}));
+}
+
+TEST(DamageRegion, MergesEdgeAdjacentRects) {
+    DamageRegion d;
+    d.add(Rect{0, 0, 10, 10});
+    d.add(Rect{10, 0, 10, 10});
+    ASSERT_EQ(d.rects().size(), 1u);
+    EXPECT_EQ(d.rects()[0], (Rect{0, 0, 20, 10}));
+}
+
+TEST(DamageRegion, DoesNotMergeCornerTouchingRects) {
+    DamageRegion d;
+    d.add(Rect{0, 0, 10, 10});
+    d.add(Rect{10, 10, 10, 10});
+    EXPECT_EQ(d.rects().size(), 2u);
+}
+
+TEST(DamageRegion, CascadingMerge) {
+    DamageRegion d;
+    d.add(Rect{0, 0, 10, 10});
+    d.add(Rect{30, 0, 10, 10});
+    // Bridges both existing rectangles
+    d.add(Rect{5, 0, 30, 10});
+    ASSERT_EQ(d.rects().size(), 1u);
+    EXPECT_EQ(d.rects()[0], (Rect{0, 0, 40, 10}));
+}
+
+TEST(DamageRegion, CollapsesToBoundsPastLimit) {
+    DamageRegion d;
+    for (uint32_t i = 0; i <= DamageRegion::kMaxRects; i++) {
+        d.add(Rect{i * 20, i * 20, 10, 10});
+    }
+    ASSERT_EQ(d.rects().size(), 1u);
+    uint32_t extent = DamageRegion::kMaxRects * 20 + 10;
+    EXPECT_EQ(d.rects()[0], (Rect{0, 0, extent, extent}));
+}
+
+TEST(DamageRegion, ClipDropsAndTrims) {
+    DamageRegion d;
+    d.add(Rect{90, 90, 20, 20});
+    d.add(Rect{200, 0, 10, 10});
+    d.clip(100, 100);
+    ASSERT_EQ(d.rects().size(), 1u);
+    EXPECT_EQ(d.rects()[0], (Rect{90, 90, 10, 10}));
+}
+
+TEST(DamageRegion, AddRegion) {
+    DamageRegion a;
+    a.add(Rect{0, 0, 10, 10});
+    DamageRegion b;
+    b.add(Rect{50, 50, 10, 10});
+    a.add(b);
+    EXPECT_EQ(a.rects().size(), 2u);
+    EXPECT_EQ(a.bounds(), (Rect{0, 0, 60, 60}));
+}
+
+TEST(Rect, Intersected) {
+    Rect a{0, 0, 100, 100};
+    EXPECT_EQ(a.intersected({50, 60, 100, 100}), (Rect{50, 60, 50, 40}));
+    EXPECT_TRUE(a.intersected({100, 0, 10, 10}).empty());
+}
+
+TEST(Rect, SubtractedDisjointIsWhole) {
+    Rect a{0, 0, 10, 10};
+    auto parts = a.subtracted({20, 20, 5, 5});
+    ASSERT_EQ(parts.size(), 1u);
+    EXPECT_EQ(parts[0], a);
+}
+
+TEST(Rect, SubtractedCoveredIsEmpty) {
+    EXPECT_TRUE((Rect{10, 10, 5, 5}).subtracted({0, 0, 100, 100}).empty());
+}
+
+TEST(Rect, SubtractedHoleLeavesFourBands) {
+    Rect a{0, 0, 100, 100};
+    auto parts = a.subtracted({40, 30, 20, 10});
+    ASSERT_EQ(parts.size(), 4u);
+    uint64_t area = 0;
+    for (const auto& part : parts) {
+        EXPECT_FALSE(part.intersects({40, 30, 20, 10}));
+        EXPECT_TRUE(a.contains(part));
+        area += part.area();
+    }
+    EXPECT_EQ(area, a.area() - 200u);
+}
+
+TEST(Rect, SubtractedEdgeOverlap) {
+    // Window moved left by 30: only the strip that came on screen remains
+    auto parts = (Rect{0, 0, 100, 50}).subtracted({30, 0, 100, 50});
+    ASSERT_EQ(parts.size(), 1u);
+    EXPECT_EQ(parts[0], (Rect{0, 0, 30, 50}));
+}
@@ -0,0 +1,117 @@
+#include "util/fd_reactor.hpp"
+
+#include <gtest/gtest.h>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <vector>
+
+using namespace gvrdp;
+
+namespace {
+
+class EventFd {
+public:
+    EventFd() : fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {}
+    ~EventFd() { ::close(fd_); }
+
+    int fd() const { return fd_; }
+    void signal() {
+        uint64_t one = 1;
+        ASSERT_EQ(::write(fd_, &one, sizeof(one)), static_cast<ssize_t>(sizeof(one)));
+    }
+    void reset() {
+        uint64_t value;
+        (void)::read(fd_, &value, sizeof(value));
+    }
+
+private:
+    int fd_;
+};
+
+}  // namespace
+
+TEST(FdReactorTest, TimesOutWhenNothingIsReady) {
+    FdReactor reactor;
+    ASSERT_TRUE(reactor.valid());
+    EventFd a;
+    ASSERT_TRUE(reactor.set_fds({a.fd()}));
+    EXPECT_EQ(reactor.wait(0), 0);
+    EXPECT_EQ(reactor.wait(10), 0);
+}
+
+TEST(FdReactorTest, WakesForAnySignalledDescriptor) {
+    FdReactor reactor;
+    EventFd a, b;
+    ASSERT_TRUE(reactor.set_fds({a.fd(), b.fd()}));
+
+    b.signal();
+    EXPECT_EQ(reactor.wait(-1), 1);
+
+    // Level-triggered: stays ready until the source is reset
+    EXPECT_EQ(reactor.wait(0), 1);
+    b.reset();
+    EXPECT_EQ(reactor.wait(0), 0);
+}
+
+TEST(FdReactorTest, SameSetIsNotRearmed) {
+    FdReactor reactor;
+    EventFd a, b;
+    ASSERT_TRUE(reactor.set_fds({a.fd(), b.fd()}));
+    size_t armed = reactor.rearm_count();
+    EXPECT_EQ(armed, 2u);
+
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(reactor.set_fds({a.fd(), b.fd()}));
+    }
+    EXPECT_EQ(reactor.rearm_count(), armed);
+}
+
+TEST(FdReactorTest, ChangedSetOnlyTouchesTheDifference) {
+    FdReactor reactor;
+    EventFd a, b, c;
+    ASSERT_TRUE(reactor.set_fds({a.fd(), b.fd()}));
+    size_t armed = reactor.rearm_count();
+
+    // b leaves, c joins, a stays
+    ASSERT_TRUE(reactor.set_fds({a.fd(), c.fd()}));
+    EXPECT_EQ(reactor.rearm_count(), armed + 2);
+
+    b.signal();
+    EXPECT_EQ(reactor.wait(0), 0);
+    c.signal();
+    EXPECT_EQ(reactor.wait(0), 1);
+}
+
+TEST(FdReactorTest, InvalidDescriptorIsRejected) {
+    FdReactor reactor;
+    EventFd a;
+    EXPECT_FALSE(reactor.set_fds({a.fd(), -1}));
+
+    // Still usable afterwards
+    ASSERT_TRUE(reactor.set_fds({a.fd()}));
+    a.signal();
+    EXPECT_EQ(reactor.wait(0), 1);
+}
+
+TEST(FdReactorTest, ReusedDescriptorNumberIsWatched) {
+    FdReactor reactor;
+    EventFd a;
+    int old_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    ASSERT_GE(old_fd, 0);
+    ASSERT_TRUE(reactor.set_fds({a.fd(), old_fd}));
+
+    // Closing drops it from epoll; the next eventfd gets the same number,
+    // so the set passed in is identical to the last one
+    ::close(old_fd);
+    int new_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    ASSERT_EQ(new_fd, old_fd);
+    ASSERT_TRUE(reactor.set_fds({a.fd(), new_fd}));
+
+    uint64_t one = 1;
+    ASSERT_EQ(::write(new_fd, &one, sizeof(one)), static_cast<ssize_t>(sizeof(one)));
+    EXPECT_EQ(reactor.wait(0), 1);
+    ::close(new_fd);
+}
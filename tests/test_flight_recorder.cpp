@@ -0,0 +1,152 @@
+#include "util/flight_recorder.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gvrdp;
+
+namespace {
+
+class FlightRecorderTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() /
+               (std::string("gvrdp_flight_test_") +
+                ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        std::filesystem::remove_all(dir_);
+        ring_ = dir_ / "recorder.gfr";
+    }
+    void TearDown() override {
+        FlightRecorder::close();
+        std::filesystem::remove_all(dir_);
+    }
+
+    std::filesystem::path dir_;
+    std::filesystem::path ring_;
+};
+
+}  // namespace
+
+TEST_F(FlightRecorderTest, RecordIsANoOpWhenClosed) {
+    EXPECT_FALSE(FlightRecorder::active());
+    FlightRecorder::record(FlightEvent::Connected);
+    EXPECT_FALSE(FlightRecorder::dump(dir_ / "dump.gfr", DumpReason::Error));
+}
+
+TEST_F(FlightRecorderTest, RecordsSurviveCloseInOrder) {
+    ASSERT_TRUE(FlightRecorder::open(ring_, 16));
+    EXPECT_TRUE(FlightRecorder::active());
+    FlightRecorder::record(FlightEvent::SessionStart, 3389);
+    FlightRecorder::record(FlightEvent::FrameReady, 0, 640 * 480);
+    FlightRecorder::record(FlightEvent::ChannelConnected, 0, FlightRecorder::pack_name("rdpgfx"));
+    FlightRecorder::close();
+    EXPECT_FALSE(FlightRecorder::left_open(ring_));
+
+    auto recording = FlightRecorder::read(ring_);
+    ASSERT_TRUE(recording);
+    EXPECT_TRUE(recording->closed);
+    EXPECT_EQ(recording->capacity, 16u);
+    EXPECT_GT(recording->started_unix_ns, 0);
+    ASSERT_EQ(recording->records.size(), 3u);
+
+    const auto& records = recording->records;
+    EXPECT_EQ(records[0].type, static_cast<uint16_t>(FlightEvent::SessionStart));
+    EXPECT_EQ(records[0].a, 3389u);
+    EXPECT_EQ(records[1].b, 640u * 480u);
+    EXPECT_EQ(FlightRecorder::unpack_name(records[2].b), "rdpgfx");
+    EXPECT_LE(records[0].time_ns, records[1].time_ns);
+    EXPECT_LE(records[1].time_ns, records[2].time_ns);
+}
+
+TEST_F(FlightRecorderTest, RingKeepsTheNewestEvents) {
+    ASSERT_TRUE(FlightRecorder::open(ring_, 5));  // Rounded up to 8
+    for (uint32_t i = 0; i < 20; i++) {
+        FlightRecorder::record(FlightEvent::GfxFrame, i);
+    }
+    FlightRecorder::close();
+
+    auto recording = FlightRecorder::read(ring_);
+    ASSERT_TRUE(recording);
+    EXPECT_EQ(recording->capacity, 8u);
+    ASSERT_EQ(recording->records.size(), 8u);
+    for (size_t i = 0; i < 8; i++) {
+        EXPECT_EQ(recording->records[i].a, 12 + i);
+    }
+}
+
+TEST_F(FlightRecorderTest, UnclosedRingIsDetected) {
+    ASSERT_TRUE(FlightRecorder::open(ring_, 8));
+    FlightRecorder::record(FlightEvent::Connected);
+
+    // What a crashed process leaves behind: the shared mapping is the file
+    EXPECT_TRUE(FlightRecorder::left_open(ring_));
+    auto recording = FlightRecorder::read(ring_);
+    ASSERT_TRUE(recording);
+    EXPECT_FALSE(recording->closed);
+    ASSERT_EQ(recording->records.size(), 1u);
+    EXPECT_EQ(recording->records[0].type, static_cast<uint16_t>(FlightEvent::Connected));
+}
+
+TEST_F(FlightRecorderTest, DumpCopiesTheLiveRing) {
+    ASSERT_TRUE(FlightRecorder::open(ring_, 8));
+    FlightRecorder::record(FlightEvent::Error, 2, 0x2000C);
+    ASSERT_TRUE(FlightRecorder::dump(dir_ / "dumps" / "error.gfr", DumpReason::Error));
+    FlightRecorder::record(FlightEvent::Connected);
+
+    auto dump = FlightRecorder::read(dir_ / "dumps" / "error.gfr");
+    ASSERT_TRUE(dump);
+    EXPECT_TRUE(dump->closed);
+    ASSERT_EQ(dump->records.size(), 2u);
+    EXPECT_EQ(dump->records[0].b, 0x2000Cu);
+    EXPECT_EQ(dump->records[1].type, static_cast<uint16_t>(FlightEvent::Dump));
+    EXPECT_EQ(dump->records[1].a, static_cast<uint32_t>(DumpReason::Error));
+}
+
+TEST_F(FlightRecorderTest, ThreadsRecordConcurrently) {
+    constexpr int kThreads = 4;
+    constexpr uint32_t kEach = 1000;
+    ASSERT_TRUE(FlightRecorder::open(ring_, kThreads * kEach));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([] {
+            for (uint32_t i = 0; i < kEach; i++) {
+                FlightRecorder::record(FlightEvent::InputSent, i);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    FlightRecorder::close();
+
+    auto recording = FlightRecorder::read(ring_);
+    ASSERT_TRUE(recording);
+    ASSERT_EQ(recording->records.size(), size_t{kThreads} * kEach);
+    for (size_t i = 0; i < recording->records.size(); i++) {
+        EXPECT_EQ(recording->records[i].sequence, i + 1);
+    }
+}
+
+TEST_F(FlightRecorderTest, ForeignFileIsRejected) {
+    std::filesystem::create_directories(dir_);
+    {
+        std::ofstream file(ring_, std::ios::binary);
+        file << "not a flight recorder file, but long enough to hold a header.........";
+    }
+    EXPECT_FALSE(FlightRecorder::read(ring_));
+    EXPECT_FALSE(FlightRecorder::left_open(ring_));
+    EXPECT_FALSE(FlightRecorder::read(dir_ / "missing.gfr"));
+}
+
+TEST_F(FlightRecorderTest, NamesPackIntoEightBytes) {
+    EXPECT_EQ(FlightRecorder::unpack_name(FlightRecorder::pack_name("disp")), "disp");
+    EXPECT_EQ(FlightRecorder::unpack_name(FlightRecorder::pack_name("Microsoft::Windows")),
+              "Microsof");
+    EXPECT_EQ(FlightRecorder::pack_name(nullptr), 0u);
+}
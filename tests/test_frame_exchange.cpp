@@ -0,0 +1,244 @@
+#include "core/frame_exchange.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace gvrdp;
+
+namespace {
+
+// Stand-in for the GDI primary buffer the RDP thread paints into
+struct Source {
+    std::vector<uint32_t> pixels;
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    void resize(uint32_t w, uint32_t h) {
+        width = w;
+        height = h;
+        pixels.assign(static_cast<size_t>(w) * h, 0);
+    }
+
+    void fill(const Rect& rect, uint32_t value) {
+        for (uint32_t y = rect.y; y < rect.bottom(); y++) {
+            for (uint32_t x = rect.x; x < rect.right(); x++) {
+                pixels[static_cast<size_t>(y) * width + x] = value;
+            }
+        }
+    }
+
+    void publish(FrameExchange& exchange, const DamageRegion& damage) const {
+        exchange.publish(reinterpret_cast<const uint8_t*>(pixels.data()), width, height,
+                         width * 4, damage);
+    }
+};
+
+uint32_t pixel_at(const DesktopFrame& frame, uint32_t x, uint32_t y) {
+    uint32_t value;
+    std::memcpy(&value, frame.pixels.data() + static_cast<size_t>(y) * frame.stride + x * 4, 4);
+    return value;
+}
+
+// Consumer-side mirror of a texture, updated only through frame damage
+struct Mirror {
+    std::vector<uint32_t> pixels;
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    void apply(const DesktopFrame& frame) {
+        if (frame.width != width || frame.height != height) {
+            width = frame.width;
+            height = frame.height;
+            pixels.assign(static_cast<size_t>(width) * height, 0);
+            copy(frame, Rect{0, 0, width, height});
+            return;
+        }
+        for (const auto& rect : frame.damage.rects()) {
+            copy(frame, rect);
+        }
+    }
+
+    void copy(const DesktopFrame& frame, const Rect& rect) {
+        for (uint32_t y = rect.y; y < rect.bottom(); y++) {
+            for (uint32_t x = rect.x; x < rect.right(); x++) {
+                pixels[static_cast<size_t>(y) * width + x] = pixel_at(frame, x, y);
+            }
+        }
+    }
+
+    bool matches(const DesktopFrame& frame) const {
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                if (pixels[static_cast<size_t>(y) * width + x] != pixel_at(frame, x, y)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+}  // namespace
+
+TEST(FrameExchange, NothingBeforePublish) {
+    FrameExchange exchange;
+    EXPECT_EQ(exchange.acquire(), nullptr);
+    EXPECT_EQ(exchange.current(), nullptr);
+}
+
+TEST(FrameExchange, FirstFrameIsFullyDamaged) {
+    FrameExchange exchange;
+    Source src;
+    src.resize(64, 32);
+    src.fill(Rect{0, 0, 64, 32}, 7);
+
+    DamageRegion damage;
+    damage.add(Rect{1, 1, 2, 2});
+    src.publish(exchange, damage);
+
+    const DesktopFrame* frame = exchange.acquire();
+    ASSERT_NE(frame, nullptr);
+    EXPECT_EQ(frame->width, 64u);
+    EXPECT_EQ(frame->height, 32u);
+    EXPECT_EQ(frame->sequence, 1u);
+    EXPECT_EQ(frame->damage.bounds(), (Rect{0, 0, 64, 32}));
+    EXPECT_EQ(pixel_at(*frame, 63, 31), 7u);
+
+    // Already consumed
+    EXPECT_EQ(exchange.acquire(), nullptr);
+    EXPECT_EQ(exchange.current(), frame);
+}
+
+TEST(FrameExchange, TimestampsTravelWithTheFrame) {
+    FrameExchange exchange;
+    std::vector<uint32_t> pixels(16 * 16, 0);
+    auto received = std::chrono::steady_clock::now();
+    auto decoded = received + std::chrono::milliseconds(3);
+    exchange.publish(reinterpret_cast<const uint8_t*>(pixels.data()), 16, 16, 16 * 4,
+                     DamageRegion{}, received, decoded);
+
+    const DesktopFrame* frame = exchange.acquire();
+    ASSERT_NE(frame, nullptr);
+    EXPECT_EQ(frame->received, received);
+    EXPECT_EQ(frame->decoded, decoded);
+}
+
+TEST(FrameExchange, DroppedFramesMergeDamage) {
+    FrameExchange exchange;
+    Source src;
+    src.resize(100, 100);
+    src.publish(exchange, DamageRegion{});
+    ASSERT_NE(exchange.acquire(), nullptr);
+
+    // Three frames published without the consumer looking
+    for (uint32_t i = 0; i < 3; i++) {
+        Rect rect{i * 30, 0, 10, 10};
+        src.fill(rect, i + 1);
+        DamageRegion damage;
+        damage.add(rect);
+        src.publish(exchange, damage);
+    }
+
+    const DesktopFrame* frame = exchange.acquire();
+    ASSERT_NE(frame, nullptr);
+    EXPECT_EQ(frame->sequence, 4u);
+    EXPECT_EQ(frame->damage.rects().size(), 3u);
+    EXPECT_EQ(pixel_at(*frame, 0, 0), 1u);
+    EXPECT_EQ(pixel_at(*frame, 30, 0), 2u);
+    EXPECT_EQ(pixel_at(*frame, 60, 0), 3u);
+}
+
+TEST(FrameExchange, BackBufferCatchesUpOnMissedDamage) {
+    FrameExchange exchange;
+    Source src;
+    src.resize(50, 50);
+    src.publish(exchange, DamageRegion{});
+    Mirror mirror;
+
+    // Alternate consumption so every slot cycles through every role
+    for (uint32_t i = 1; i <= 30; i++) {
+        Rect rect{(i * 7) % 40, (i * 11) % 40, 10, 10};
+        src.fill(rect, i);
+        DamageRegion damage;
+        damage.add(rect);
+        src.publish(exchange, damage);
+        if (i % 3 != 0) {
+            const DesktopFrame* frame = exchange.acquire();
+            ASSERT_NE(frame, nullptr);
+            mirror.apply(*frame);
+            ASSERT_TRUE(mirror.matches(*frame)) << "frame " << frame->sequence;
+        }
+    }
+}
+
+// The RDP thread paints and resizes continuously while the main thread
+// consumes frames. Every acquired frame must be internally consistent (no
+// tearing) and a texture updated only with frame damage must stay in sync.
+TEST(FrameExchange, StressResizeWhilePainting) {
+    FrameExchange exchange;
+    std::atomic<bool> done{false};
+    constexpr uint32_t kFrames = 4000;
+
+    std::thread producer([&]() {
+        std::mt19937 rng(1234);
+        auto next = [&](uint32_t bound) { return static_cast<uint32_t>(rng() % bound); };
+        Source src;
+        src.resize(128, 96);
+        for (uint32_t seq = 1; seq <= kFrames; seq++) {
+            DamageRegion damage;
+            if (seq % 97 == 0) {
+                // Resize; contents after a GDI resize are undefined, we stamp them
+                src.resize(64 + next(192), 48 + next(144));
+                src.fill(Rect{0, 0, src.width, src.height}, seq);
+                damage.add(Rect{0, 0, src.width, src.height});
+            } else {
+                uint32_t w = 1 + next(src.width);
+                uint32_t h = 1 + next(src.height);
+                Rect rect{next(src.width - w + 1), next(src.height - h + 1), w, h};
+                src.fill(rect, seq);
+                damage.add(rect);
+            }
+            // Row 0 always carries the frame number, a torn frame would mix values
+            Rect marker{0, 0, src.width, 1};
+            src.fill(marker, seq);
+            damage.add(marker);
+            src.publish(exchange, damage);
+        }
+        done = true;
+    });
+
+    Mirror mirror;
+    uint64_t last_sequence = 0;
+    uint32_t acquired = 0;
+    bool ok = true;
+    while (ok) {
+        bool finished = done.load();
+        const DesktopFrame* frame = exchange.acquire();
+        if (frame) {
+            acquired++;
+            // No ASSERTs here: bailing out early would leave the producer unjoined
+            ok = frame->sequence > last_sequence && frame->stride >= frame->width * 4 &&
+                 frame->stride % kFrameRowAlignment == 0 &&
+                 frame->pixels.size() == static_cast<size_t>(frame->stride) * frame->height;
+            last_sequence = frame->sequence;
+            for (uint32_t x = 0; x < frame->width && ok; x++) {
+                ok = pixel_at(*frame, x, 0) == frame->sequence;
+            }
+            mirror.apply(*frame);
+            ok = ok && mirror.matches(*frame);
+        } else if (finished) {
+            break;
+        }
+    }
+    producer.join();
+
+    EXPECT_TRUE(ok) << "inconsistent frame at sequence " << last_sequence;
+    EXPECT_EQ(last_sequence, kFrames);
+    EXPECT_GT(acquired, 0u);
+}
@@ -0,0 +1,73 @@
+#include "core/frame_stats.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+using namespace gvrdp;
+using namespace std::chrono_literals;
+
+TEST(FrameStatsTest, RecordsEachStage) {
+    FrameStats stats;
+    auto received = FrameStats::Clock::now();
+    stats.record_uploaded(received, received + 2ms, received + 3ms);
+    stats.record_presented(received + 10ms);
+
+    EXPECT_EQ(stats.frames(), 1u);
+    EXPECT_EQ(stats.dropped(), 0u);
+    EXPECT_EQ(stats.stage(FrameStage::Decode).percentile(0.5), 2ms);
+    EXPECT_EQ(stats.stage(FrameStage::Upload).percentile(0.5), 1ms);
+    EXPECT_EQ(stats.stage(FrameStage::Present).percentile(0.5), 7ms);
+    EXPECT_EQ(stats.stage(FrameStage::Total).percentile(0.5), 10ms);
+}
+
+TEST(FrameStatsTest, FramesWithoutTimestampsOnlyCount) {
+    FrameStats stats;
+    auto now = FrameStats::Clock::now();
+    stats.record_uploaded({}, {}, now);
+    stats.record_presented(now);
+    EXPECT_EQ(stats.frames(), 1u);
+    EXPECT_EQ(stats.stage(FrameStage::Total).count(), 0u);
+}
+
+TEST(FrameStatsTest, FramesShownTogetherCountAsDropped) {
+    FrameStats stats;
+    auto start = FrameStats::Clock::now();
+    for (int i = 0; i < 3; i++) {
+        auto received = start + i * 1ms;
+        stats.record_uploaded(received, received, received);
+    }
+    stats.record_presented(start + 5ms);
+
+    EXPECT_EQ(stats.frames(), 3u);
+    EXPECT_EQ(stats.dropped(), 2u);
+    // Each still has its own latency: 5, 4 and 3 ms
+    EXPECT_EQ(stats.stage(FrameStage::Total).count(), 3u);
+    EXPECT_EQ(stats.stage(FrameStage::Total).max(), 5ms);
+
+    // Nothing new: a present without frames records nothing
+    stats.record_presented(start + 20ms);
+    EXPECT_EQ(stats.frames(), 3u);
+    EXPECT_EQ(stats.stage(FrameStage::Total).count(), 3u);
+}
+
+TEST(FrameStatsTest, SequenceGapsAreDroppedFrames) {
+    FrameStats stats;
+    stats.record_sequence(1);
+    stats.record_sequence(2);
+    stats.record_sequence(5);
+    EXPECT_EQ(stats.dropped(), 2u);
+
+    // A new session starts counting again
+    stats.reset();
+    stats.record_sequence(9);
+    EXPECT_EQ(stats.dropped(), 0u);
+}
+
+TEST(FrameStatsTest, DirtyPixelsAccumulate) {
+    FrameStats stats;
+    stats.record_dirty(100, 1000);
+    stats.record_dirty(300, 1000);
+    EXPECT_EQ(stats.dirty_pixels(), 400u);
+    EXPECT_EQ(stats.desktop_pixels(), 2000u);
+}
@@ -0,0 +1,67 @@
+#include "util/histogram.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+using namespace gvrdp;
+using std::chrono::microseconds;
+
+TEST(LatencyHistogramTest, EmptyHistogramReportsZero) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.count(), 0u);
+    EXPECT_EQ(histogram.percentile(0.5), microseconds(0));
+    EXPECT_EQ(histogram.percentile(0.99), microseconds(0));
+}
+
+TEST(LatencyHistogramTest, BucketsCoverValuesWithBoundedError) {
+    // Every value lands in a bucket whose upper bound is at most 12.5% above it
+    for (uint64_t us = 0; us < 1000000; us = us < 64 ? us + 1 : us * 17 / 16) {
+        size_t bucket = LatencyHistogram::bucket_of(us);
+        uint64_t upper = LatencyHistogram::bucket_upper(bucket);
+        ASSERT_GE(upper, us);
+        ASSERT_LE(upper, us + us / 8 + 1) << us;
+        if (bucket > 0) {
+            ASSERT_LT(LatencyHistogram::bucket_upper(bucket - 1), us);
+        }
+    }
+}
+
+TEST(LatencyHistogramTest, HugeValuesLandInTheLastBucket) {
+    EXPECT_EQ(LatencyHistogram::bucket_of(UINT64_MAX / 2), LatencyHistogram::kBuckets - 1);
+    LatencyHistogram histogram;
+    histogram.record(std::chrono::hours(1));
+    EXPECT_EQ(histogram.count(), 1u);
+    EXPECT_EQ(histogram.max(), std::chrono::hours(1));
+}
+
+TEST(LatencyHistogramTest, PercentilesOfAUniformSpread) {
+    LatencyHistogram histogram;
+    for (int ms = 1; ms <= 100; ms++) {
+        histogram.record(std::chrono::milliseconds(ms));
+    }
+    EXPECT_EQ(histogram.count(), 100u);
+
+    auto p50 = histogram.percentile(0.5).count();
+    EXPECT_GE(p50, 50000);
+    EXPECT_LE(p50, 50000 * 9 / 8);
+    auto p99 = histogram.percentile(0.99).count();
+    EXPECT_GE(p99, 99000);
+    EXPECT_LE(p99, 100000);  // Capped at the largest sample
+    EXPECT_EQ(histogram.percentile(1.0), std::chrono::milliseconds(100));
+}
+
+TEST(LatencyHistogramTest, SinceGivesTheRecentWindow) {
+    LatencyHistogram histogram;
+    for (int i = 0; i < 100; i++) histogram.record(microseconds(10));
+    LatencyHistogram earlier = histogram;
+    for (int i = 0; i < 10; i++) histogram.record(microseconds(5000));
+
+    LatencyHistogram window = histogram.since(earlier);
+    EXPECT_EQ(window.count(), 10u);
+    EXPECT_GE(window.percentile(0.5).count(), 5000);
+
+    histogram.reset();
+    EXPECT_EQ(histogram.count(), 0u);
+    EXPECT_EQ(histogram.max(), microseconds(0));
+}
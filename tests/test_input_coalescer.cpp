@@ -0,0 +1,97 @@
+#include "input/input_coalescer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <vector>
+
+using namespace gvrdp;
+using namespace std::chrono_literals;
+
+namespace {
+
+// What reaches the server, in order: a position or an ordered event (click)
+struct Sent {
+    bool click;
+    PointerPosition position;
+
+    bool operator==(const Sent&) const = default;
+};
+
+}  // namespace
+
+TEST(InputCoalescerTest, DisabledPassesEveryMotionThrough) {
+    InputCoalescer coalescer(false);
+    EXPECT_EQ(coalescer.motion(1, 2), (PointerPosition{1, 2}));
+    EXPECT_EQ(coalescer.motion(3, 4), (PointerPosition{3, 4}));
+    EXPECT_FALSE(coalescer.has_pending());
+    EXPECT_FALSE(coalescer.flush(InputCoalescer::Clock::now()).has_value());
+}
+
+TEST(InputCoalescerTest, MotionCollapsesToLatestPerTick) {
+    InputCoalescer coalescer;
+    auto now = InputCoalescer::Clock::now();
+    for (uint16_t i = 0; i < 10; i++) {
+        EXPECT_FALSE(coalescer.motion(i, i).has_value());
+    }
+    EXPECT_EQ(coalescer.flush(now), (PointerPosition{9, 9}));
+    EXPECT_EQ(coalescer.coalesced(), 9u);
+    EXPECT_FALSE(coalescer.flush(now).has_value());
+}
+
+TEST(InputCoalescerTest, HeldMotionGoesBeforeOrderedEvents) {
+    // move, move, click, move, click, move: the server must see each click
+    // after the last move that preceded it
+    InputCoalescer coalescer;
+    std::vector<Sent> sent;
+    auto click = [&](uint16_t x, uint16_t y) {
+        if (auto held = coalescer.take()) sent.push_back({false, *held});
+        sent.push_back({true, {x, y}});
+    };
+
+    coalescer.motion(1, 1);
+    coalescer.motion(2, 2);
+    click(2, 2);
+    coalescer.motion(5, 5);
+    click(6, 6);
+    coalescer.motion(7, 7);
+    if (auto held = coalescer.flush(InputCoalescer::Clock::now())) {
+        sent.push_back({false, *held});
+    }
+
+    std::vector<Sent> expected = {
+        {false, {2, 2}}, {true, {2, 2}}, {false, {5, 5}}, {true, {6, 6}}, {false, {7, 7}},
+    };
+    EXPECT_EQ(sent, expected);
+}
+
+TEST(InputCoalescerTest, MinimumIntervalHoldsMotionUntilDue) {
+    InputCoalescer coalescer(true, 4000us);
+    auto start = InputCoalescer::Clock::now();
+
+    // Nothing sent yet: due right away
+    coalescer.motion(1, 1);
+    EXPECT_EQ(coalescer.time_until_deadline(start), InputCoalescer::Duration::zero());
+    EXPECT_EQ(coalescer.flush(start), (PointerPosition{1, 1}));
+    EXPECT_FALSE(coalescer.time_until_deadline(start).has_value());
+
+    coalescer.motion(2, 2);
+    EXPECT_FALSE(coalescer.flush(start + 1ms).has_value());
+    EXPECT_EQ(coalescer.time_until_deadline(start + 1ms), 3000us);
+
+    coalescer.motion(3, 3);
+    EXPECT_EQ(coalescer.flush(start + 4ms), (PointerPosition{3, 3}));
+    EXPECT_FALSE(coalescer.has_pending());
+}
+
+TEST(InputCoalescerTest, TakeIgnoresTheInterval) {
+    // An ordered event never waits for the motion before it
+    InputCoalescer coalescer(true, 1s);
+    auto now = InputCoalescer::Clock::now();
+    coalescer.motion(1, 1);
+    coalescer.flush(now);
+    coalescer.motion(2, 2);
+    EXPECT_FALSE(coalescer.flush(now).has_value());
+    EXPECT_EQ(coalescer.take(), (PointerPosition{2, 2}));
+    EXPECT_FALSE(coalescer.take().has_value());
+}
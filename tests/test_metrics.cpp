@@ -0,0 +1,123 @@
+#include "util/metrics.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gvrdp;
+
+namespace {
+
+bool contains(const std::string& text, const std::string& needle) {
+    return text.find(needle) != std::string::npos;
+}
+
+}  // namespace
+
+TEST(MetricsTest, SameNameAndLabelsIsTheSameMetric) {
+    Metrics metrics;
+    Counter& a = metrics.counter("bytes_total", "Bytes", {{"channel", "disp"}});
+    Counter& b = metrics.counter("bytes_total", "Bytes", {{"channel", "disp"}});
+    Counter& c = metrics.counter("bytes_total", "Bytes", {{"channel", "cliprdr"}});
+    EXPECT_EQ(&a, &b);
+    EXPECT_NE(&a, &c);
+}
+
+TEST(MetricsTest, CountersAreExactUnderContention) {
+    Metrics metrics;
+    Counter& counter = metrics.counter("events_total", "Events");
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&counter] {
+            for (int i = 0; i < 10000; i++) counter.add();
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(counter.value(), 40000u);
+}
+
+TEST(MetricsTest, HistogramBucketsByUpperBound) {
+    Histogram histogram;
+    histogram.observe(std::chrono::microseconds(100));   // le 100 µs
+    histogram.observe(std::chrono::microseconds(101));   // le 250 µs
+    histogram.observe(std::chrono::milliseconds(3));     // le 5 ms
+    histogram.observe(std::chrono::seconds(2));          // +Inf
+    EXPECT_EQ(histogram.count(), 4u);
+    EXPECT_EQ(histogram.bucket(0), 1u);
+    EXPECT_EQ(histogram.bucket(1), 1u);
+    EXPECT_EQ(histogram.bucket(5), 1u);
+    EXPECT_EQ(histogram.bucket(Histogram::kBoundsUs.size()), 1u);
+    EXPECT_EQ(histogram.sum(), std::chrono::microseconds(2003201));
+}
+
+TEST(MetricsTest, PrometheusTextGroupsFamilies) {
+    Metrics metrics;
+    metrics.counter("gvrdp_channel_bytes_total", "Channel bytes", {{"channel", "disp"}}).add(5);
+    metrics.gauge("gvrdp_rtt_milliseconds", "RTT").set(42);
+    metrics.counter("gvrdp_channel_bytes_total", "Channel bytes", {{"channel", "a\"b"}}).add(7);
+    metrics.histogram("gvrdp_present_seconds", "Present")
+        .observe(std::chrono::microseconds(300));
+
+    std::string text = metrics.prometheus();
+    EXPECT_TRUE(contains(text, "# HELP gvrdp_channel_bytes_total Channel bytes\n"
+                               "# TYPE gvrdp_channel_bytes_total counter\n"
+                               "gvrdp_channel_bytes_total{channel=\"disp\"} 5\n"
+                               "gvrdp_channel_bytes_total{channel=\"a\\\"b\"} 7\n"));
+    EXPECT_TRUE(contains(text, "# TYPE gvrdp_rtt_milliseconds gauge\ngvrdp_rtt_milliseconds 42\n"));
+    EXPECT_TRUE(contains(text, "gvrdp_present_seconds_bucket{le=\"0.00025\"} 0\n"));
+    EXPECT_TRUE(contains(text, "gvrdp_present_seconds_bucket{le=\"0.0005\"} 1\n"));
+    EXPECT_TRUE(contains(text, "gvrdp_present_seconds_bucket{le=\"+Inf\"} 1\n"));
+    EXPECT_TRUE(contains(text, "gvrdp_present_seconds_sum 0.000300\n"));
+    EXPECT_TRUE(contains(text, "gvrdp_present_seconds_count 1\n"));
+}
+
+TEST(MetricsTest, JsonListsEveryMetric) {
+    Metrics metrics;
+    metrics.counter("frames_total", "Frames").add(3);
+    metrics.histogram("decode_seconds", "Decode", {{"codec", "Planar"}})
+        .observe(std::chrono::microseconds(50));
+
+    std::string json = metrics.json();
+    EXPECT_EQ(json.rfind("{\"timestamp_ms\":", 0), 0u);
+    EXPECT_TRUE(contains(json, "{\"name\":\"frames_total\",\"labels\":{},"
+                               "\"type\":\"counter\",\"value\":3}"));
+    EXPECT_TRUE(contains(json, "\"labels\":{\"codec\":\"Planar\"},\"type\":\"histogram\","
+                               "\"count\":1,\"sum_seconds\":0.000050,\"buckets_us\":[[100,1],"));
+    EXPECT_TRUE(contains(json, "[null,0]]}"));
+}
+
+TEST(MetricsTest, WriterWritesBothFilesOnSchedule) {
+    auto dir = std::filesystem::temp_directory_path() / "gvrdp_metrics_test";
+    std::filesystem::remove_all(dir);
+
+    Metrics metrics;
+    metrics.counter("frames_total", "Frames").add(1);
+    MetricsWriter writer(metrics, dir, std::chrono::seconds(10));
+    auto now = MetricsWriter::Clock::now();
+    EXPECT_GT(writer.time_until_due(now).count(), 0);
+    EXPECT_TRUE(writer.poll(now));
+    EXPECT_FALSE(std::filesystem::exists(dir / "metrics.json"));
+
+    auto later = now + std::chrono::seconds(11);
+    EXPECT_EQ(writer.time_until_due(later).count(), 0);
+    EXPECT_TRUE(writer.poll(later));
+    ASSERT_TRUE(std::filesystem::exists(dir / "metrics.json"));
+    ASSERT_TRUE(std::filesystem::exists(dir / "metrics.prom"));
+    EXPECT_FALSE(std::filesystem::exists(dir / "metrics.prom.tmp"));
+
+    std::ifstream file(dir / "metrics.prom");
+    std::string text((std::istreambuf_iterator<char>(file)), {});
+    EXPECT_TRUE(contains(text, "frames_total 1\n"));
+    EXPECT_TRUE(contains(text, "# TYPE gvrdp_resident_memory_bytes gauge\n"));
+    std::filesystem::remove_all(dir);
+}
+
+TEST(MetricsTest, ResidentMemoryIsReported) {
+    EXPECT_GT(resident_memory_bytes(), 0u);
+}
@@ -0,0 +1,182 @@
+#include "core/persistent_cache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace gvrdp;
+
+namespace {
+
+std::vector<uint8_t> make_pixels(uint16_t width, uint16_t height, uint8_t seed) {
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    for (size_t i = 0; i < pixels.size(); i++) {
+        pixels[i] = static_cast<uint8_t>(seed + i * 7);
+    }
+    return pixels;
+}
+
+class PersistentCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() /
+               (std::string("gvrdp_cache_test_") +
+                ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        std::filesystem::remove_all(dir_);
+        path_ = PersistentCache::path_for(dir_, "desktop.example.com", 3389);
+    }
+    void TearDown() override { std::filesystem::remove_all(dir_); }
+
+    std::filesystem::path dir_;
+    std::filesystem::path path_;
+};
+
+}  // namespace
+
+TEST_F(PersistentCacheTest, PathIsPerHostAndFilenameSafe) {
+    auto a = PersistentCache::path_for(dir_, "Host:1/../x", 3389);
+    auto b = PersistentCache::path_for(dir_, "host:1/../x", 3390);
+    EXPECT_EQ(a.parent_path(), dir_);
+    EXPECT_EQ(a.filename(), "host_1_.._x_3389.gvc");
+    EXPECT_NE(a, b);
+}
+
+TEST_F(PersistentCacheTest, MissingFileIsEmpty) {
+    PersistentCache cache(path_, 1 << 20);
+    EXPECT_EQ(cache.size(), 0u);
+    EXPECT_TRUE(cache.offer(100, 1 << 20).empty());
+}
+
+TEST_F(PersistentCacheTest, EntriesSurviveSaveAndReopen) {
+    auto pixels = make_pixels(16, 8, 1);
+    {
+        PersistentCache cache(path_, 1 << 20);
+        cache.put(42, 16, 8, pixels.data(), 16 * 4);
+        ASSERT_TRUE(cache.save());
+        EXPECT_FALSE(std::filesystem::exists(path_.string() + ".tmp"));
+    }
+
+    PersistentCache cache(path_, 1 << 20);
+    ASSERT_EQ(cache.size(), 1u);
+    CachedBitmap bitmap;
+    ASSERT_TRUE(cache.find(42, bitmap));
+    EXPECT_EQ(bitmap.width, 16);
+    EXPECT_EQ(bitmap.height, 8);
+    EXPECT_EQ(std::vector<uint8_t>(bitmap.pixels, bitmap.pixels + bitmap.size()), pixels);
+    EXPECT_FALSE(cache.find(43, bitmap));
+}
+
+TEST_F(PersistentCacheTest, PutHonoursStride) {
+    // 2x2 bitmap inside rows of 3 pixels
+    std::vector<uint8_t> source(3 * 4 * 2, 0);
+    for (int i = 0; i < 8; i++) {
+        source[i] = static_cast<uint8_t>(i + 1);
+        source[12 + i] = static_cast<uint8_t>(i + 101);
+    }
+    PersistentCache cache(path_, 1 << 20);
+    cache.put(7, 2, 2, source.data(), 12);
+
+    CachedBitmap bitmap;
+    ASSERT_TRUE(cache.find(7, bitmap));
+    EXPECT_EQ(bitmap.pixels[0], 1);
+    EXPECT_EQ(bitmap.pixels[7], 8);
+    EXPECT_EQ(bitmap.pixels[8], 101);
+    EXPECT_EQ(bitmap.pixels[15], 108);
+}
+
+TEST_F(PersistentCacheTest, OfferIsMostRecentlyUsedFirstAndBounded) {
+    auto pixels = make_pixels(4, 4, 0);  // 64 bytes each
+    {
+        PersistentCache cache(path_, 1 << 20);
+        for (uint64_t key = 1; key <= 4; key++) {
+            cache.put(key, 4, 4, pixels.data(), 16);
+        }
+        ASSERT_TRUE(cache.save());
+    }
+    {
+        // Next session only uses key 3
+        PersistentCache cache(path_, 1 << 20);
+        CachedBitmap bitmap;
+        ASSERT_TRUE(cache.find(3, bitmap));
+        ASSERT_TRUE(cache.save());
+    }
+
+    PersistentCache cache(path_, 1 << 20);
+    auto offer = cache.offer(10, 1 << 20);
+    ASSERT_EQ(offer.size(), 4u);
+    EXPECT_EQ(offer[0].key, 3u);
+
+    EXPECT_EQ(cache.offer(2, 1 << 20).size(), 2u);
+    EXPECT_EQ(cache.offer(10, 64 * 3).size(), 3u);
+}
+
+TEST_F(PersistentCacheTest, SaveEvictsLeastRecentlyUsedToTheLimit) {
+    auto pixels = make_pixels(4, 4, 0);  // 64 bytes each
+    {
+        PersistentCache cache(path_, 1 << 20);
+        cache.put(1, 4, 4, pixels.data(), 16);
+        cache.put(2, 4, 4, pixels.data(), 16);
+        ASSERT_TRUE(cache.save());
+    }
+    {
+        // Room for two: the unused old entry goes
+        PersistentCache cache(path_, 128);
+        CachedBitmap bitmap;
+        ASSERT_TRUE(cache.find(2, bitmap));
+        cache.put(3, 4, 4, pixels.data(), 16);
+        ASSERT_TRUE(cache.save());
+        EXPECT_EQ(cache.size(), 2u);
+        EXPECT_EQ(cache.bytes(), 128u);
+    }
+
+    PersistentCache cache(path_, 128);
+    CachedBitmap bitmap;
+    EXPECT_FALSE(cache.find(1, bitmap));
+    EXPECT_TRUE(cache.find(2, bitmap));
+    EXPECT_TRUE(cache.find(3, bitmap));
+}
+
+TEST_F(PersistentCacheTest, ForeignOrTruncatedFileIsIgnored) {
+    std::filesystem::create_directories(dir_);
+    {
+        std::ofstream file(path_, std::ios::binary);
+        file << "not a cache file";
+    }
+    PersistentCache cache(path_, 1 << 20);
+    EXPECT_EQ(cache.size(), 0u);
+
+    auto pixels = make_pixels(4, 4, 9);
+    cache.put(5, 4, 4, pixels.data(), 16);
+    ASSERT_TRUE(cache.save());
+
+    // Cut the file inside the pixel data: the entry no longer fits
+    auto size = std::filesystem::file_size(path_);
+    std::filesystem::resize_file(path_, size - 10);
+    PersistentCache truncated(path_, 1 << 20);
+    EXPECT_EQ(truncated.size(), 0u);
+}
+
+TEST_F(PersistentCacheTest, CorruptPixelsAreDroppedOnLookup) {
+    auto pixels = make_pixels(4, 4, 3);
+    {
+        PersistentCache cache(path_, 1 << 20);
+        cache.put(9, 4, 4, pixels.data(), 16);
+        ASSERT_TRUE(cache.save());
+    }
+    {
+        // Flip the last pixel byte
+        std::fstream file(path_, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-1, std::ios::end);
+        file.put(static_cast<char>(pixels.back() ^ 0xFF));
+    }
+
+    PersistentCache cache(path_, 1 << 20);
+    EXPECT_EQ(cache.size(), 1u);
+    CachedBitmap bitmap;
+    EXPECT_FALSE(cache.find(9, bitmap));
+    EXPECT_EQ(cache.size(), 0u);
+}
@@ -0,0 +1,168 @@
+#include "render/pointer_shape.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+using namespace gvrdp;
+
+namespace {
+
+size_t stride(uint32_t width, uint32_t bpp) {
+    return ((static_cast<size_t>(width) * bpp + 15) / 16) * 2;
+}
+
+// Masks with every pixel set by `pixel(x, y)` (top-down coordinates)
+struct Masks {
+    uint32_t width;
+    uint32_t height;
+    uint32_t bpp;
+    std::vector<uint8_t> xor_mask;
+    std::vector<uint8_t> and_mask;
+
+    Masks(uint32_t w, uint32_t h, uint32_t b)
+        : width(w),
+          height(h),
+          bpp(b),
+          xor_mask(stride(w, b) * h),
+          and_mask(stride(w, 1) * h) {}
+
+    uint8_t* xor_row(uint32_t y) { return xor_mask.data() + (height - 1 - y) * stride(width, bpp); }
+
+    void set_and(uint32_t x, uint32_t y) {
+        and_mask[(height - 1 - y) * stride(width, 1) + x / 8] |= 0x80 >> (x % 8);
+    }
+    void set_xor_bit(uint32_t x, uint32_t y) { xor_row(y)[x / 8] |= 0x80 >> (x % 8); }
+
+    PointerMasks view() const {
+        PointerMasks m;
+        m.width = width;
+        m.height = height;
+        m.xor_bpp = bpp;
+        m.xor_mask = xor_mask.data();
+        m.xor_length = xor_mask.size();
+        m.and_mask = and_mask.data();
+        m.and_length = and_mask.size();
+        return m;
+    }
+};
+
+std::vector<uint32_t> convert(const PointerMasks& masks) {
+    std::vector<uint32_t> out(static_cast<size_t>(masks.width) * masks.height, 0xDEADBEEF);
+    EXPECT_TRUE(convert_pointer(masks, out.data()));
+    return out;
+}
+
+}  // namespace
+
+TEST(PointerShape, MonoCoversAllFourCombinations) {
+    // Width 19: two SIMD blocks and a scalar tail
+    Masks m(19, 3, 1);
+    for (uint32_t y = 0; y < 3; y++) {
+        for (uint32_t x = 0; x < 19; x++) {
+            if (x % 2) m.set_and(x, y);
+            if ((x / 2) % 2) m.set_xor_bit(x, y);
+        }
+    }
+    auto out = convert(m.view());
+    for (uint32_t y = 0; y < 3; y++) {
+        for (uint32_t x = 0; x < 19; x++) {
+            bool and_bit = x % 2;
+            bool xor_bit = (x / 2) % 2;
+            uint32_t expected = !and_bit ? (xor_bit ? 0xFFFFFFFF : 0xFF000000)
+                                         : (xor_bit ? 0xFF000000 : 0x00000000);
+            EXPECT_EQ(out[y * 19 + x], expected) << x << "," << y;
+        }
+    }
+}
+
+TEST(PointerShape, RowsAreFlipped) {
+    Masks m(8, 2, 1);
+    m.set_xor_bit(0, 0);  // Top row white, bottom row black
+    auto out = convert(m.view());
+    EXPECT_EQ(out[0], 0xFFFFFFFFu);
+    EXPECT_EQ(out[8], 0xFF000000u);
+}
+
+TEST(PointerShape, Rgb565ExpandsToFullRange) {
+    Masks m(11, 1, 16);
+    const uint16_t colors[] = {0xF800, 0x07E0, 0x001F, 0xFFFF, 0x0000, 0x8410};
+    const uint32_t expected[] = {0xFFFF0000, 0xFF00FF00, 0xFF0000FF,
+                                 0xFFFFFFFF, 0xFF000000, 0xFF848284};
+    for (uint32_t x = 0; x < 11; x++) {
+        uint16_t c = colors[x % 6];
+        m.xor_row(0)[x * 2] = static_cast<uint8_t>(c);
+        m.xor_row(0)[x * 2 + 1] = static_cast<uint8_t>(c >> 8);
+    }
+    auto out = convert(m.view());
+    for (uint32_t x = 0; x < 11; x++) {
+        EXPECT_EQ(out[x], expected[x % 6]) << x;
+    }
+}
+
+TEST(PointerShape, Bgr24UsesAndMaskForTransparency) {
+    Masks m(10, 1, 24);
+    uint8_t* row = m.xor_row(0);
+    row[0] = 0x30, row[1] = 0x20, row[2] = 0x10;  // Pixel 0: opaque color
+    m.set_and(1, 0);                              // Pixel 1: transparent
+    row[6] = 0xFF;                                // Pixel 2: inverted
+    m.set_and(2, 0);
+    m.set_and(9, 0);  // Scalar tail
+    auto out = convert(m.view());
+    EXPECT_EQ(out[0], 0xFF102030u);
+    EXPECT_EQ(out[1], 0x00000000u);
+    EXPECT_EQ(out[2], 0xFF000000u);
+    EXPECT_EQ(out[3], 0xFF000000u);
+    EXPECT_EQ(out[9], 0x00000000u);
+}
+
+TEST(PointerShape, Bgra32KeepsAlpha) {
+    Masks m(5, 1, 32);
+    uint8_t* row = m.xor_row(0);
+    for (uint32_t x = 0; x < 5; x++) {
+        row[x * 4] = 0x11;
+        row[x * 4 + 1] = 0x22;
+        row[x * 4 + 2] = 0x33;
+        row[x * 4 + 3] = static_cast<uint8_t>(x * 0x40);
+    }
+    m.set_and(1, 0);  // Ignored: alpha wins
+    auto out = convert(m.view());
+    for (uint32_t x = 0; x < 5; x++) {
+        EXPECT_EQ(out[x], (x * 0x40u) << 24 | 0x332211u) << x;
+    }
+}
+
+TEST(PointerShape, Bgra32WithoutAlphaUsesAndMask) {
+    Masks m(9, 1, 32);
+    for (uint32_t x = 0; x < 9; x++) m.xor_row(0)[x * 4] = 0x80;
+    m.set_and(8, 0);
+    PointerMasks view = m.view();
+    auto out = convert(view);
+    EXPECT_EQ(out[0], 0xFF000080u);
+    EXPECT_EQ(out[8], 0xFF000000u);  // AND over color: inverted
+
+    view.and_mask = nullptr;
+    view.and_length = 0;
+    out = convert(view);
+    EXPECT_EQ(out[8], 0xFF000080u);
+}
+
+TEST(PointerShape, RejectsUnsupportedAndTruncatedMasks) {
+    std::vector<uint32_t> out(64);
+    Masks palette(8, 8, 8);
+    EXPECT_FALSE(convert_pointer(palette.view(), out.data()));
+
+    Masks mono(8, 8, 1);
+    PointerMasks truncated = mono.view();
+    truncated.xor_length -= 1;
+    EXPECT_FALSE(convert_pointer(truncated, out.data()));
+
+    PointerMasks no_and = mono.view();
+    no_and.and_mask = nullptr;
+    EXPECT_FALSE(convert_pointer(no_and, out.data()));
+
+    PointerMasks empty = mono.view();
+    empty.width = 0;
+    EXPECT_FALSE(convert_pointer(empty, out.data()));
+}
@@ -0,0 +1,200 @@
+#include "channels/disp_channel.hpp"
+#include "core/resize_controller.hpp"
+
+#include <freerdp/channels/disp.h>
+#include <freerdp/client/disp.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <optional>
+#include <vector>
+
+using namespace gvrdp;
+using namespace std::chrono_literals;
+
+namespace {
+
+using Clock = ResizeController::Clock;
+
+// Stands in for the DISP channel: records every layout the client sends
+struct FakeDisp {
+    DispClientContext context{};
+    std::vector<DISPLAY_CONTROL_MONITOR_LAYOUT> layouts;
+
+    FakeDisp() {
+        context.custom = this;
+        context.SendMonitorLayout = [](DispClientContext* ctx, UINT32 count,
+                                       DISPLAY_CONTROL_MONITOR_LAYOUT* monitors) -> UINT {
+            auto* self = static_cast<FakeDisp*>(ctx->custom);
+            for (UINT32 i = 0; i < count; i++) self->layouts.push_back(monitors[i]);
+            return CHANNEL_RC_OK;
+        };
+    }
+};
+
+// A server that applies each layout `rtt` after it arrives
+struct FakeServer {
+    explicit FakeServer(std::chrono::milliseconds round_trip) : rtt(round_trip) {}
+
+    std::chrono::milliseconds rtt;
+    std::optional<std::pair<Clock::time_point, DISPLAY_CONTROL_MONITOR_LAYOUT>> pending;
+    bool overlapped = false;  // A layout arrived while another was pending
+
+    void receive(const DISPLAY_CONTROL_MONITOR_LAYOUT& layout, Clock::time_point now) {
+        if (pending) overlapped = true;
+        pending = {{now + rtt, layout}};
+    }
+
+    void step(ResizeController& controller, Clock::time_point now) {
+        if (pending && now >= pending->first) {
+            controller.on_desktop_resize(pending->second.Width, pending->second.Height, now);
+            pending.reset();
+        }
+    }
+};
+
+}  // namespace
+
+TEST(ResizeController, StormSendsFewLayoutsAndEndsAtFinalSize) {
+    FakeDisp disp;
+    DispChannel channel;
+    channel.on_connected(&disp.context);
+
+    Clock::time_point now{};
+    FakeServer server(150ms);
+    size_t seen = 0;
+    ResizeController controller(
+        [&](uint32_t w, uint32_t h) { return channel.send_layout(w, h); });
+    controller.set_desktop_size(800, 600);
+
+    // A 600 ms drag: a new size every 5 ms, ending at an odd size
+    for (int ms = 0; ms < 3000; ms++, now += 1ms) {
+        if (ms <= 600 && ms % 5 == 0) {
+            controller.request(800 + ms, 600 + ms / 2, now);
+        }
+        if (ms == 600) controller.request(1401, 901, now);
+        controller.poll(now);
+        while (seen < disp.layouts.size()) server.receive(disp.layouts[seen++], now);
+        server.step(controller, now);
+    }
+
+    ASSERT_FALSE(disp.layouts.empty());
+    EXPECT_LE(disp.layouts.size(), 4u);  // Not one per window event
+    EXPECT_EQ(disp.layouts.size(), controller.layouts_sent());
+    EXPECT_FALSE(server.overlapped);
+    EXPECT_EQ(disp.layouts.back().Width, 1400u);
+    EXPECT_EQ(disp.layouts.back().Height, 900u);
+    EXPECT_FALSE(controller.in_flight());
+    EXPECT_FALSE(controller.time_until_deadline(now).has_value());
+}
+
+TEST(ResizeController, SizeRequestedWhileInFlightIsSentAfterConfirmation) {
+    std::vector<std::pair<uint32_t, uint32_t>> sent;
+    ResizeController controller([&](uint32_t w, uint32_t h) {
+        sent.emplace_back(w, h);
+        return true;
+    });
+    controller.set_desktop_size(800, 600);
+
+    Clock::time_point now{};
+    controller.request(1000, 700, now);
+    controller.poll(now + 200ms);
+    ASSERT_EQ(sent.size(), 1u);
+    EXPECT_TRUE(controller.in_flight());
+
+    // Arrives while the first is in flight: held, not dropped
+    controller.request(1200, 800, now + 250ms);
+    controller.poll(now + 1000ms);
+    EXPECT_EQ(sent.size(), 1u);
+
+    controller.on_desktop_resize(1000, 700, now + 1100ms);
+    controller.poll(now + 1100ms);
+    ASSERT_EQ(sent.size(), 2u);
+    EXPECT_EQ(sent[1], std::make_pair(1200u, 800u));
+}
+
+TEST(ResizeController, DebounceFollowsRoundTrip) {
+    auto measure = [](std::chrono::milliseconds rtt) {
+        ResizeController controller([](uint32_t, uint32_t) { return true; });
+        Clock::time_point now{};
+        for (uint32_t i = 0; i < 20; i++) {
+            controller.request(1000 + i * 2, 700, now);
+            now += controller.debounce();
+            controller.poll(now);
+            now += rtt;
+            controller.on_desktop_resize(1000 + i * 2, 700, now);
+        }
+        return controller.debounce();
+    };
+
+    EXPECT_EQ(ResizeController([](uint32_t, uint32_t) { return true; }).debounce(), 200ms);
+    EXPECT_EQ(measure(10ms), 50ms);    // LAN: floor
+    EXPECT_EQ(measure(120ms), 120ms);  // In between: the round trip
+    EXPECT_EQ(measure(900ms), 500ms);  // Slow link: ceiling
+}
+
+TEST(ResizeController, UnansweredLayoutTimesOut) {
+    int sends = 0;
+    ResizeController controller([&](uint32_t, uint32_t) {
+        sends++;
+        return true;
+    });
+    Clock::time_point now{};
+    controller.request(1000, 700, now);
+    controller.poll(now + 200ms);
+    controller.request(1100, 700, now + 300ms);
+    EXPECT_EQ(controller.time_until_deadline(now + 300ms), 2900ms);
+
+    controller.poll(now + 3200ms);
+    EXPECT_EQ(sends, 2);
+    EXPECT_FALSE(controller.round_trip().has_value());
+}
+
+TEST(ResizeController, SkipsTheCurrentDesktopSize) {
+    int sends = 0;
+    ResizeController controller([&](uint32_t, uint32_t) {
+        sends++;
+        return true;
+    });
+    controller.set_desktop_size(1280, 720);
+    Clock::time_point now{};
+    controller.request(1281, 721, now);  // Layouts are even: same size
+    controller.poll(now + 1s);
+    EXPECT_EQ(sends, 0);
+    EXPECT_FALSE(controller.time_until_deadline(now + 1s).has_value());
+}
+
+TEST(ResizeController, RetriesAFailedSend) {
+    bool channel_up = false;
+    int sends = 0;
+    ResizeController controller([&](uint32_t, uint32_t) {
+        if (!channel_up) return false;
+        sends++;
+        return true;
+    });
+    Clock::time_point now{};
+    controller.request(1000, 700, now);
+    controller.poll(now + 200ms);
+    EXPECT_FALSE(controller.in_flight());
+    EXPECT_EQ(controller.time_until_deadline(now + 200ms), 200ms);
+
+    channel_up = true;
+    controller.poll(now + 400ms);
+    EXPECT_EQ(sends, 1);
+}
+
+TEST(DispChannel, SendsBackToBackLayouts) {
+    FakeDisp disp;
+    DispChannel channel;
+    EXPECT_FALSE(channel.send_layout(1024, 768));
+
+    channel.on_connected(&disp.context);
+    EXPECT_TRUE(channel.send_layout(1025, 767));
+    EXPECT_TRUE(channel.send_layout(100, 100000));
+    ASSERT_EQ(disp.layouts.size(), 2u);
+    EXPECT_EQ(disp.layouts[0].Width, 1024u);
+    EXPECT_EQ(disp.layouts[0].Height, 766u);
+    EXPECT_EQ(disp.layouts[1].Width, static_cast<UINT32>(DISPLAY_CONTROL_MIN_MONITOR_WIDTH));
+    EXPECT_EQ(disp.layouts[1].Height, static_cast<UINT32>(DISPLAY_CONTROL_MAX_MONITOR_HEIGHT));
+}
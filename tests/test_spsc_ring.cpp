@@ -0,0 +1,93 @@
+#include "util/spsc_ring.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+
+using namespace gvrdp;
+
+TEST(SpscRingTest, EmptyRingPopsNothing) {
+    SpscRing<int, 4> ring;
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(ring.size(), 0u);
+    EXPECT_FALSE(ring.pop().has_value());
+}
+
+TEST(SpscRingTest, FirstInFirstOut) {
+    SpscRing<int, 8> ring;
+    for (int i = 0; i < 5; i++) {
+        ASSERT_TRUE(ring.push(i));
+    }
+    EXPECT_EQ(ring.size(), 5u);
+    for (int i = 0; i < 5; i++) {
+        auto value = ring.pop();
+        ASSERT_TRUE(value.has_value());
+        EXPECT_EQ(*value, i);
+    }
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpscRingTest, PushFailsWhenFullWithoutLosingItems) {
+    SpscRing<int, 4> ring;
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(ring.push(i));
+    }
+    EXPECT_FALSE(ring.push(99));
+    EXPECT_EQ(ring.size(), 4u);
+
+    // Room again after one pop
+    EXPECT_EQ(ring.pop(), 0);
+    EXPECT_TRUE(ring.push(4));
+    for (int i = 1; i <= 4; i++) {
+        EXPECT_EQ(ring.pop(), i);
+    }
+}
+
+TEST(SpscRingTest, WrapsAroundManyTimes) {
+    SpscRing<uint32_t, 4> ring;
+    uint32_t next_in = 0;
+    uint32_t next_out = 0;
+    for (int round = 0; round < 1000; round++) {
+        // Alternate between partly filling and draining
+        int count = 1 + round % 4;
+        for (int i = 0; i < count; i++) {
+            ASSERT_TRUE(ring.push(next_in++));
+        }
+        for (int i = 0; i < count; i++) {
+            auto value = ring.pop();
+            ASSERT_TRUE(value.has_value());
+            EXPECT_EQ(*value, next_out++);
+        }
+    }
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpscRingTest, KeepsOrderAcrossThreads) {
+    // Small ring, so the producer keeps hitting full and the consumer empty
+    constexpr uint32_t kCount = 200000;
+    SpscRing<uint32_t, 16> ring;
+
+    std::thread producer([&] {
+        for (uint32_t i = 0; i < kCount; i++) {
+            while (!ring.push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t expected = 0;
+    bool in_order = true;
+    while (expected < kCount) {
+        if (auto value = ring.pop()) {
+            in_order = in_order && *value == expected;
+            expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    EXPECT_TRUE(in_order);
+    EXPECT_TRUE(ring.empty());
+}
@@ -0,0 +1,107 @@
+#include "render/tile_grid.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace gvrdp;
+
+TEST(TileGrid, CountsTilesForLargeDesktops) {
+    TileGrid grid(512);
+    grid.resize(3840, 2160);
+    EXPECT_EQ(grid.columns(), 8u);
+    EXPECT_EQ(grid.rows(), 5u);
+
+    grid.resize(7680, 4320);
+    EXPECT_EQ(grid.columns(), 15u);
+    EXPECT_EQ(grid.rows(), 9u);
+    EXPECT_EQ(grid.count(), 135u);
+    EXPECT_EQ(grid.storage_size(), 514u);
+}
+
+TEST(TileGrid, EmptyDesktopHasNoTiles) {
+    TileGrid grid(512);
+    grid.resize(0, 1080);
+    EXPECT_EQ(grid.count(), 0u);
+
+    int calls = 0;
+    grid.for_each_stored(Rect{0, 0, 100, 100}, [&](uint32_t, uint32_t, const Rect&) { calls++; });
+    EXPECT_EQ(calls, 0);
+}
+
+TEST(TileGrid, LastColumnAndRowAreCutShort) {
+    TileGrid grid(512);
+    grid.resize(1920, 1080);
+    EXPECT_EQ(grid.tile_rect(0, 0), (Rect{0, 0, 512, 512}));
+    EXPECT_EQ(grid.tile_rect(3, 2), (Rect{1536, 1024, 384, 56}));
+}
+
+TEST(TileGrid, StoredRectAddsTheGutterInsideTheDesktop) {
+    TileGrid grid(512);
+    grid.resize(1920, 1080);
+    // No gutter beyond the desktop's edges
+    EXPECT_EQ(grid.stored_rect(0, 0), (Rect{0, 0, 513, 513}));
+    EXPECT_EQ(grid.stored_rect(1, 1), (Rect{511, 511, 514, 514}));
+    EXPECT_EQ(grid.stored_rect(3, 2), (Rect{1535, 1023, 385, 57}));
+}
+
+TEST(TileGrid, DamageOnATileEdgeReachesTheNeighbourGutter) {
+    TileGrid grid(512);
+    grid.resize(1920, 1080);
+
+    std::vector<Rect> parts;
+    grid.for_each_stored(Rect{511, 100, 1, 1}, [&](uint32_t column, uint32_t row,
+                                                   const Rect& part) {
+        EXPECT_EQ(row, 0u);
+        EXPECT_LE(column, 1u);
+        parts.push_back(part);
+    });
+    ASSERT_EQ(parts.size(), 2u);
+    EXPECT_EQ(parts[0], (Rect{511, 100, 1, 1}));
+    EXPECT_EQ(parts[1], (Rect{511, 100, 1, 1}));
+
+    // Damage inside a tile touches only that tile
+    int calls = 0;
+    grid.for_each_stored(Rect{600, 600, 100, 100}, [&](uint32_t, uint32_t, const Rect&) {
+        calls++;
+    });
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(TileGrid, EveryPixelIsStoredAndFitsInItsTile) {
+    TileGrid grid(64);
+    grid.resize(300, 130);
+
+    std::vector<int> covered(300 * 130, 0);
+    grid.for_each_stored(Rect{0, 0, 300, 130}, [&](uint32_t column, uint32_t row,
+                                                   const Rect& part) {
+        // Inside the tile's storage
+        int64_t x = part.x - grid.origin_x(column);
+        int64_t y = part.y - grid.origin_y(row);
+        EXPECT_GE(x, 0);
+        EXPECT_GE(y, 0);
+        EXPECT_LE(x + part.width, grid.storage_size());
+        EXPECT_LE(y + part.height, grid.storage_size());
+        for (uint32_t py = part.y; py < part.bottom(); py++) {
+            for (uint32_t px = part.x; px < part.right(); px++) {
+                covered[py * 300 + px]++;
+            }
+        }
+    });
+    for (int count : covered) {
+        EXPECT_GE(count, 1);
+    }
+    // Interior pixels of a tile are stored once
+    EXPECT_EQ(covered[10 * 300 + 10], 1);
+}
+
+TEST(TileGrid, DamageIsClippedToTheDesktop) {
+    TileGrid grid(512);
+    grid.resize(1000, 600);
+    std::vector<Rect> parts;
+    grid.for_each_stored(Rect{900, 550, 500, 500}, [&](uint32_t, uint32_t, const Rect& part) {
+        parts.push_back(part);
+    });
+    ASSERT_EQ(parts.size(), 1u);
+    EXPECT_EQ(parts[0], (Rect{900, 550, 100, 50}));
+}
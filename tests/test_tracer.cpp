@@ -0,0 +1,132 @@
+#include "util/tracer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+using namespace gvrdp;
+
+namespace {
+
+class TracerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path_ = std::filesystem::temp_directory_path() /
+                (std::string("gvrdp_trace_test_") +
+                 ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".json");
+        std::filesystem::remove(path_);
+    }
+    void TearDown() override {
+        Tracer::stop();
+        std::filesystem::remove(path_);
+    }
+
+    std::string read_trace() const {
+        std::ifstream file(path_);
+        return std::string(std::istreambuf_iterator<char>(file), {});
+    }
+
+    static size_t count(const std::string& text, const std::string& needle) {
+        size_t n = 0;
+        for (size_t pos = text.find(needle); pos != std::string::npos;
+             pos = text.find(needle, pos + 1)) {
+            n++;
+        }
+        return n;
+    }
+
+    std::filesystem::path path_;
+};
+
+}  // namespace
+
+TEST_F(TracerTest, DisabledByDefault) {
+    EXPECT_FALSE(Tracer::enabled());
+    EXPECT_FALSE(Tracer::due());
+    EXPECT_FALSE(Tracer::time_until_deadline());
+    EXPECT_FALSE(Tracer::stop());
+    { TRACE_SCOPE("ignored"); }
+}
+
+TEST_F(TracerTest, WritesCompleteEventsAndThreadNames) {
+    ASSERT_TRUE(Tracer::start(path_, std::chrono::seconds(60)));
+    EXPECT_TRUE(Tracer::enabled());
+    EXPECT_FALSE(Tracer::start(path_, std::chrono::seconds(60)));
+
+    Tracer::set_thread_name("main");
+    { TRACE_SCOPE("outer"); }
+    std::thread([] {
+        Tracer::set_thread_name("worker");
+        TRACE_SCOPE("inner");
+    }).join();
+
+    ASSERT_TRUE(Tracer::stop());
+    EXPECT_FALSE(Tracer::enabled());
+
+    std::string trace = read_trace();
+    EXPECT_EQ(trace.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0), 0u);
+    EXPECT_NE(trace.find("\"ph\":\"X\",\"pid\":1,\"tid\":"), std::string::npos);
+    EXPECT_EQ(count(trace, "\"name\":\"outer\""), 1u);
+    EXPECT_EQ(count(trace, "\"name\":\"inner\""), 1u);
+    EXPECT_EQ(count(trace, "\"args\":{\"name\":\"main\"}"), 1u);
+    EXPECT_EQ(count(trace, "\"args\":{\"name\":\"worker\"}"), 1u);
+    EXPECT_NE(trace.find("\n]}"), std::string::npos);
+}
+
+TEST_F(TracerTest, EventsAfterStopAreNotRecorded) {
+    ASSERT_TRUE(Tracer::start(path_, std::chrono::seconds(60)));
+    ASSERT_TRUE(Tracer::stop());
+    { TRACE_SCOPE("late"); }
+
+    // A new trace starts empty: nothing from before or between traces
+    ASSERT_TRUE(Tracer::start(path_, std::chrono::seconds(60)));
+    { TRACE_SCOPE("kept"); }
+    ASSERT_TRUE(Tracer::stop());
+
+    std::string trace = read_trace();
+    EXPECT_EQ(count(trace, "\"name\":\"late\""), 0u);
+    EXPECT_EQ(count(trace, "\"name\":\"kept\""), 1u);
+}
+
+TEST_F(TracerTest, RecordUsesTheGivenTimes) {
+    auto start = Tracer::Clock::now();
+    ASSERT_TRUE(Tracer::start(path_, std::chrono::seconds(60)));
+    Tracer::record("span", start + std::chrono::milliseconds(5),
+                   start + std::chrono::milliseconds(7));
+    ASSERT_TRUE(Tracer::stop());
+
+    std::string trace = read_trace();
+    auto pos = trace.find("\"name\":\"span\"");
+    ASSERT_NE(pos, std::string::npos);
+    EXPECT_NE(trace.find("\"dur\":2000.000}", pos), std::string::npos);
+}
+
+TEST_F(TracerTest, DeadlineMakesTheTraceDue) {
+    ASSERT_TRUE(Tracer::start(path_, std::chrono::milliseconds(0)));
+    EXPECT_TRUE(Tracer::due());
+    ASSERT_TRUE(Tracer::time_until_deadline());
+    EXPECT_EQ(Tracer::time_until_deadline()->count(), 0);
+    ASSERT_TRUE(Tracer::stop());
+    EXPECT_FALSE(Tracer::due());
+    EXPECT_TRUE(std::filesystem::exists(path_));
+}
+
+TEST_F(TracerTest, FullBufferDropsAndSaysSo) {
+    ASSERT_TRUE(Tracer::start(path_, std::chrono::seconds(60)));
+    std::thread([] {
+        auto now = Tracer::Clock::now();
+        for (int i = 0; i < (1 << 16) + 10; i++) {
+            Tracer::record("tick", now, now);
+        }
+    }).join();
+    ASSERT_TRUE(Tracer::stop());
+
+    std::string trace = read_trace();
+    EXPECT_EQ(count(trace, "\"name\":\"tick\""), size_t{1} << 16);
+    EXPECT_NE(trace.find("\"name\":\"10 events dropped\""), std::string::npos);
+}
@@ -0,0 +1,66 @@
+#include "core/update_stats.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace gvrdp;
+using namespace std::chrono_literals;
+
+TEST(UpdateStats, StartsEmpty) {
+    UpdateStats stats;
+    for (size_t i = 0; i < static_cast<size_t>(UpdateOrder::Count); i++) {
+        UpdateTotals totals = stats.totals(static_cast<UpdateOrder>(i));
+        EXPECT_EQ(totals.calls, 0u);
+        EXPECT_EQ(totals.pixels, 0u);
+        EXPECT_EQ(totals.time.count(), 0);
+    }
+}
+
+TEST(UpdateStats, AccumulatesPerOrder) {
+    UpdateStats stats;
+    stats.record(UpdateOrder::MemBlt, 100, 2ms);
+    stats.record(UpdateOrder::MemBlt, 50, 1ms);
+    stats.record(UpdateOrder::GlyphIndex, 400, 3ms);
+
+    UpdateTotals memblt = stats.totals(UpdateOrder::MemBlt);
+    EXPECT_EQ(memblt.calls, 2u);
+    EXPECT_EQ(memblt.pixels, 150u);
+    EXPECT_EQ(memblt.time, 3ms);
+    EXPECT_EQ(stats.totals(UpdateOrder::GlyphIndex).calls, 1u);
+    EXPECT_EQ(stats.totals(UpdateOrder::ScrBlt).calls, 0u);
+}
+
+TEST(UpdateStats, ResetClearsEverything) {
+    UpdateStats stats;
+    stats.record(UpdateOrder::CacheBitmapV2, 64, 1ms);
+    stats.reset();
+    EXPECT_EQ(stats.totals(UpdateOrder::CacheBitmapV2).calls, 0u);
+    EXPECT_EQ(stats.totals(UpdateOrder::CacheBitmapV2).pixels, 0u);
+}
+
+TEST(UpdateStats, IgnoresOutOfRangeOrder) {
+    UpdateStats stats;
+    stats.record(UpdateOrder::Count, 1, 1ms);
+    EXPECT_EQ(stats.totals(UpdateOrder::Count).calls, 0u);
+}
+
+TEST(UpdateStats, ReportListsCalledOrdersByTime) {
+    UpdateStats stats;
+    stats.record(UpdateOrder::OpaqueRect, 10, 1ms);
+    stats.record(UpdateOrder::GlyphIndex, 10, 5ms);
+    std::string report = stats.report();
+
+    size_t glyph = report.find("GlyphIndex");
+    size_t rect = report.find("OpaqueRect");
+    ASSERT_NE(glyph, std::string::npos);
+    ASSERT_NE(rect, std::string::npos);
+    EXPECT_LT(glyph, rect);
+    EXPECT_EQ(report.find("MemBlt"), std::string::npos);
+}
+
+TEST(UpdateStats, EveryOrderHasAName) {
+    for (size_t i = 0; i < static_cast<size_t>(UpdateOrder::Count); i++) {
+        EXPECT_STRNE(update_order_name(static_cast<UpdateOrder>(i)), "Unknown");
+    }
+}
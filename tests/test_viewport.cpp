@@ -0,0 +1,136 @@
+#include "render/viewport.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace gvrdp;
+
+namespace {
+
+struct Point {
+    uint16_t x = 0;
+    uint16_t y = 0;
+};
+
+Point map(const Viewport& viewport, int x, int y) {
+    Point p;
+    viewport.to_desktop(x, y, p.x, p.y);
+    return p;
+}
+
+}  // namespace
+
+TEST(Viewport, MatchingWindowIsDrawnNatively) {
+    Viewport v = Viewport::fit(1920, 1080, 1920, 1080);
+    EXPECT_EQ(v, Viewport::native(1920, 1080));
+    EXPECT_FALSE(v.scaled());
+
+    // Layouts are even: a 1921 px window got a 1920 px desktop
+    EXPECT_FALSE(Viewport::fit(1920, 1080, 1921, 1081).scaled());
+}
+
+TEST(Viewport, DragPreviewStretchesToTheWindow) {
+    // Window dragged wider and shorter before the server has resized
+    Viewport v = Viewport::fit(1000, 800, 1500, 600);
+    EXPECT_TRUE(v.scaled());
+    EXPECT_EQ(v.x, 0);
+    EXPECT_EQ(v.y, 0);
+    EXPECT_EQ(v.width, 1500);
+    EXPECT_EQ(v.height, 600);
+}
+
+TEST(Viewport, NativeMapsOneToOne) {
+    Viewport v = Viewport::native(1024, 768);
+    Point p = map(v, 100, 200);
+    EXPECT_EQ(p.x, 100);
+    EXPECT_EQ(p.y, 200);
+}
+
+TEST(Viewport, PointerFollowsTheStretch) {
+    Viewport v = Viewport::stretched(1000, 800, 2000, 400);
+    Point p = map(v, 1000, 200);  // Window centre
+    EXPECT_EQ(p.x, 500);
+    EXPECT_EQ(p.y, 400);
+
+    p = map(v, 1999, 399);  // Last window pixel, which covers two desktop rows
+    EXPECT_EQ(p.x, 999);
+    EXPECT_EQ(p.y, 798);
+}
+
+TEST(Viewport, PointerIsClampedToTheDesktop) {
+    Viewport v = Viewport::native(800, 600);
+    Point p = map(v, -20, -5);
+    EXPECT_EQ(p.x, 0);
+    EXPECT_EQ(p.y, 0);
+
+    // The window is still larger than the desktop it is waiting for
+    p = map(v, 900, 700);
+    EXPECT_EQ(p.x, 799);
+    EXPECT_EQ(p.y, 599);
+}
+
+TEST(Viewport, EmptyViewportPassesWindowPixelsThrough) {
+    Viewport v;
+    EXPECT_TRUE(v.empty());
+    Point p = map(v, 300, 40);
+    EXPECT_EQ(p.x, 300);
+    EXPECT_EQ(p.y, 40);
+}
+
+TEST(Viewport, WindowRectCoversTheDesktopPixelsUnderIt) {
+    Viewport v = Viewport::stretched(1000, 1000, 300, 300);
+    // 100 window pixels are 333.3 desktop pixels; partial pixels count
+    EXPECT_EQ(v.to_desktop(0, 0, 100, 100), (Rect{0, 0, 334, 334}));
+    EXPECT_EQ(v.to_desktop(0, 0, 300, 300), (Rect{0, 0, 1000, 1000}));
+
+    // Parts outside the desktop are dropped
+    EXPECT_EQ(v.to_desktop(-50, 250, 100, 100), (Rect{0, 833, 167, 167}));
+    EXPECT_TRUE(v.to_desktop(400, 0, 10, 10).empty());
+}
+
+TEST(Viewport, LetterboxKeepsTheAspectRatio) {
+    // 16:9 desktop in a 4:3 window: bars above and below
+    Viewport v = Viewport::letterboxed(1920, 1080, 1024, 768);
+    EXPECT_EQ(v.x, 0);
+    EXPECT_EQ(v.width, 1024);
+    EXPECT_EQ(v.height, 576);
+    EXPECT_EQ(v.y, 96);
+
+    // ... and left and right in a tall window
+    v = Viewport::letterboxed(1920, 1080, 1920, 2160);
+    EXPECT_EQ(v.width, 1920);
+    EXPECT_EQ(v.height, 1080);
+    EXPECT_EQ(v.y, 540);
+    EXPECT_FALSE(v.scaled());
+
+    v = Viewport::letterboxed(1000, 1000, 1600, 800);
+    EXPECT_EQ(v.x, 400);
+    EXPECT_EQ(v.y, 0);
+    EXPECT_EQ(v.width, 800);
+    EXPECT_EQ(v.height, 800);
+}
+
+TEST(Viewport, LetterboxMapsThePointerToRemoteSpace) {
+    Viewport v = Viewport::letterboxed(1000, 1000, 1600, 800);
+    Point p = map(v, 800, 400);  // Window centre is the desktop centre
+    EXPECT_EQ(p.x, 500);
+    EXPECT_EQ(p.y, 500);
+
+    // Over the bars the pointer stays on the nearest desktop edge
+    p = map(v, 100, 400);
+    EXPECT_EQ(p.x, 0);
+    EXPECT_EQ(p.y, 500);
+    p = map(v, 1500, 0);
+    EXPECT_EQ(p.x, 999);
+    EXPECT_EQ(p.y, 0);
+
+    // Remote coordinates beyond what fits in a window pixel
+    v = Viewport::letterboxed(7680, 4320, 1920, 1080);
+    p = map(v, 1919, 1079);
+    EXPECT_EQ(p.x, 7676);
+    EXPECT_EQ(p.y, 4316);
+}
+
+TEST(Viewport, LetterboxOfAnEmptyWindowIsEmpty) {
+    EXPECT_TRUE(Viewport::letterboxed(1920, 1080, 0, 0).empty());
+    EXPECT_TRUE(Viewport::letterboxed(0, 0, 800, 600).empty());
+}
@@ -0,0 +1,74 @@
+#include "util/worker_pool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+using namespace gvrdp;
+
+TEST(WorkerPool, RunsEveryJob) {
+    WorkerPool pool(4);
+    std::atomic<int> count{0};
+    for (int i = 0; i < 1000; i++) {
+        pool.submit([&] { count++; });
+    }
+    pool.wait_idle();
+    EXPECT_EQ(count.load(), 1000);
+}
+
+TEST(WorkerPool, WaitIdleOnEmptyPoolReturns) {
+    WorkerPool pool(2);
+    pool.wait_idle();
+    EXPECT_EQ(pool.size(), 2u);
+}
+
+TEST(WorkerPool, ZeroThreadsPicksAtLeastOne) {
+    WorkerPool pool(0);
+    EXPECT_GE(pool.size(), 1u);
+}
+
+TEST(WorkerPool, RunsJobsConcurrently) {
+    WorkerPool pool(2);
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+    for (int i = 0; i < 2; i++) {
+        pool.submit([&] {
+            int now = ++running;
+            int expected = peak.load();
+            while (now > expected && !peak.compare_exchange_weak(expected, now)) {}
+            // Give the other job time to start
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+            while (peak.load() < 2 && std::chrono::steady_clock::now() < deadline) {}
+            running--;
+        });
+    }
+    pool.wait_idle();
+    EXPECT_EQ(peak.load(), 2);
+}
+
+TEST(WorkerPool, OrderedCommitAfterWaitIdle) {
+    // The pattern GfxPipeline uses: results land in submission-ordered
+    // slots, and are only read after wait_idle()
+    WorkerPool pool(3, 4);
+    std::vector<int> results(200, -1);
+    for (int i = 0; i < 200; i++) {
+        pool.submit([&results, i] { results[static_cast<size_t>(i)] = i * 2; });
+    }
+    pool.wait_idle();
+    for (int i = 0; i < 200; i++) {
+        EXPECT_EQ(results[static_cast<size_t>(i)], i * 2);
+    }
+}
+
+TEST(WorkerPool, DestructorFinishesQueuedJobs) {
+    std::atomic<int> count{0};
+    {
+        WorkerPool pool(1, 100);
+        for (int i = 0; i < 50; i++) {
+            pool.submit([&] { count++; });
+        }
+    }
+    EXPECT_EQ(count.load(), 50);
+}
@@ -0,0 +1,109 @@
+// Prints a flight recorder file as text, oldest event first.
+//
+//   gvrdp_flight <file.gfr>
+//
+// Works on the live ring (flight/recorder.gfr under the config directory),
+// a ring kept after a crash, and dumps written on errors and disconnects.
+
+#include "util/flight_recorder.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <ctime>
+
+using namespace gvrdp;
+
+namespace {
+
+const char* input_type_name(uint32_t type) {
+    // InputEvent::Type, in declaration order
+    switch (type) {
+        case 0: return "keyboard";
+        case 1: return "mouse";
+        case 2: return "extended_mouse";
+        case 3: return "visible_area";
+    }
+    return "?";
+}
+
+const char* dump_reason_name(uint32_t reason) {
+    switch (static_cast<DumpReason>(reason)) {
+        case DumpReason::Error: return "error";
+        case DumpReason::Disconnect: return "disconnect";
+    }
+    return "?";
+}
+
+void print_details(const FlightRecord& record) {
+    switch (static_cast<FlightEvent>(record.type)) {
+        case FlightEvent::SessionStart:
+            std::printf("port=%" PRIu32, record.a);
+            break;
+        case FlightEvent::Disconnected:
+            std::printf("%s freerdp_error=0x%08" PRIX64, record.a ? "local" : "remote", record.b);
+            break;
+        case FlightEvent::Error:
+            std::printf("rdp_error=%" PRIu32 " freerdp_error=0x%08" PRIX64, record.a, record.b);
+            break;
+        case FlightEvent::RdpWake:
+            std::printf("waited=%" PRIu32 "us", record.a);
+            break;
+        case FlightEvent::FrameReady:
+            std::printf("damage=%" PRIu64 "px", record.b);
+            break;
+        case FlightEvent::GfxFrame:
+            std::printf("frame=%" PRIu32 " decode=%" PRIu64 "us", record.a, record.b);
+            break;
+        case FlightEvent::Present:
+            std::printf("took=%" PRIu32 "us interval=%" PRIu64 "us", record.a, record.b);
+            break;
+        case FlightEvent::InputSent:
+            std::printf("%s code=%" PRIu64 " flags=0x%04" PRIX64, input_type_name(record.a),
+                        record.b >> 32, record.b & 0xFFFFFFFF);
+            break;
+        case FlightEvent::ChannelConnected:
+        case FlightEvent::ChannelDisconnected:
+            std::printf("%s", FlightRecorder::unpack_name(record.b).c_str());
+            break;
+        case FlightEvent::ResizeRequest:
+            std::printf("%" PRIu32 "x%" PRIu64, record.a, record.b);
+            break;
+        case FlightEvent::Dump:
+            std::printf("reason=%s", dump_reason_name(record.a));
+            break;
+        default:
+            break;
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s <file.gfr>\n", argv[0]);
+        return 2;
+    }
+    auto recording = FlightRecorder::read(argv[1]);
+    if (!recording) {
+        std::fprintf(stderr, "%s: not a flight recorder file\n", argv[1]);
+        return 1;
+    }
+
+    std::time_t started = static_cast<std::time_t>(recording->started_unix_ns / 1000000000);
+    char when[64] = "?";
+    if (std::tm* local = std::localtime(&started)) {
+        std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", local);
+    }
+    std::printf("# started %s, %zu events (ring of %" PRIu64 ")%s\n", when,
+                recording->records.size(), recording->capacity,
+                recording->closed ? "" : ", never closed: the process crashed or was killed");
+
+    for (const FlightRecord& record : recording->records) {
+        std::printf("%14.6f  t%-3u %-20s ", static_cast<double>(record.time_ns) / 1e9,
+                    static_cast<unsigned>(record.thread),
+                    flight_event_name(static_cast<FlightEvent>(record.type)));
+        print_details(record);
+        std::printf("\n");
+    }
+    return 0;
+}